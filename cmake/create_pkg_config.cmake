@@ -72,8 +72,8 @@ if(PCAP_INCLUDE_DIR)
     set(PCAP_CPPFLAGS "-I${PCAP_INCLUDE_DIR}")
 endif()
 
-if(PCRE_INCLUDE_DIR)
-    set(PCRE_CPPFLAGS "-I${PCRE_INCLUDE_DIR}")
+if(PCRE2_INCLUDE_DIR)
+    set(PCRE2_CPPFLAGS "-I${PCRE2_INCLUDE_DIR}")
 endif()
 
 if(UUID_INCLUDE_DIR)
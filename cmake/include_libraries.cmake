@@ -8,7 +8,7 @@ find_package(HWLOC REQUIRED)
 find_package(LuaJIT REQUIRED)
 find_package(OpenSSL REQUIRED)
 find_package(PCAP REQUIRED)
-find_package(PCRE REQUIRED)
+find_package(PCRE2 REQUIRED)
 find_package(ZLIB REQUIRED)
 if (ENABLE_UNIT_TESTS)
     find_package(CppUTest REQUIRED)
@@ -131,8 +131,8 @@ public:
 
 private:
     bool valid_checksum_from_daq(const RawData&);
-    bool valid_checksum4(const RawData&, DecodeData&);
-    bool valid_checksum6(const RawData&, const CodecData&, DecodeData&);
+    bool valid_checksum4(const RawData&, CodecData&, DecodeData&);
+    bool valid_checksum6(const RawData&, CodecData&, DecodeData&);
 
     int validate_option(const tcp::TcpOption* const opt,
         const uint8_t* const end, const int expected_len);
@@ -168,7 +168,7 @@ inline bool TcpCodec::valid_checksum_from_daq(const RawData& raw)
     return true;
 }
 
-bool TcpCodec::valid_checksum4(const RawData& raw, DecodeData& snort)
+bool TcpCodec::valid_checksum4(const RawData& raw, CodecData& codec, DecodeData& snort)
 {
     const ip::IP4Hdr* ip4h = snort.ip_api.get_ip4h();
 
@@ -179,10 +179,15 @@ bool TcpCodec::valid_checksum4(const RawData& raw, DecodeData& snort)
     ph.hdr.protocol = ip4h->proto();
     ph.hdr.len = htons((uint16_t) raw.len);
 
-    return (checksum::tcp_cksum((const uint16_t*) raw.data, raw.len, ph) == 0);
+    uint32_t sum = checksum::pseudo_sum(ph);
+
+    if ( codec.defer_checksum(raw, sum, DECODE_ERR_CKSUM_TCP) )
+        return true;
+
+    return (checksum::l4_cksum((const uint16_t*) raw.data, raw.len, sum) == 0);
 }
 
-bool TcpCodec::valid_checksum6(const RawData& raw, const CodecData& codec, DecodeData& snort)
+bool TcpCodec::valid_checksum6(const RawData& raw, CodecData& codec, DecodeData& snort)
 {
     const ip::IP6Hdr* const ip6h = snort.ip_api.get_ip6h();
 
@@ -193,7 +198,12 @@ bool TcpCodec::valid_checksum6(const RawData& raw, const CodecData& codec, Decod
     ph6.hdr.protocol = codec.ip6_csum_proto;
     ph6.hdr.len = htons((uint16_t) raw.len);
 
-    return (checksum::tcp_cksum((const uint16_t*) raw.data, raw.len, ph6) == 0);
+    uint32_t sum = checksum::pseudo_sum(ph6);
+
+    if ( codec.defer_checksum(raw, sum, DECODE_ERR_CKSUM_TCP) )
+        return true;
+
+    return (checksum::l4_cksum((const uint16_t*) raw.data, raw.len, sum) == 0);
 }
 
 bool TcpCodec::decode(const RawData& raw, CodecData& codec, DecodeData& snort)
@@ -226,7 +236,7 @@ bool TcpCodec::decode(const RawData& raw, CodecData& codec, DecodeData& snort)
 
         if (snort.ip_api.is_ip4())
         {
-            valid = valid_checksum4(raw, snort);
+            valid = valid_checksum4(raw, codec, snort);
             bad_cksum_cnt = &stats.bad_ip4_cksum;
         }
         else
@@ -252,8 +252,8 @@ public:
 private:
 
     bool valid_checksum_from_daq(const RawData&);
-    bool valid_checksum4(const RawData&, const DecodeData&);
-    bool valid_checksum6(const RawData&, const CodecData&, const DecodeData&);
+    bool valid_checksum4(const RawData&, CodecData&, const DecodeData&);
+    bool valid_checksum6(const RawData&, CodecData&, const DecodeData&);
 
     void UDPMiscTests(const DecodeData&, const CodecData&, uint32_t pay_len);
     UdpCodecConfig* config;
@@ -277,7 +277,7 @@ inline bool UdpCodec::valid_checksum_from_daq(const RawData& raw)
     return true;
 }
 
-bool UdpCodec::valid_checksum4(const RawData& raw, const DecodeData& snort)
+bool UdpCodec::valid_checksum4(const RawData& raw, CodecData& codec, const DecodeData& snort)
 {
     const ip::IP4Hdr* const ip4h = snort.ip_api.get_ip4h();
 
@@ -288,10 +288,15 @@ bool UdpCodec::valid_checksum4(const RawData& raw, const DecodeData& snort)
     ph.hdr.protocol = ip4h->proto();
     ph.hdr.len = htons((uint16_t) raw.len);
 
-    return (checksum::udp_cksum((const uint16_t*) raw.data, raw.len, ph) == 0);
+    uint32_t sum = checksum::pseudo_sum(ph);
+
+    if ( codec.defer_checksum(raw, sum, DECODE_ERR_CKSUM_UDP) )
+        return true;
+
+    return (checksum::l4_cksum((const uint16_t*) raw.data, raw.len, sum) == 0);
 }
 
-bool UdpCodec::valid_checksum6(const RawData& raw, const CodecData& codec, const DecodeData& snort)
+bool UdpCodec::valid_checksum6(const RawData& raw, CodecData& codec, const DecodeData& snort)
 {
     const ip::IP6Hdr* const ip6h = snort.ip_api.get_ip6h();
 
@@ -302,7 +307,12 @@ bool UdpCodec::valid_checksum6(const RawData& raw, const CodecData& codec, const
     ph6.hdr.protocol = codec.ip6_csum_proto;
     ph6.hdr.len = htons((uint16_t) raw.len);
 
-    return (checksum::udp_cksum((const uint16_t*) raw.data, raw.len, ph6) == 0);
+    uint32_t sum = checksum::pseudo_sum(ph6);
+
+    if ( codec.defer_checksum(raw, sum, DECODE_ERR_CKSUM_UDP) )
+        return true;
+
+    return (checksum::l4_cksum((const uint16_t*) raw.data, raw.len, sum) == 0);
 }
 
 void UdpCodec::get_protocol_ids(std::vector<ProtocolId>& v)
@@ -377,7 +387,7 @@ bool UdpCodec::decode(const RawData& raw, CodecData& codec, DecodeData& snort)
              * 2) UDP header chksum value is 0.
              */
             if (!fragmented_udp_flag && udph->uh_chk)
-                valid = valid_checksum4(raw, snort);
+                valid = valid_checksum4(raw, codec, snort);
             else
                 valid = true;
             bad_cksum_cnt = &stats.bad_ip4_cksum;
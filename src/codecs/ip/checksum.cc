@@ -0,0 +1,245 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// checksum.cc - internet checksum kernels
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "checksum.h"
+
+#include <cstring>
+
+#include "main/thread.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CKSUM_X86_SIMD
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define CKSUM_NEON
+#endif
+
+using namespace checksum;
+
+// the kernels return a wide sum and leave the folding to the caller.
+// since 2^16 == 1 mod 2^16 - 1, adding 32 bit words into a 64 bit sum
+// gives the same one's complement sum as adding 16 bit words, and none of
+// it depends on byte order or alignment.
+
+static THREAD_LOCAL uint64_t s_eval_bytes = 0;
+
+//-------------------------------------------------------------------------
+// scalar
+//-------------------------------------------------------------------------
+
+static uint64_t sum_scalar(const uint8_t* buf, std::size_t len)
+{
+    uint64_t sum = 0;
+
+    while ( len >= 8 )
+    {
+        uint64_t w;
+        memcpy(&w, buf, sizeof(w));
+        sum += (w & 0xffffffff) + (w >> 32);
+        buf += 8;
+        len -= 8;
+    }
+    while ( len > 1 )
+    {
+        uint16_t w;
+        memcpy(&w, buf, sizeof(w));
+        sum += w;
+        buf += 2;
+        len -= 2;
+    }
+    // same as the original loop: the odd byte is added as is
+    if ( len )
+        sum += *buf;
+
+    return sum;
+}
+
+//-------------------------------------------------------------------------
+// vector
+//-------------------------------------------------------------------------
+
+#ifdef CKSUM_X86_SIMD
+// the x86 kernels split each 32 bit lane into its 16 bit halves and add
+// those into 32 bit lanes.  each block adds at most 2 * 0xffff to each lane
+// of a and b, and a + b is taken when spilling to the 64 bit sum, so after
+// n blocks a lane holds at most 4 * 0xffff * n.  that fits 32 bits for n up
+// to 0x4000.
+static constexpr std::size_t max_blocks = 0x4000;
+
+static_assert(4 * 0xffffull * max_blocks <= 0xffffffffull, "checksum lanes can overflow");
+
+static uint64_t sum_sse2(const uint8_t* buf, std::size_t len)
+{
+    const __m128i mask = _mm_set1_epi32(0xffff);
+    uint64_t sum = 0;
+
+    while ( len >= 32 )
+    {
+        __m128i a = _mm_setzero_si128();
+        __m128i b = _mm_setzero_si128();
+        std::size_t n = 0;
+
+        for ( ; len >= 32 and n < max_blocks; buf += 32, len -= 32, ++n )
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*)buf);
+            __m128i w = _mm_loadu_si128((const __m128i*)(buf + 16));
+
+            a = _mm_add_epi32(a, _mm_and_si128(v, mask));
+            b = _mm_add_epi32(b, _mm_srli_epi32(v, 16));
+            a = _mm_add_epi32(a, _mm_and_si128(w, mask));
+            b = _mm_add_epi32(b, _mm_srli_epi32(w, 16));
+        }
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, _mm_add_epi32(a, b));
+        sum += (uint64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return sum + sum_scalar(buf, len);
+}
+
+__attribute__((target("avx2")))
+static uint64_t sum_avx2(const uint8_t* buf, std::size_t len)
+{
+    const __m256i mask = _mm256_set1_epi32(0xffff);
+    uint64_t sum = 0;
+
+    while ( len >= 64 )
+    {
+        __m256i a = _mm256_setzero_si256();
+        __m256i b = _mm256_setzero_si256();
+        std::size_t n = 0;
+
+        for ( ; len >= 64 and n < max_blocks; buf += 64, len -= 64, ++n )
+        {
+            __m256i v = _mm256_loadu_si256((const __m256i*)buf);
+            __m256i w = _mm256_loadu_si256((const __m256i*)(buf + 32));
+
+            a = _mm256_add_epi32(a, _mm256_and_si256(v, mask));
+            b = _mm256_add_epi32(b, _mm256_srli_epi32(v, 16));
+            a = _mm256_add_epi32(a, _mm256_and_si256(w, mask));
+            b = _mm256_add_epi32(b, _mm256_srli_epi32(w, 16));
+        }
+        uint32_t lanes[8];
+        _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi32(a, b));
+
+        for ( auto l : lanes )
+            sum += l;
+    }
+    return sum + sum_sse2(buf, len);
+}
+#endif
+
+#ifdef CKSUM_NEON
+static uint64_t sum_neon(const uint8_t* buf, std::size_t len)
+{
+    uint64x2_t a = vdupq_n_u64(0);
+    uint64x2_t b = vdupq_n_u64(0);
+
+    for ( ; len >= 32; buf += 32, len -= 32 )
+    {
+        a = vpadalq_u32(a, vreinterpretq_u32_u8(vld1q_u8(buf)));
+        b = vpadalq_u32(b, vreinterpretq_u32_u8(vld1q_u8(buf + 16)));
+    }
+    return vaddvq_u64(vaddq_u64(a, b)) + sum_scalar(buf, len);
+}
+#endif
+
+//-------------------------------------------------------------------------
+// selection
+//-------------------------------------------------------------------------
+
+using SumFunc = uint64_t (*)(const uint8_t*, std::size_t);
+
+static SumFunc get_func(Kernel k)
+{
+    switch ( k )
+    {
+    case Kernel::SCALAR:
+        return sum_scalar;
+
+#ifdef CKSUM_X86_SIMD
+    case Kernel::SSE2:
+        return __builtin_cpu_supports("sse2") ? sum_sse2 : nullptr;
+
+    case Kernel::AVX2:
+        return __builtin_cpu_supports("avx2") ? sum_avx2 : nullptr;
+#endif
+
+#ifdef CKSUM_NEON
+    case Kernel::NEON:
+        return sum_neon;
+#endif
+
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+static uint64_t sum_select(const uint8_t*, std::size_t);
+
+// codecs may checksum before main so the first call picks the kernel
+static SumFunc s_sum = sum_select;
+
+static uint64_t sum_select(const uint8_t* buf, std::size_t len)
+{
+    const Kernel best[] = { Kernel::AVX2, Kernel::SSE2, Kernel::NEON, Kernel::SCALAR };
+
+    for ( auto k : best )
+        if ( set_kernel(k) )
+            break;
+
+    return s_sum(buf, len);
+}
+
+namespace checksum
+{
+bool set_kernel(Kernel k)
+{
+    SumFunc f = get_func(k);
+
+    if ( !f )
+        return false;
+
+    s_sum = f;
+    return true;
+}
+
+uint64_t take_eval_bytes()
+{
+    uint64_t n = s_eval_bytes;
+    s_eval_bytes = 0;
+    return n;
+}
+
+namespace detail
+{
+uint64_t ones_sum(const uint16_t* buf, std::size_t len)
+{
+    s_eval_bytes += len;
+    return s_sum((const uint8_t*)buf, len);
+}
+}
+}
+
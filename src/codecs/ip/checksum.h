@@ -21,9 +21,12 @@
 #define CODECS_CHECKSUM_H
 
 #include <cstddef>
+#include <cstdint>
 
 #include <protocols/protocol_ids.h>
 
+#include "main/snort_types.h"
+
 namespace checksum
 {
 union Pseudoheader
@@ -64,13 +67,31 @@ inline uint16_t icmp_cksum(const uint16_t* buf, std::size_t len, const Pseudohea
 inline uint16_t icmp_cksum(const uint16_t* buf, std::size_t len);
 inline uint16_t ip_cksum(const uint16_t* buf, std::size_t len);
 
+// the pseudoheader sum is taken at decode so the tcp or udp checksum can
+// be evaluated later without the ip header at hand
+inline uint32_t pseudo_sum(const Pseudoheader&);
+inline uint32_t pseudo_sum(const Pseudoheader6&);
+inline uint16_t l4_cksum(const uint16_t* buf, std::size_t len, uint32_t ph_sum);
+
+// RFC 1624 incremental update of a checksum when a field changes from old
+// to new.  all values are as found in the packet (network order).
+inline uint16_t cksum_update(uint16_t cksum, uint16_t old_val, uint16_t new_val);
+inline uint16_t cksum_update32(uint16_t cksum, uint32_t old_val, uint32_t new_val);
+
+// the summing kernel is selected by cpu feature on first use
+enum class Kernel { SCALAR, SSE2, AVX2, NEON };
+
+// returns false if the kernel is not supported here
+SO_PUBLIC bool set_kernel(Kernel);
+
+// bytes summed by this thread since the last call
+SO_PUBLIC uint64_t take_eval_bytes();
+
 /*
- *  NOTE: Since multiple dynamic libraries use checksums, the choice
- *          is to either include all of the checksum details in a header,
- *          or ensure I include these symbols for every linker which
- *          can be used. Obviously, setting correct linker flags is
- *          significantly more difficult, so these functions will all
- *          stay in a header file
+ *  NOTE: Since multiple dynamic libraries use checksums, the wrappers
+ *          stay in this header.  The summing kernels are in checksum.cc
+ *          which is always built into the binary and exported so they
+ *          can be dispatched by cpu feature.
  */
 
 /*
@@ -79,94 +100,21 @@ inline uint16_t ip_cksum(const uint16_t* buf, std::size_t len);
  */
 namespace detail
 {
-inline uint16_t cksum_add(const uint16_t* buf, std::size_t len, uint32_t cksum)
+// one's complement sum of the buffer, not folded
+SO_PUBLIC uint64_t ones_sum(const uint16_t* buf, std::size_t len);
+
+inline uint16_t fold(uint64_t sum)
 {
-    const uint16_t* sp = buf;
+    sum = (sum >> 32) + (sum & 0xffffffff);
+    sum = (sum >> 32) + (sum & 0xffffffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    sum = (sum >> 16) + (sum & 0xffff);
+    return (uint16_t)sum;
+}
 
-    // if pointer is 16 bit aligned calculate checksum in tight loop...
-    // gcc 5.4 -O3 generates unaligned quadword instructions that crash; fixed in gcc 8.0.1
-    if ( !( reinterpret_cast<std::uintptr_t>(sp) & 0x01 ) )
-    {
-        while ( len > 1 )
-        {
-            cksum += *sp++;
-            len -= 2;
-        }
-    }
-    else if ( len > 1 )
-    {
-        std::size_t sn = ((len / 2) & 0xF);  // == len/2 % 16
-        std::size_t n = (((len / 2) + 15) / 16);   // ceiling of (len / 2) / 16
-
-        switch (sn)
-        {
-        case 0:
-            sn = 16;
-            cksum += sp[15];    // fallthrough
-        case 15:
-            cksum += sp[14];    // fallthrough
-        case 14:
-            cksum += sp[13];    // fallthrough
-        case 13:
-            cksum += sp[12];    // fallthrough
-        case 12:
-            cksum += sp[11];    // fallthrough
-        case 11:
-            cksum += sp[10];    // fallthrough
-        case 10:
-            cksum += sp[9];     // fallthrough
-        case 9:
-            cksum += sp[8];     // fallthrough
-        case 8:
-            cksum  += sp[7];    // fallthrough
-        case 7:
-            cksum += sp[6];     // fallthrough
-        case 6:
-            cksum += sp[5];     // fallthrough
-        case 5:
-            cksum += sp[4];     // fallthrough
-        case 4:
-            cksum += sp[3];     // fallthrough
-        case 3:
-            cksum += sp[2];     // fallthrough
-        case 2:
-            cksum += sp[1];     // fallthrough
-        case 1:
-            cksum += sp[0];
-        }
-        sp += sn;
-
-        /* unroll loop using Duff's device. */
-        while (--n > 0)
-        {
-            cksum += sp[0];
-            cksum += sp[1];
-            cksum += sp[2];
-            cksum += sp[3];
-            cksum += sp[4];
-            cksum += sp[5];
-            cksum += sp[6];
-            cksum += sp[7];
-            cksum += sp[8];
-            cksum += sp[9];
-            cksum += sp[10];
-            cksum += sp[11];
-            cksum += sp[12];
-            cksum += sp[13];
-            cksum += sp[14];
-            cksum += sp[15];
-            sp += 16;
-        }
-    }
-
-    // if len is odd, sum in the last byte...
-    if ( len & 0x01 )
-        cksum += *((const uint8_t*) sp);
-
-    cksum  = (cksum >> 16) + (cksum & 0x0000ffff);
-    cksum += (cksum >> 16);
-
-    return (uint16_t)(~cksum);
+inline uint16_t cksum_add(const uint16_t* buf, std::size_t len, uint32_t cksum)
+{
+    return (uint16_t)~fold(ones_sum(buf, len) + cksum);
 }
 
 inline void add_ipv4_pseudoheader(const Pseudoheader& ph4, uint32_t& cksum)
@@ -328,6 +276,41 @@ inline uint16_t ip_cksum(const uint16_t* buf, std::size_t len)
 
 inline uint16_t cksum_add(const uint16_t* buf, std::size_t len)
 { return detail::cksum_add(buf, len, 0); }
+
+inline uint32_t pseudo_sum(const Pseudoheader& ph)
+{
+    uint32_t cksum = 0;
+    detail::add_ipv4_pseudoheader(ph, cksum);
+    return cksum;
+}
+
+inline uint32_t pseudo_sum(const Pseudoheader6& ph)
+{
+    uint32_t cksum = 0;
+    detail::add_ipv6_pseudoheader(ph, cksum);
+    return cksum;
+}
+
+inline uint16_t l4_cksum(const uint16_t* buf, std::size_t len, uint32_t ph_sum)
+{ return detail::cksum_add(buf, len, ph_sum); }
+
+inline uint16_t cksum_update(uint16_t cksum, uint16_t old_val, uint16_t new_val)
+{
+    uint32_t sum = (uint16_t)~cksum;
+    sum += (uint16_t)~old_val;
+    sum += new_val;
+    return (uint16_t)~detail::fold(sum);
+}
+
+inline uint16_t cksum_update32(uint16_t cksum, uint32_t old_val, uint32_t new_val)
+{
+    uint32_t sum = (uint16_t)~cksum;
+    sum += (uint16_t)~(old_val >> 16);
+    sum += (uint16_t)~old_val;
+    sum += new_val >> 16;
+    sum += new_val & 0xffff;
+    return (uint16_t)~detail::fold(sum);
+}
 } // namespace checksum
 
 #endif  /* CODECS_CHECKSUM_H */
@@ -0,0 +1,226 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// checksum_test.cc - internet checksum kernel checks and benchmarks
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/catch.hpp"
+
+#include <arpa/inet.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "codecs/ip/checksum.h"
+
+using namespace checksum;
+
+static const Kernel kernels[] = { Kernel::SCALAR, Kernel::SSE2, Kernel::AVX2, Kernel::NEON };
+
+// RFC 1071 reference
+static uint16_t reference(const uint8_t* buf, size_t len)
+{
+    uint32_t sum = 0;
+
+    for ( ; len > 1; buf += 2, len -= 2 )
+    {
+        uint16_t w;
+        memcpy(&w, buf, sizeof(w));
+        sum += w;
+    }
+    if ( len )
+        sum += *buf;
+
+    while ( sum >> 16 )
+        sum = (sum & 0xffff) + (sum >> 16);
+
+    return (uint16_t)~sum;
+}
+
+TEST_CASE("checksum kernels", "[checksum]")
+{
+    std::mt19937 gen(1071);
+    std::uniform_int_distribution<unsigned> byte(0, 255);
+    std::vector<uint8_t> buf(9001);
+
+    for ( auto& b : buf )
+        b = byte(gen);
+
+    for ( auto k : kernels )
+    {
+        if ( !set_kernel(k) )
+            continue;
+
+        // odd offsets check unaligned loads
+        for ( size_t off = 0; off < 4; ++off )
+        {
+            for ( size_t len : { 0, 1, 2, 3, 7, 8, 15, 20, 31, 33, 63, 64, 65, 1500, 8997 } )
+            {
+                const uint8_t* p = buf.data() + off;
+                CHECK(cksum_add((const uint16_t*)p, len) == reference(p, len));
+            }
+        }
+    }
+    set_kernel(Kernel::SCALAR);
+}
+
+TEST_CASE("checksum all ones", "[checksum]")
+{
+    std::vector<uint8_t> buf(65535, 0xff);
+
+    for ( auto k : kernels )
+    {
+        if ( !set_kernel(k) )
+            continue;
+
+        CHECK(cksum_add((const uint16_t*)buf.data(), buf.size()) ==
+            reference(buf.data(), buf.size()));
+    }
+    set_kernel(Kernel::SCALAR);
+}
+
+TEST_CASE("checksum lane spill", "[checksum]")
+{
+    // enough all ones blocks to overflow the lanes if they weren't spilled
+    std::vector<uint8_t> buf(0x4000 * 64 * 2 + 64, 0xff);
+
+    set_kernel(Kernel::SCALAR);
+    uint16_t expected = cksum_add((const uint16_t*)buf.data(), buf.size());
+
+    for ( auto k : kernels )
+    {
+        if ( !set_kernel(k) )
+            continue;
+
+        CHECK(cksum_add((const uint16_t*)buf.data(), buf.size()) == expected);
+    }
+    set_kernel(Kernel::SCALAR);
+}
+
+TEST_CASE("checksum eval bytes", "[checksum]")
+{
+    uint8_t buf[20] = { };
+
+    take_eval_bytes();
+    cksum_add((const uint16_t*)buf, sizeof(buf));
+    ip_cksum((const uint16_t*)buf, sizeof(buf));
+
+    // ip_cksum adds the fixed header directly
+    CHECK(take_eval_bytes() == 20);
+    CHECK(take_eval_bytes() == 0);
+}
+
+TEST_CASE("checksum incremental update", "[checksum]")
+{
+    std::mt19937 gen(1624);
+    std::uniform_int_distribution<unsigned> byte(0, 255);
+    uint8_t buf[60];
+
+    for ( auto& b : buf )
+        b = byte(gen);
+
+    for ( unsigned i = 0; i < 1000; ++i )
+    {
+        uint16_t cksum = cksum_add((const uint16_t*)buf, sizeof(buf));
+
+        unsigned off = 2 * (gen() % (sizeof(buf) / 2 - 1));
+        uint16_t old16, new16;
+        memcpy(&old16, buf + off, 2);
+        new16 = (i == 0) ? 0 : (uint16_t)gen();
+        memcpy(buf + off, &new16, 2);
+
+        CHECK(cksum_update(cksum, old16, new16) ==
+            cksum_add((const uint16_t*)buf, sizeof(buf)));
+
+        cksum = cksum_add((const uint16_t*)buf, sizeof(buf));
+
+        off = 4 * (gen() % (sizeof(buf) / 4));
+        uint32_t old32, new32 = gen();
+        memcpy(&old32, buf + off, 4);
+        memcpy(buf + off, &new32, 4);
+
+        CHECK(cksum_update32(cksum, old32, new32) ==
+            cksum_add((const uint16_t*)buf, sizeof(buf)));
+    }
+}
+
+TEST_CASE("checksum deferred pseudoheader", "[checksum]")
+{
+    std::mt19937 gen(793);
+    uint16_t seg[40];
+
+    for ( auto& w : seg )
+        w = (uint16_t)gen();
+
+    Pseudoheader ph = { };
+    ph.hdr.sip = gen();
+    ph.hdr.dip = gen();
+    ph.hdr.zero = 0;
+    ph.hdr.protocol = IpProtocol::TCP;
+    ph.hdr.len = htons(sizeof(seg));
+
+    CHECK(l4_cksum(seg, sizeof(seg), pseudo_sum(ph)) == tcp_cksum(seg, sizeof(seg), ph));
+    CHECK(l4_cksum(seg, sizeof(seg), pseudo_sum(ph)) == udp_cksum(seg, sizeof(seg), ph));
+
+    Pseudoheader6 ph6 = { };
+    for ( auto& a : ph6.hdr.sip )
+        a = gen();
+    for ( auto& a : ph6.hdr.dip )
+        a = gen();
+    ph6.hdr.zero = 0;
+    ph6.hdr.protocol = IpProtocol::UDP;
+    ph6.hdr.len = htons(sizeof(seg));
+
+    CHECK(l4_cksum(seg, sizeof(seg), pseudo_sum(ph6)) == udp_cksum(seg, sizeof(seg), ph6));
+
+    // a segment carrying its own checksum verifies to zero
+    seg[8] = 0;
+    seg[8] = tcp_cksum(seg, sizeof(seg), ph);
+    CHECK(l4_cksum(seg, sizeof(seg), pseudo_sum(ph)) == 0);
+}
+
+#ifdef BENCHMARK_TEST
+
+TEST_CASE("checksum kernel speed", "[checksum]")
+{
+    std::vector<uint8_t> buf(1500);
+
+    for ( size_t i = 0; i < buf.size(); ++i )
+        buf[i] = (uint8_t)(i * 31);
+
+    const char* names[] = { "scalar 1500", "sse2 1500", "avx2 1500", "neon 1500" };
+    unsigned i = 0;
+
+    for ( auto k : kernels )
+    {
+        if ( set_kernel(k) )
+        {
+            BENCHMARK(names[i])
+            { return cksum_add((const uint16_t*)buf.data(), buf.size()); };
+        }
+        ++i;
+    }
+    set_kernel(Kernel::SCALAR);
+}
+
+#endif
+
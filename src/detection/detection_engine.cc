@@ -54,6 +54,10 @@
 #include "ips_context_data.h"
 #include "regex_offload.h"
 
+#ifdef HAVE_HYPERSCAN
+#include "regex_prefilter.h"
+#endif
+
 static THREAD_LOCAL RegexOffload* offloader = nullptr;
 
 using namespace snort;
@@ -65,6 +69,13 @@ using namespace snort;
 void DetectionEngine::thread_init()
 {
     const SnortConfig* sc = SnortConfig::get_conf();
+
+    if ( sc->batch_size > 1 )
+    {
+        offloader = new BatchRegexOffload(sc->batch_size, sc->batch_timeout);
+        return;
+    }
+
     FastPatternConfig* fp = sc->fast_pattern_config;
     const MpseApi* offload_search_api = fp->get_offload_search_api();
 
@@ -91,7 +102,8 @@ void DetectionEngine::thread_init()
         {
             // If the search method is not async capable then offloaded searches will be performed
             // in a separate processing thread that the RegexOffload instance needs to create.
-            offloader = RegexOffload::get_offloader(sc->offload_threads, true);
+            offloader = RegexOffload::get_offloader(
+                sc->offload_threads, true, sc->offload_wait, sc->offload_shared);
         }
     }
 }
@@ -295,13 +307,26 @@ DataBuffer& DetectionEngine::get_alt_buffer(Packet* p)
 }
 
 void DetectionEngine::set_file_data(const DataPointer& dp)
-{ Analyzer::get_switcher()->get_context()->file_data = dp; }
+{
+    IpsContext* c = Analyzer::get_switcher()->get_context();
+    c->file_data = dp;
+#ifdef HAVE_HYPERSCAN
+    // file data buffers are reused for each file or mime part
+    RegexPrefilter::rewritten(c);
+#endif
+}
 
 DataPointer& DetectionEngine::get_file_data(IpsContext* c)
 { return c->file_data; }
 
 void DetectionEngine::set_js_data(const DataPointer& dp)
-{ Analyzer::get_switcher()->get_context()->js_data = dp; }
+{
+    IpsContext* c = Analyzer::get_switcher()->get_context();
+    c->js_data = dp;
+#ifdef HAVE_HYPERSCAN
+    RegexPrefilter::rewritten(c);
+#endif
+}
 
 DataPointer& DetectionEngine::get_js_data(IpsContext* c)
 { return c->js_data; }
@@ -424,7 +449,10 @@ bool DetectionEngine::offload(Packet* p)
     ContextSwitcher* sw = Analyzer::get_switcher();
     fp_partial(p);
 
-    if ( p->dsize >= p->context->conf->offload_limit and
+    const SnortConfig* sc = p->context->conf;
+
+    // batches take any size packet
+    if ( (sc->batch_size > 1 or p->dsize >= sc->offload_limit) and
         p->context->searches.items.size() > 0 )
     {
         if ( offloader->available() )
@@ -451,6 +479,8 @@ void DetectionEngine::idle()
 {
     if (offloader)
     {
+        offloader->flush();
+
         while ( offloader->count() )
         {
             debug_logf(detection_trace, TRACE_DETECTION_ENGINE, nullptr,
@@ -469,7 +499,10 @@ void DetectionEngine::idle()
 void DetectionEngine::onload(Flow* flow)
 {
     if ( flow->is_suspended() )
+    {
         pc.onload_waits++;
+        offloader->flush();
+    }
 
     while ( flow->is_suspended() )
     {
@@ -502,6 +535,12 @@ void DetectionEngine::onload()
     }
 }
 
+void DetectionEngine::flush_batch()
+{
+    offloader->flush();
+    onload();
+}
+
 void DetectionEngine::resume_ready_suspends(const IpsContextChain& chain)
 {
     while ( chain.front() and !chain.front()->packet->is_offloaded() )
@@ -550,6 +589,7 @@ void DetectionEngine::wait_for_context()
     if ( !sw->idle_count() )
     {
         pc.context_stalls++;
+        offloader->flush();
         do
         {
             onload();
@@ -63,6 +63,7 @@ public:
 
     static void onload(Flow*);
     static void onload();
+    static void flush_batch();
     static void idle();
 
     static void set_encode_packet(Packet*);
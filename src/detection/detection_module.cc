@@ -34,6 +34,10 @@
 
 #include "detect_trace.h"
 
+#ifdef HAVE_HYPERSCAN
+#include "regex_prefilter.h"
+#endif
+
 using namespace snort;
 
 THREAD_LOCAL const Trace* detection_trace = nullptr;
@@ -58,6 +62,12 @@ static const Parameter detection_params[] =
     { "asn1", Parameter::PT_INT, "0:65535", "0",
       "maximum decode nodes" },
 
+    { "batch_size", Parameter::PT_INT, "0:256", "0",
+      "number of packets to accumulate for a combined fast pattern search (0 and 1 disable)" },
+
+    { "batch_timeout", Parameter::PT_INT, "1:max32", "100",
+      "maximum microseconds to hold a partial batch" },
+
     { "global_default_rule_state", Parameter::PT_BOOL, nullptr, "true",
       "enable or disable rules by default (overridden by ips policy settings)" },
 
@@ -75,6 +85,16 @@ static const Parameter detection_params[] =
     { "offload_threads", Parameter::PT_INT, "0:max32", "0",
       "maximum number of simultaneous offloads (defaults to disabled)" },
 
+    { "offload_wait", Parameter::PT_ENUM, "block | spin | adaptive", "block",
+      "offload threads block per request or poll lock-free rings, optionally parking when idle" },
+
+    { "offload_shared", Parameter::PT_BOOL, nullptr, "false",
+      "share offload threads across packet threads; idle threads steal queued work" },
+
+    { "option_program", Parameter::PT_ENUM, "off | on | check", "off",
+      "flatten rule option trees for evaluation; check also runs the trees and counts mismatches "
+      "(for debugging; skews rule profiling)" },
+
     { "pcre_enable", Parameter::PT_BOOL, nullptr, "true",
       "enable pcre pattern matching" },
 
@@ -88,6 +108,9 @@ static const Parameter detection_params[] =
       "enable pcre match limit overrides when pattern matching (ie ignore /O)" },
 
 #ifdef HAVE_HYPERSCAN
+    { "pcre_prefilter", Parameter::PT_BOOL, nullptr, "false",
+      "skip pcre options that can't match using one hyperscan prefilter scan per buffer" },
+
     { "pcre_to_regex", Parameter::PT_BOOL, nullptr, "false",
       "enable the use of regex instead of pcre for compatible expressions" },
 #endif
@@ -105,7 +128,18 @@ static const Parameter detection_params[] =
 #define s_name "detection"
 
 DetectionModule::DetectionModule() : Module(s_name, detection_help, detection_params)
-{ }
+{
+#ifdef HAVE_HYPERSCAN
+    RegexPrefilter::init();
+#endif
+}
+
+DetectionModule::~DetectionModule()
+{
+#ifdef HAVE_HYPERSCAN
+    RegexPrefilter::term();
+#endif
+}
 
 void DetectionModule::set_trace(const Trace* trace) const
 { detection_trace = trace; }
@@ -121,8 +155,16 @@ const TraceOption* DetectionModule::get_trace_options() const
 
 bool DetectionModule::end(const char*, int, SnortConfig* sc)
 {
-    if ( sc->offload_threads and ThreadConfig::get_instance_max() != 1 )
-        ParseError("You can not enable experimental offload with more than one packet thread.");
+    if ( sc->batch_size > 1 and sc->offload_threads )
+        ParseError("batch_size can't be used with offload_threads.");
+
+    if ( sc->offload_shared and !sc->offload_threads )
+        ParseError("offload_shared requires offload_threads.");
+
+    // the shared pool gives each offload thread its own instance id
+    if ( sc->offload_threads and !sc->offload_shared and ThreadConfig::get_instance_max() != 1 )
+        ParseError("You can not enable experimental offload with more than one packet thread "
+            "unless offload_shared is set.");
 
     return true;
 }
@@ -132,6 +174,12 @@ bool DetectionModule::set(const char*, Value& v, SnortConfig* sc)
     if ( v.is("asn1") )
         sc->asn1_mem = v.get_uint16();
 
+    else if ( v.is("batch_size") )
+        sc->batch_size = v.get_uint32();
+
+    else if ( v.is("batch_timeout") )
+        sc->batch_timeout = v.get_uint32();
+
     else if ( v.is("global_default_rule_state") )
         sc->global_default_rule_state = v.get_bool();
 
@@ -149,6 +197,15 @@ bool DetectionModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("offload_threads") )
         sc->offload_threads = v.get_uint32();
 
+    else if ( v.is("offload_wait") )
+        sc->offload_wait = (OffloadWait)v.get_uint8();
+
+    else if ( v.is("offload_shared") )
+        sc->offload_shared = v.get_bool();
+
+    else if ( v.is("option_program") )
+        sc->option_program = (OptionProgramMode)v.get_uint8();
+
     else if ( v.is("pcre_enable") )
         v.update_mask(sc->run_flags, RUN_FLAG__NO_PCRE, true);
 
@@ -193,6 +250,9 @@ bool DetectionModule::set(const char*, Value& v, SnortConfig* sc)
         sc->pcre_override = v.get_bool();
 
 #ifdef HAVE_HYPERSCAN
+    else if ( v.is("pcre_prefilter") )
+        sc->pcre_prefilter = v.get_bool();
+
     else if ( v.is("pcre_to_regex") )
         sc->pcre_to_regex = v.get_bool();
 #endif
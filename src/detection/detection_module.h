@@ -30,6 +30,7 @@ class DetectionModule : public Module
 {
 public:
     DetectionModule();
+    ~DetectionModule() override;
 
     bool set(const char*, Value&, SnortConfig*) override;
     bool end(const char*, int, SnortConfig*) override;
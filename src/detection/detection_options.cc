@@ -51,6 +51,7 @@
 #include "parser/parser.h"
 #include "profiler/rule_profiler_defs.h"
 #include "protocols/packet_manager.h"
+#include "utils/stats.h"
 #include "utils/util.h"
 #include "utils/util_cstring.h"
 
@@ -61,6 +62,7 @@
 #include "fp_create.h"
 #include "fp_detect.h"
 #include "ips_context.h"
+#include "option_program.h"
 #include "pattern_match_data.h"
 #include "rules.h"
 #include "treenodes.h"
@@ -214,6 +216,7 @@ void free_detection_option_tree(detection_option_tree_node_t* node)
     for (int i = 0; i < node->num_children; i++)
         free_detection_option_tree(node->children[i]);
 
+    delete node->program;
     snort_free(node->children);
     snort_free(node->state);
     snort_free(node);
@@ -326,6 +329,15 @@ void print_option_tree(detection_option_tree_node_t* node, int level)
 #endif
 }
 
+// trees are only added once so each node gets its own id
+static void set_node_ids(SnortConfig* sc, detection_option_tree_node_t* node)
+{
+    node->node_id = sc->option_tree_nodes++;
+
+    for ( int i = 0; i < node->num_children; ++i )
+        set_node_ids(sc, node->children[i]);
+}
+
 void* add_detection_option_tree(SnortConfig* sc, detection_option_tree_node_t* option_tree)
 {
     static std::mutex build_mutex;
@@ -342,9 +354,40 @@ void* add_detection_option_tree(SnortConfig* sc, detection_option_tree_node_t* o
         return p;
 
     sc->detection_option_tree_hash_table->insert(&key, option_tree);
+    set_node_ids(sc, option_tree);
     return nullptr;
 }
 
+bool detection_option_check_otn(OptTreeNode* otn, Packet* p)
+{
+    SnortProtocolId snort_protocol_id = p->get_snort_protocol_id();
+    int check_ports = 1;
+
+    if ( snort_protocol_id != UNKNOWN_PROTOCOL_ID )
+    {
+        const auto& sig_info = otn->sigInfo;
+
+        for ( const auto& svc : sig_info.services )
+        {
+            if ( snort_protocol_id == svc.snort_protocol_id )
+            {
+                check_ports = 0;
+                break;
+            }
+        }
+
+        if ( !sig_info.services.empty() and check_ports )
+        {
+            debug_logf(detection_trace, TRACE_RULE_EVAL, p,
+                "SID %u not matched because of service mismatch %d\n",
+                sig_info.sid, snort_protocol_id);
+            return false;
+        }
+    }
+
+    return fp_eval_rtn(getRuntimeRtnFromOtn(otn), p, check_ports);
+}
+
 int detection_option_node_evaluate(
     detection_option_tree_node_t* node, detection_option_eval_data_t& eval_data,
     const Cursor& orig_cursor)
@@ -362,39 +405,30 @@ int detection_option_node_evaluate(
     bool flowbits_setoperation = false;
     int loop_count = 0;
     uint32_t tmp_byte_extract_vars[NUM_IPS_OPTIONS_VARS];
-    uint64_t cur_eval_context_num = eval_data.p->context->context_num;
 
     node_eval_trace(node, cursor, eval_data.p);
 
     auto p = eval_data.p;
+    OptionMemo& memo = p->context->memo;
+    OptionMemo::Entry probe_check = { };
+    OptionMemo::Entry& last_check = eval_data.probe ? probe_check : memo.get(node->node_id);
 
     // see if evaluated it before ...
-    if ( !node->is_relative )
+    if ( !node->is_relative and memo.is_current(last_check) and
+        !(p->packet_flags & PKT_ALLOW_MULTIPLE_DETECT) )
     {
-        auto last_check = state.last_check;
-
-        if ( last_check.ts == p->pkth->ts &&
-            last_check.run_num == get_run_num() &&
-            last_check.context_num == cur_eval_context_num &&
-            last_check.rebuild_flag == (p->packet_flags & PKT_REBUILT_STREAM) &&
-            !(p->packet_flags & PKT_ALLOW_MULTIPLE_DETECT) )
+        if ( !last_check.flowbit_failed &&
+            !(p->packet_flags & PKT_IP_RULE_2ND) &&
+            !p->is_udp_tunneled() )
         {
-            if ( !last_check.flowbit_failed &&
-                !(p->packet_flags & PKT_IP_RULE_2ND) &&
-                !p->is_udp_tunneled() )
-            {
-                debug_log(detection_trace, TRACE_RULE_EVAL, p,
-                    "Was evaluated before, returning last check result\n");
-                return last_check.result;
-            }
+            debug_log(detection_trace, TRACE_RULE_EVAL, p,
+                "Was evaluated before, returning last check result\n");
+            pc.option_memo_hits++;
+            return last_check.result;
         }
     }
 
-    state.last_check.ts = eval_data.p->pkth->ts;
-    state.last_check.run_num = get_run_num();
-    state.last_check.context_num = cur_eval_context_num;
-    state.last_check.flowbit_failed = 0;
-    state.last_check.rebuild_flag = p->packet_flags & PKT_REBUILT_STREAM;
+    memo.update(last_check, 0);
 
     // Save some stuff off for repeated pattern tests
     PmdLastCheck* content_last = nullptr;
@@ -412,36 +446,8 @@ int detection_option_node_evaluate(
     do
     {
         rval = (int)IpsOption::NO_MATCH;  // FIXIT-L refactor to eliminate casts to int.
-        if ( node->otn )
-        {
-            SnortProtocolId snort_protocol_id = p->get_snort_protocol_id();
-            int check_ports = 1;
-
-            if ( snort_protocol_id != UNKNOWN_PROTOCOL_ID )
-            {
-                const auto& sig_info = node->otn->sigInfo;
-
-                for ( const auto& svc : sig_info.services )
-                {
-                    if ( snort_protocol_id == svc.snort_protocol_id )
-                    {
-                        check_ports = 0;
-                        break;  // out of for
-                    }
-                }
-
-                if ( !sig_info.services.empty() and check_ports )
-                {
-                    debug_logf(detection_trace, TRACE_RULE_EVAL, p,
-                        "SID %u not matched because of service mismatch %d\n",
-                        sig_info.sid, snort_protocol_id);
-                    break;  // out of case
-                }
-            }
-
-            if ( !fp_eval_rtn(getRuntimeRtnFromOtn(node->otn), p, check_ports) )
-                break;
-        }
+        if ( node->otn and !detection_option_check_otn(node->otn, p) )
+            break;
 
         switch ( node->option_type )
         {
@@ -450,7 +456,7 @@ int detection_option_node_evaluate(
                 OptTreeNode* otn = (OptTreeNode*)node->option_data;
                 bool f_result = true;
 
-                if ( otn->detection_filter )
+                if ( otn->detection_filter and !eval_data.probe )
                 {
                     debug_log(detection_trace, TRACE_RULE_EVAL, p,
                         "Evaluating detection filter\n");
@@ -459,7 +465,12 @@ int detection_option_node_evaluate(
                         p->pkth->ts.tv_sec);
                 }
 
-                if ( !f_result )
+                if ( eval_data.probe )
+                {
+                    eval_data.probe->emplace_back(otn);
+                    result = rval = (int)IpsOption::MATCH;
+                }
+                else if ( !f_result )
                 {
                     debug_log(detection_trace, TRACE_RULE_EVAL, p, "Header check failed\n");
                 }
@@ -494,7 +505,7 @@ int detection_option_node_evaluate(
                 {
                     if ( content_last->ts == p->pkth->ts &&
                         content_last->run_num == get_run_num() &&
-                        content_last->context_num == cur_eval_context_num &&
+                        content_last->context_num == p->context->context_num &&
                         content_last->rebuild_flag == (p->packet_flags & PKT_REBUILT_STREAM) )
                     {
                         rval = (int)IpsOption::NO_MATCH;
@@ -528,7 +539,7 @@ int detection_option_node_evaluate(
         if ( rval == (int)IpsOption::NO_MATCH )
         {
             debug_log(detection_trace, TRACE_RULE_EVAL, p, "no match\n");
-            state.last_check.result = result;
+            memo.update(last_check, result);
             return result;
         }
         else if ( rval == (int)IpsOption::FAILED_BIT )
@@ -536,8 +547,8 @@ int detection_option_node_evaluate(
             debug_log(detection_trace, TRACE_RULE_EVAL, p, "failed bit\n");
             eval_data.flowbit_failed = 1;
             // clear the timestamp so failed flowbit gets eval'd again
-            state.last_check.flowbit_failed = 1;
-            state.last_check.result = result;
+            memo.flowbit_failed(last_check);
+            memo.update(last_check, result);
             return 0;
         }
         else if ( rval == (int)IpsOption::NO_ALERT )
@@ -573,7 +584,7 @@ int detection_option_node_evaluate(
         if ( PacketLatency::fastpath() )
         {
             profile.stop(result != (int)IpsOption::NO_MATCH);
-            state.last_check.result = result;
+            memo.update(last_check, result);
             return result;
         }
 
@@ -651,7 +662,7 @@ int detection_option_node_evaluate(
 
                     if ( PacketLatency::fastpath() )
                     {
-                        state.last_check.result = result;
+                        memo.update(last_check, result);
                         return result;
                     }
                 }
@@ -696,7 +707,7 @@ int detection_option_node_evaluate(
     }
     while ( continue_loop );
 
-    if ( flowbits_setoperation && result == (int)IpsOption::MATCH )
+    if ( flowbits_setoperation && result == (int)IpsOption::MATCH && !eval_data.probe )
     {
         // Do any setting/clearing/resetting/toggling of flowbits here
         // given that other rule options matched
@@ -709,10 +720,10 @@ int detection_option_node_evaluate(
     {
         // something deeper in the tree failed a flowbit test, we may need to
         // reeval this node
-        state.last_check.flowbit_failed = 1;
+        memo.flowbit_failed(last_check);
     }
 
-    state.last_check.result = result;
+    memo.update(last_check, result);
     profile.stop(result != (int)IpsOption::NO_MATCH);
 
     return result;
@@ -33,6 +33,8 @@
 
 #include <sys/time.h>
 
+#include <vector>
+
 #include "detection/rule_option_types.h"
 #include "time/clock_defs.h"
 #include "main/snort_debug.h"
@@ -44,6 +46,8 @@ class XHash;
 struct Packet;
 struct SnortConfig;
 }
+class OptionProgram;
+struct OptTreeNode;
 struct RuleLatencyState;
 
 typedef int (* eval_func_t)(void* option_data, class Cursor&, snort::Packet*);
@@ -52,15 +56,6 @@ typedef int (* eval_func_t)(void* option_data, class Cursor&, snort::Packet*);
 struct dot_node_state_t
 {
     int result;
-    struct
-    {
-        struct timeval ts;
-        uint64_t context_num;
-        uint32_t rebuild_flag;
-        uint16_t run_num;
-        char result;
-        char flowbit_failed;
-    } last_check;
 
     // FIXIT-L perf profiler stuff should be factored of the node state struct
     hr_duration elapsed;
@@ -97,6 +92,8 @@ struct detection_option_tree_node_t
     int num_children;
     int relative_children;
     option_type_t option_type;
+    unsigned node_id;  // dense index into the context memo
+    OptionProgram* program;  // flattened tree, only set on tree roots
 };
 
 struct detection_option_tree_root_t
@@ -114,6 +111,10 @@ struct detection_option_eval_data_t
     snort::Packet* p;
     char flowbit_failed;
     char flowbit_noalert;
+
+    // if set, matching leaves are only recorded here; there are no events,
+    // flowbit sets, detection filter updates, or memo updates
+    std::vector<const OptTreeNode*>* probe;
 };
 
 // return existing data or add given and return nullptr
@@ -123,6 +124,9 @@ void* add_detection_option_tree(struct snort::SnortConfig*, detection_option_tre
 int detection_option_node_evaluate(
     detection_option_tree_node_t*, detection_option_eval_data_t&, const class Cursor&);
 
+// rule header and service checks for nodes leading to a single rule
+bool detection_option_check_otn(OptTreeNode*, snort::Packet*);
+
 void print_option_tree(detection_option_tree_node_t*, int level);
 void detection_option_tree_update_otn_stats(snort::XHash*);
 
@@ -25,6 +25,9 @@
 #ifndef FP_CONFIG_H
 #define FP_CONFIG_H
 
+#include <string>
+#include <thread>
+
 namespace snort
 {
     struct MpseApi;
@@ -143,6 +146,25 @@ public:
 
     unsigned set_max(unsigned bytes);
 
+    void set_cache_dir(const char* s)
+    { cache_dir = s; }
+
+    const std::string& get_cache_dir() const
+    { return cache_dir; }
+
+    void set_max_compile_threads(unsigned n)
+    { max_compile_threads = n; }
+
+    // 0 means one per core
+    unsigned get_compile_threads() const
+    {
+        if ( max_compile_threads )
+            return max_compile_threads;
+
+        unsigned n = std::thread::hardware_concurrency();
+        return n ? n : 1;
+    }
+
 private:
     const snort::MpseApi* search_api = nullptr;
     const snort::MpseApi* offload_search_api = nullptr;
@@ -158,9 +180,12 @@ private:
     unsigned max_pattern_len = 0;
 
     unsigned queue_limit = 0;
+    unsigned max_compile_threads = 0;
 
     int portlists_flags = 0;
     int num_patterns_truncated = 0;  // due to max_pattern_len
+
+    std::string cache_dir;
 };
 
 #endif
@@ -34,13 +34,16 @@
 
 #include "fp_create.h"
 
+#include <chrono>
+#include <vector>
+
 #include "framework/mpse.h"
 #include "framework/mpse_batch.h"
 #include "hash/ghash.h"
 #include "hash/hash_defs.h"
 #include "hash/xhash.h"
+#include "helpers/mpse_cache.h"
 #include "log/messages.h"
-#include "main/snort.h"
 #include "main/snort_config.h"
 #include "main/thread_config.h"
 #include "managers/mpse_manager.h"
@@ -55,11 +58,16 @@
 #include "detect_trace.h"
 #include "fp_config.h"
 #include "fp_utils.h"
+#include "option_program.h"
 #include "pattern_match_data.h"
 #include "pcrm.h"
 #include "service_map.h"
 #include "treenodes.h"
 
+#ifdef HAVE_HYPERSCAN
+#include "regex_prefilter.h"
+#endif
+
 using namespace snort;
 using namespace std;
 
@@ -142,6 +150,32 @@ static void fixup_trees(SnortConfig* sc)
     }
 }
 
+static void compile_programs(SnortConfig* sc)
+{
+    if ( sc->option_program == OPTION_PROGRAM_OFF or !sc->detection_option_tree_hash_table )
+        return;
+
+    unsigned trees = 0, ops = 0, inline_ops = 0;
+    HashNode* hn = sc->detection_option_tree_hash_table->find_first_node();
+
+    while ( hn )
+    {
+        detection_option_tree_node_t* node = (detection_option_tree_node_t*)hn->data;
+        node->program = OptionProgram::compile(node);
+
+        ++trees;
+        ops += node->program->size();
+        inline_ops += node->program->get_inline_count();
+
+        hn = sc->detection_option_tree_hash_table->find_next_node();
+    }
+
+    LogLabel("option programs");
+    LogCount("trees", trees);
+    LogCount("ops", ops);
+    LogCount("inline options", inline_ops);
+}
+
 static bool new_sig(int num_children, detection_option_tree_node_t** nodes, OptTreeNode* otn)
 {
     for ( int i = 0; i < num_children; ++i )
@@ -1533,11 +1567,34 @@ static void fpCreateServicePortGroups(SnortConfig* sc)
     sc->srmmTable = nullptr;
 }
 
-static unsigned can_build_mt(FastPatternConfig* fp)
+// wall clock time of each build phase in seconds
+class CompileTimer
 {
-    if ( Snort::is_reloading() )
-        return false;
+public:
+    CompileTimer()
+    { last = std::chrono::steady_clock::now(); }
 
+    void lap(const char* phase)
+    {
+        auto now = std::chrono::steady_clock::now();
+        std::chrono::duration<double> d = now - last;
+        laps.emplace_back(phase, d.count());
+        last = now;
+    }
+
+    void print() const
+    {
+        for ( const auto& l : laps )
+            LogMessage("%25.25s: %.6f\n", l.first, l.second);
+    }
+
+private:
+    std::chrono::steady_clock::time_point last;
+    std::vector<std::pair<const char*, double>> laps;
+};
+
+static bool can_build_mt(FastPatternConfig* fp)
+{
     const MpseApi* search_api = fp->get_search_api();
     assert(search_api);
 
@@ -1579,6 +1636,9 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
 
     mpse_count = 0;
     offload_mpse_count = 0;
+    MpseCache::reset_stats();
+
+    CompileTimer timer;
 
     MpseManager::start_search_engine(fp->get_search_api());
 
@@ -1587,6 +1647,7 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
         LogMessage("Creating Port Groups....\n");
 
     fpCreatePortGroups(sc, port_tables);
+    timer.lap("port groups");
 
     if ( log_rule_group_details )
     {
@@ -1596,6 +1657,7 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
 
     /* Create rule_maps */
     fpCreateRuleMaps(sc, port_tables);
+    timer.lap("rule maps");
 
     if ( log_rule_group_details )
     {
@@ -1609,19 +1671,35 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
      * Also requires a service attribute for lookup ...
      */
     fpCreateServicePortGroups(sc);
+    timer.lap("service groups");
 
     if ( log_rule_group_details )
         LogMessage("Service Based Rule Maps Done....\n");
 
+    MpseCompileStats mcs = { };
+
     if ( !sc->test_mode() or sc->mem_check() )
     {
-        unsigned c = compile_mpses(sc, can_build_mt(fp));
+        unsigned c = compile_mpses(sc, can_build_mt(fp), &mcs);
         unsigned expected = mpse_count + offload_mpse_count;
+        timer.lap("search engines");
 
         if ( c != expected )
             ParseError("Failed to compile %u search engines", expected - c);
 
         fixup_trees(sc);
+        timer.lap("option trees");
+
+        compile_programs(sc);
+        timer.lap("option programs");
+
+#ifdef HAVE_HYPERSCAN
+        if ( sc->pcre_prefilter )
+        {
+            sc->regex_prefilter = RegexPrefilter::build(sc);
+            timer.lap("pcre prefilter");
+        }
+#endif
     }
 
     fp_print_port_groups(port_tables);
@@ -1639,6 +1717,18 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
         MpseManager::print_mpse_summary(fp->get_offload_search_api());
     }
 
+    if ( mpse_count or offload_mpse_count )
+        MpseCache::print_stats();
+
+    if ( mcs.queued )
+    {
+        LogLabel("rule group compile");
+        LogCount("threads", mcs.threads);
+        LogCount("search engines", mcs.queued);
+        LogCount("steals", mcs.steals);
+        timer.print();
+    }
+
     if ( fp->get_num_patterns_truncated() )
         LogMessage("%25.25s: %-12u\n", "truncated patterns", fp->get_num_patterns_truncated());
 
@@ -1661,6 +1751,10 @@ void fpDeleteFastPacketDetection(SnortConfig* sc)
 
     if ( sc->sopgTable )
         delete sc->sopgTable;
+
+#ifdef HAVE_HYPERSCAN
+    delete sc->regex_prefilter;
+#endif
 }
 
 static void print_nfp_info(const char* group, OptTreeNode* otn)
@@ -47,6 +47,7 @@
 #include "filters/sfthreshold.h"
 #include "framework/cursor.h"
 #include "framework/mpse.h"
+#include "ips_options/extract.h"
 #include "latency/packet_latency.h"
 #include "latency/rule_latency.h"
 #include "log/messages.h"
@@ -54,6 +55,7 @@
 #include "main/snort_config.h"
 #include "main/snort_debug.h"
 #include "managers/action_manager.h"
+#include "memory/memory_arena.h"
 #include "packet_io/active.h"
 #include "packet_tracer/packet_tracer.h"
 #include "parser/parser.h"
@@ -76,6 +78,7 @@
 #include "fp_config.h"
 #include "fp_create.h"
 #include "ips_context.h"
+#include "option_program.h"
 #include "pattern_match_data.h"
 #include "pcrm.h"
 #include "rules.h"
@@ -348,6 +351,44 @@ int fp_eval_option(void* v, Cursor& c, Packet* p)
     return opt->eval(c, p);
 }
 
+// probe both and compare the rules reached.  probes don't alert, set
+// flowbits or memoize, but options are evaluated again so rule profiling
+// and option counts are skewed.  check is for debugging only.
+static void check_program(detection_option_tree_node_t* node,
+    detection_option_eval_data_t& eval_data, const Cursor& c)
+{
+    uint32_t vars[NUM_IPS_OPTIONS_VARS];
+
+    for ( unsigned i = 0; i < NUM_IPS_OPTIONS_VARS; ++i )
+        GetVarValueByIndex(&vars[i], (int8_t)i);
+
+    std::vector<const OptTreeNode*> tree_rules, prog_rules;
+    detection_option_eval_data_t probe = eval_data;
+
+    probe.probe = &tree_rules;
+    int tree_result = detection_option_node_evaluate(node, probe, c);
+
+    for ( unsigned i = 0; i < NUM_IPS_OPTIONS_VARS; ++i )
+        SetVarValueByIndex(vars[i], (int8_t)i);
+
+    probe = eval_data;
+    probe.probe = &prog_rules;
+    int prog_result = node->program->eval(probe, c);
+
+    for ( unsigned i = 0; i < NUM_IPS_OPTIONS_VARS; ++i )
+        SetVarValueByIndex(vars[i], (int8_t)i);
+
+    pc.option_program_checks++;
+
+    if ( tree_result != prog_result or tree_rules != prog_rules )
+    {
+        pc.option_program_mismatches++;
+        debug_logf(detection_trace, TRACE_RULE_EVAL, eval_data.p,
+            "option program mismatch: tree %d rules %zu, program %d rules %zu\n",
+            tree_result, tree_rules.size(), prog_result, prog_rules.size());
+    }
+}
+
 static int detection_option_tree_evaluate(detection_option_tree_root_t* root,
     detection_option_eval_data_t& eval_data)
 {
@@ -358,15 +399,29 @@ static int detection_option_tree_evaluate(detection_option_tree_root_t* root,
     if ( RuleLatency::suspended() )
         return 0;
 
-    Cursor c(eval_data.p);
+    Packet* p = eval_data.p;
+    p->context->memo.start(p, p->context->context_num, p->context->conf->option_tree_nodes,
+        get_run_num());
+
+    Cursor c(p);
     int rval = 0;
 
-    debug_log(detection_trace, TRACE_RULE_EVAL, eval_data.p, "Starting tree eval\n");
+    debug_log(detection_trace, TRACE_RULE_EVAL, p, "Starting tree eval\n");
+
+    OptionProgramMode mode = p->context->conf->option_program;
 
     for ( int i = 0; i < root->num_children; ++i )
     {
+        detection_option_tree_node_t* node = root->children[i];
+
+        if ( node->program and mode == OPTION_PROGRAM_CHECK )
+            check_program(node, eval_data, c);
+
         // Increment number of events generated from that child
-        rval += detection_option_node_evaluate(root->children[i], eval_data, c);
+        if ( node->program and mode == OPTION_PROGRAM_ON )
+            rval += node->program->eval(eval_data, c);
+        else
+            rval += detection_option_node_evaluate(node, eval_data, c);
     }
     clear_trace_cursor_info();
 
@@ -383,6 +438,7 @@ static void rule_tree_match(
     eval_data.pmd = pmx->pmd;
     eval_data.flowbit_failed = 0;
     eval_data.flowbit_noalert = 0;
+    eval_data.probe = nullptr;
 
     print_pattern(pmx->pmd, eval_data.p);
 
@@ -827,6 +883,9 @@ void MpseStash::process(IpsContext* context, MatchStore& store)
     store.clear();
 }
 
+static constexpr size_t fp_context_bytes =
+    sizeof(MpseStash) + sizeof(OtnxMatchData) + MAX_NUM_RULE_TYPES * sizeof(MatchInfo);
+
 void fp_set_context(IpsContext& c)
 {
     FastPatternConfig* fp = c.conf->fast_pattern_config;
@@ -834,6 +893,7 @@ void fp_set_context(IpsContext& c)
     c.otnx = (OtnxMatchData*)snort_calloc(sizeof(OtnxMatchData));
     c.otnx->matchInfo = (MatchInfo*)snort_calloc(MAX_NUM_RULE_TYPES, sizeof(MatchInfo));
     c.context_num = 0;
+    memory::MemoryArena::charge(memory::Arena::DETECTION, fp_context_bytes);
 }
 
 void fp_clear_context(IpsContext& c)
@@ -841,6 +901,7 @@ void fp_clear_context(IpsContext& c)
     delete c.stash;
     snort_free(c.otnx->matchInfo);
     snort_free(c.otnx);
+    memory::MemoryArena::credit(memory::Arena::DETECTION, fp_context_bytes);
 }
 
 static int rule_tree_queue(
@@ -1069,6 +1130,7 @@ static inline void eval_nfp(
             eval_data.pmd = nullptr;
             eval_data.flowbit_failed = 0;
             eval_data.flowbit_noalert = 0;
+            eval_data.probe = nullptr;
 
             int rval = 0;
             {
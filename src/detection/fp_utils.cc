@@ -22,14 +22,17 @@
 
 #include "fp_utils.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
-#include <list>
+#include <deque>
 #include <mutex>
 #include <thread>
 
+#include "fp_config.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
+#include "main/thread.h"
 #include "parser/parse_conf.h"
 #include "pattern_match_data.h"
 #include "ports/port_group.h"
@@ -372,63 +375,139 @@ bool is_fast_pattern_only(const OptTreeNode* otn, const OptFpList* ofp, Mpse::Mp
 
 //--------------------------------------------------------------------------
 // mpse compile threads
+//
+// queued mpses are sorted by pattern count, largest first, and dealt round
+// robin to a deque per worker.  workers take from the front of their own
+// deque and when that runs dry steal from the back of the fullest deque so
+// a few large groups don't leave the other workers idle.
 //--------------------------------------------------------------------------
 
-static std::list<Mpse*> s_tbd;
+struct CompileQueue
+{
+    std::deque<Mpse*> tbd;
+    std::mutex mutex;
+};
+
+static std::vector<Mpse*> s_tbd;
 static std::mutex s_mutex;
 
-static Mpse* get_mpse()
+static Mpse* get_mpse(CompileQueue& q)
 {
-    std::lock_guard<std::mutex> lock(s_mutex);
+    std::lock_guard<std::mutex> lock(q.mutex);
 
-    if ( s_tbd.empty() )
+    if ( q.tbd.empty() )
         return nullptr;
 
-    Mpse* m = s_tbd.front();
-    s_tbd.pop_front();
+    Mpse* m = q.tbd.front();
+    q.tbd.pop_front();
 
     return m;
 }
 
-static void compile_mpse(SnortConfig* sc, unsigned id, unsigned* count)
+static Mpse* steal_mpse(std::vector<CompileQueue>& queues)
+{
+    while ( true )
+    {
+        CompileQueue* victim = nullptr;
+        size_t most = 0;
+
+        // sizes are only a hint; the pop below is checked under the lock
+        for ( auto& q : queues )
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+
+            if ( q.tbd.size() > most )
+            {
+                most = q.tbd.size();
+                victim = &q;
+            }
+        }
+
+        if ( !victim )
+            return nullptr;
+
+        std::lock_guard<std::mutex> lock(victim->mutex);
+
+        if ( victim->tbd.empty() )
+            continue;
+
+        Mpse* m = victim->tbd.back();
+        victim->tbd.pop_back();
+
+        return m;
+    }
+}
+
+static void compile_mpse(
+    SnortConfig* sc, unsigned id, unsigned q, std::vector<CompileQueue>* queues,
+    unsigned* count, unsigned* steals)
 {
     set_instance_id(id);
-    unsigned c = 0;
+    unsigned c = 0, s = 0;
 
-    while ( Mpse* m = get_mpse() )
+    while ( true )
     {
+        Mpse* m = get_mpse((*queues)[q]);
+
+        if ( !m )
+        {
+            if ( !(m = steal_mpse(*queues)) )
+                break;
+            s++;
+        }
         if ( !m->prep_patterns(sc) )
             c++;
     }
     std::lock_guard<std::mutex> lock(s_mutex);
     *count += c;
+    *steals += s;
 }
 
 void queue_mpse(Mpse* m)
 {
-    s_tbd.push_back(m);
+    s_tbd.emplace_back(m);
 }
 
-unsigned compile_mpses(struct SnortConfig* sc, bool parallel)
+unsigned compile_mpses(struct SnortConfig* sc, bool parallel, MpseCompileStats* stats)
 {
-    std::list<std::thread*> workers;
-    unsigned max = parallel ? sc->num_slots : 1;
-    unsigned count = 0;
+    unsigned max = parallel ? sc->fast_pattern_config->get_compile_threads() : 1;
+    unsigned count = 0, steals = 0;
 
-    if ( max == 1 )
+    if ( max > s_tbd.size() )
+        max = s_tbd.size() ? s_tbd.size() : 1;
+
+    std::stable_sort(s_tbd.begin(), s_tbd.end(), [](const Mpse* a, const Mpse* b)
+        { return a->get_pattern_count() > b->get_pattern_count(); });
+
+    std::vector<CompileQueue> queues(max);
+
+    for ( unsigned i = 0; i < s_tbd.size(); ++i )
+        queues[i % max].tbd.emplace_back(s_tbd[i]);
+
+    if ( stats )
     {
-        compile_mpse(sc, get_instance_id(), &count);
-        return count;
+        stats->threads = max;
+        stats->queued = s_tbd.size();
     }
+    s_tbd.clear();
 
-    for ( unsigned i = 0; i < max; ++i )
-        workers.push_back(new std::thread(compile_mpse, sc, i, &count));
+    if ( max == 1 )
+        compile_mpse(sc, get_instance_id(), 0, &queues, &count, &steals);
 
-    for ( auto* w : workers )
+    else
     {
-        w->join();
-        delete w;
+        std::vector<std::thread> workers;
+
+        for ( unsigned i = 0; i < max; ++i )
+            workers.emplace_back(compile_mpse, sc, i, i, &queues, &count, &steals);
+
+        for ( auto& w : workers )
+            w.join();
     }
+
+    if ( stats )
+        stats->steals = steals;
+
     return count;
 }
 
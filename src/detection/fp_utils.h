@@ -42,8 +42,16 @@ bool set_fp_content(OptTreeNode*);
 std::vector <PatternMatchData*> get_fp_content(
     OptTreeNode*, OptFpList*&, bool srvc, bool only_literals, bool& exclude);
 
+struct MpseCompileStats
+{
+    unsigned threads;
+    unsigned queued;
+    unsigned steals;
+};
+
 void queue_mpse(snort::Mpse*);
-unsigned compile_mpses(struct snort::SnortConfig*, bool parallel = false);
+unsigned compile_mpses(
+    struct snort::SnortConfig*, bool parallel = false, MpseCompileStats* = nullptr);
 
 void validate_services(struct snort::SnortConfig*, OptTreeNode*);
 
@@ -32,6 +32,7 @@
 #include "events/event_queue.h"
 #include "events/sfeventq.h"
 #include "main/snort_config.h"
+#include "memory/memory_arena.h"
 #include "stream/stream.h"
 
 #ifdef UNIT_TEST
@@ -40,6 +41,10 @@
 
 using namespace snort;
 
+// the fixed part; the event queue and context data are not counted
+static constexpr size_t context_bytes =
+    sizeof(Packet) + sizeof(DAQ_PktHdr_t) + IpsContext::buf_size;
+
 //--------------------------------------------------------------------------
 // context methods
 //--------------------------------------------------------------------------
@@ -57,6 +62,7 @@ IpsContext::IpsContext(unsigned size) :
 
     pkth = new DAQ_PktHdr_t;
     buf = new uint8_t[buf_size];
+    memory::MemoryArena::charge(memory::Arena::DETECTION, context_bytes);
 
     conf = SnortConfig::get_conf();
     const EventQueueConfig* qc = conf->event_queue_config;
@@ -88,6 +94,7 @@ IpsContext::~IpsContext()
     delete[] buf;
     delete pkth;
     delete packet;
+    memory::MemoryArena::credit(memory::Arena::DETECTION, context_bytes);
 }
 
 void IpsContext::setup()
@@ -28,6 +28,7 @@
 #include <list>
 
 #include "detection/detection_util.h"
+#include "detection/option_memo.h"
 #include "framework/codec.h"
 #include "framework/mpse.h"
 #include "framework/mpse_batch.h"
@@ -149,6 +150,7 @@ public:
     MpseBatch searches;
     MpseStash* stash;
     OtnxMatchData* otnx;
+    OptionMemo memo;
     std::list<RegexRequest*>::iterator regex_req_it;
     SF_EVENTQ* equeue;
 
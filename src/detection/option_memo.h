@@ -0,0 +1,105 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// option_memo.h - per context results of evaluated option tree nodes
+
+#ifndef OPTION_MEMO_H
+#define OPTION_MEMO_H
+
+// OptionMemo remembers the result of each option tree node evaluated for
+// the current packet so that subtrees reached by several fast pattern
+// matches are only evaluated once.  nodes are indexed by the dense id given
+// when their tree is added to the config so the memo is a flat array owned
+// by the context instead of state scattered across every node.
+//
+// entries are stamped with a generation.  a new packet just bumps the
+// generation so there is nothing to clear.
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "protocols/packet.h"
+
+class OptionMemo
+{
+public:
+    struct Entry
+    {
+        uint32_t gen;
+        char result;
+        char flowbit_failed;
+    };
+
+    // call before evaluating a tree; size is the number of node ids
+    void start(const snort::Packet* p, uint64_t num, unsigned size, uint16_t run_num)
+    {
+        if ( entries.size() < size )
+            entries.resize(size, Entry());
+
+        uint32_t rebuilt = p->packet_flags & PKT_REBUILT_STREAM;
+
+        if ( num == context_num and p->pkth->ts.tv_sec == ts.tv_sec and
+            p->pkth->ts.tv_usec == ts.tv_usec and rebuilt == rebuild_flag and run_num == run )
+            return;
+
+        context_num = num;
+        ts = p->pkth->ts;
+        rebuild_flag = rebuilt;
+        run = run_num;
+
+        if ( !++gen )
+        {
+            memset(entries.data(), 0, entries.size() * sizeof(Entry));
+            gen = 1;
+        }
+    }
+
+    Entry& get(unsigned id)
+    { return entries[id]; }
+
+    bool is_current(const Entry& e) const
+    { return e.gen == gen; }
+
+    void update(Entry& e, int result)
+    {
+        if ( e.gen != gen )
+        {
+            e.gen = gen;
+            e.flowbit_failed = 0;
+        }
+        e.result = (char)result;
+    }
+
+    void flowbit_failed(Entry& e)
+    {
+        e.gen = gen;
+        e.flowbit_failed = 1;
+    }
+
+private:
+    std::vector<Entry> entries;
+    struct timeval ts = { };
+    uint64_t context_num = 0;
+    uint32_t rebuild_flag = 0;
+    uint32_t gen = 1;
+    uint16_t run = 0;
+};
+
+#endif
+
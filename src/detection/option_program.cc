@@ -0,0 +1,287 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// option_program.cc - detection option trees flattened for evaluation
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "option_program.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "framework/cursor.h"
+#include "framework/ips_option.h"
+#include "ips_options/extract.h"
+#include "ips_options/ips_flowbits.h"
+#include "latency/packet_latency.h"
+#include "main/thread.h"
+#include "profiler/rule_profiler_defs.h"
+#include "utils/stats.h"
+
+#include "ips_context.h"
+#include "pattern_match_data.h"
+
+using namespace snort;
+
+//--------------------------------------------------------------------------
+// build
+//--------------------------------------------------------------------------
+
+static bool is_named(const IpsOption* opt, const char* const* names)
+{
+    for ( ; *names; ++names )
+        if ( !strcmp(opt->get_name(), *names) )
+            return true;
+
+    return false;
+}
+
+// options that only return match or no match
+static const char* const test_options[] =
+{ "byte_jump", "byte_test", "isdataat", "pcre", nullptr };
+
+// options known not to change byte_extract vars
+static const char* const fixed_var_options[] =
+{ "byte_jump", "byte_test", "content", "flowbits", "isdataat", "pcre", nullptr };
+
+static bool may_set_vars(const detection_option_tree_node_t* node)
+{
+    if ( node->option_type == RULE_OPTION_TYPE_LEAF_NODE )
+        return false;
+
+    if ( !is_named((IpsOption*)node->option_data, fixed_var_options) )
+        return true;
+
+    for ( int i = 0; i < node->num_children; ++i )
+        if ( may_set_vars(node->children[i]) )
+            return true;
+
+    return false;
+}
+
+OptionProgram* OptionProgram::compile(detection_option_tree_node_t* root)
+{
+    OptionProgram* prog = new OptionProgram;
+    prog->add(root);
+    return prog;
+}
+
+// returns true if the subtree may change byte_extract vars
+bool OptionProgram::add(detection_option_tree_node_t* node)
+{
+    unsigned ix = ops.size();
+    ops.emplace_back();
+
+    Op& op = ops.back();
+    op.node = node;
+    op.pmd = nullptr;
+    op.save_vars = false;
+
+    if ( node->option_type == RULE_OPTION_TYPE_LEAF_NODE )
+    {
+        op.code = OP_LEAF;
+        op.next = ops.size();
+        return false;
+    }
+
+    IpsOption* opt = (IpsOption*)node->option_data;
+
+    if ( !node->evaluate or node->relative_children or
+        (node->option_type == RULE_OPTION_TYPE_FLOWBIT and flowbits_setter(opt)) )
+    {
+        op.code = OP_NODE;
+        op.next = ops.size();
+        return may_set_vars(node);
+    }
+
+    PatternMatchData* pmd = opt->get_pattern(0, RULE_WO_DIR);
+
+    if ( node->option_type == RULE_OPTION_TYPE_CONTENT and pmd and pmd->is_literal() )
+    {
+        op.code = OP_CONTENT;
+        op.pmd = pmd;
+    }
+    else if ( is_named(opt, test_options) )
+        op.code = OP_TEST;
+
+    else
+        op.code = OP_OPTION;
+
+    bool sets_vars = !is_named(opt, fixed_var_options);
+    bool child_vars = false;
+
+    // op is invalid once children are added
+    for ( int i = 0; i < node->num_children; ++i )
+        child_vars = add(node->children[i]) or child_vars;
+
+    ops[ix].next = ops.size();
+    ops[ix].save_vars = child_vars;
+
+    return sets_vars or child_vars;
+}
+
+unsigned OptionProgram::get_inline_count() const
+{
+    unsigned n = 0;
+
+    for ( const auto& op : ops )
+        if ( op.code != OP_LEAF and op.code != OP_NODE )
+            ++n;
+
+    return n;
+}
+
+//--------------------------------------------------------------------------
+// eval
+//--------------------------------------------------------------------------
+
+// this is detection_option_node_evaluate() for a node without retries
+int OptionProgram::exec(
+    unsigned ix, detection_option_eval_data_t& eval_data, const Cursor& orig_cursor) const
+{
+    const Op& op = ops[ix];
+    detection_option_tree_node_t* node = op.node;
+
+    if ( op.code == OP_LEAF or op.code == OP_NODE )
+        return detection_option_node_evaluate(node, eval_data, orig_cursor);
+
+    RuleContext profile(node->state[get_instance_id()]);
+
+    Packet* p = eval_data.p;
+    OptionMemo& memo = p->context->memo;
+    OptionMemo::Entry probe_check = { };
+    OptionMemo::Entry& last_check = eval_data.probe ? probe_check : memo.get(node->node_id);
+
+    if ( !node->is_relative and memo.is_current(last_check) and !last_check.flowbit_failed and
+        !(p->packet_flags & (PKT_ALLOW_MULTIPLE_DETECT | PKT_IP_RULE_2ND)) and
+        !p->is_udp_tunneled() )
+    {
+        pc.option_memo_hits++;
+        return last_check.result;
+    }
+
+    memo.update(last_check, 0);
+
+    Cursor cursor = orig_cursor;
+    int rval = (int)IpsOption::NO_MATCH;
+    int result = 0;
+
+    if ( node->otn and !detection_option_check_otn(node->otn, p) )
+    {
+        if ( eval_data.flowbit_failed )
+            memo.flowbit_failed(last_check);
+
+        profile.stop(false);
+        return 0;
+    }
+
+    switch ( op.code )
+    {
+    case OP_CONTENT:
+        if ( op.pmd->last_check )
+        {
+            // a negated fast pattern was found
+            const PmdLastCheck* content_last = op.pmd->last_check + get_instance_id();
+
+            if ( content_last->ts.tv_sec == p->pkth->ts.tv_sec and
+                content_last->ts.tv_usec == p->pkth->ts.tv_usec and
+                content_last->run_num == get_run_num() and
+                content_last->context_num == p->context->context_num and
+                content_last->rebuild_flag == (p->packet_flags & PKT_REBUILT_STREAM) )
+                return 0;
+        }
+        // fall through
+
+    case OP_TEST:
+        if ( node->evaluate(node->option_data, cursor, p) != (int)IpsOption::MATCH )
+            return 0;
+
+        rval = (int)IpsOption::MATCH;
+        break;
+
+    default:
+        rval = node->evaluate(node->option_data, cursor, p);
+
+        if ( rval == (int)IpsOption::NO_MATCH )
+            return 0;
+
+        if ( rval == (int)IpsOption::FAILED_BIT )
+        {
+            eval_data.flowbit_failed = 1;
+            memo.flowbit_failed(last_check);
+            return 0;
+        }
+        break;
+    }
+
+    char tmp_noalert_flag = eval_data.flowbit_noalert;
+
+    if ( rval == (int)IpsOption::NO_ALERT )
+        eval_data.flowbit_noalert = 1;
+
+    uint32_t tmp_byte_extract_vars[NUM_IPS_OPTIONS_VARS];
+
+    if ( op.save_vars )
+    {
+        for ( unsigned i = 0; i < NUM_IPS_OPTIONS_VARS; ++i )
+            GetVarValueByIndex(&tmp_byte_extract_vars[i], (int8_t)i);
+    }
+
+    if ( PacketLatency::fastpath() )
+    {
+        profile.stop(false);
+        return 0;
+    }
+
+    for ( unsigned c = ix + 1; c < op.next; c = ops[c].next )
+    {
+        if ( op.save_vars )
+        {
+            for ( unsigned i = 0; i < NUM_IPS_OPTIONS_VARS; ++i )
+                SetVarValueByIndex(tmp_byte_extract_vars[i], (int8_t)i);
+        }
+
+        const Op& child = ops[c];
+        int child_result = exec(c, eval_data, cursor);
+
+        // leaves are counted regardless, branches when all of theirs are done
+        if ( child.code == OP_LEAF or child_result == child.node->num_children )
+            ++result;
+
+        if ( PacketLatency::fastpath() )
+        {
+            memo.update(last_check, result);
+            return result;
+        }
+    }
+
+    if ( rval == (int)IpsOption::NO_ALERT )
+        eval_data.flowbit_noalert = tmp_noalert_flag;
+
+    if ( eval_data.flowbit_failed )
+        memo.flowbit_failed(last_check);
+
+    memo.update(last_check, result);
+    profile.stop(result != (int)IpsOption::NO_MATCH);
+
+    return result;
+}
+
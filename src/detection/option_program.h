@@ -0,0 +1,86 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// option_program.h - detection option trees flattened for evaluation
+
+#ifndef OPTION_PROGRAM_H
+#define OPTION_PROGRAM_H
+
+// OptionProgram is a detection option tree laid out as an array of ops in
+// preorder.  each op is followed by its subtree and records where the
+// subtree ends, so children are found by walking the array instead of
+// chasing node pointers.  the op code is chosen when the program is built
+// so evaluation does not rediscover per packet what kind of option it has.
+//
+// nodes that retry relative children or set flowbits keep the looping
+// logic of the tree evaluator, so they and their subtrees are evaluated
+// by detection_option_node_evaluate().  leaves are evaluated the same way.
+// results and side effects are the same as evaluating the tree.
+
+#include <cstdint>
+#include <vector>
+
+#include "detection/detection_options.h"
+
+class Cursor;
+struct PatternMatchData;
+
+class OptionProgram
+{
+public:
+    static OptionProgram* compile(detection_option_tree_node_t*);
+
+    int eval(detection_option_eval_data_t& eval_data, const Cursor& c) const
+    { return exec(0, eval_data, c); }
+
+    unsigned size() const
+    { return ops.size(); }
+
+    // number of options evaluated in place
+    unsigned get_inline_count() const;
+
+private:
+    enum OpCode : uint8_t
+    {
+        OP_LEAF,     // rule, evaluated by the tree
+        OP_NODE,     // subtree evaluated by the tree
+        OP_CONTENT,  // literal content that may be ruled out by a negated fast pattern
+        OP_TEST,     // pcre, byte_test, byte_jump, isdataat; match or no match only
+        OP_OPTION,   // anything else including flowbits checks
+    };
+
+    struct Op
+    {
+        detection_option_tree_node_t* node;
+        PatternMatchData* pmd;  // for OP_CONTENT
+        unsigned next;          // index past this subtree
+        OpCode code;
+        bool save_vars;         // the subtree may change byte_extract vars
+    };
+
+    OptionProgram() = default;
+
+    bool add(detection_option_tree_node_t*);
+    int exec(unsigned, detection_option_eval_data_t&, const Cursor&) const;
+
+private:
+    std::vector<Op> ops;
+};
+
+#endif
+
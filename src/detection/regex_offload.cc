@@ -30,10 +30,12 @@
 #include <chrono>
 #include <condition_variable>
 #include <mutex>
+#include <string>
 #include <vector>
 #include <thread>
 
 #include "fp_detect.h"
+#include "helpers/spsc_ring.h"
 #include "ips_context.h"
 #include "latency/packet_latency.h"
 #include "latency/rule_latency.h"
@@ -63,12 +65,86 @@ struct RegexRequest
     std::atomic<bool> offload { false };
 
     bool go = true;
+
+    // shared pool only
+    PoolRegexOffload* owner = nullptr;
+    std::chrono::steady_clock::time_point queued;
 };
 
-RegexOffload* RegexOffload::get_offloader(unsigned max, bool async)
+// requests go to the worker on one ring and come back on another.  only
+// the packet thread puts requests and takes responses so all rings are
+// single producer, single consumer.
+struct RingOffloadWorker
+{
+    RingOffloadWorker(unsigned depth, bool p) : requests(depth), responses(depth), park(p)
+    { }
+
+    SpscRing<Packet*> requests;
+    SpscRing<Packet*> responses;
+
+    std::thread* thread = nullptr;
+    unsigned pending = 0;  // packet thread only
+
+    // parking is the slow path when there is no work
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::atomic<bool> parked { false };
+    std::atomic<bool> go { true };
+    const bool park;
+};
+
+// polls before an adaptive worker parks
+static constexpr unsigned max_spins = 4096;
+
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// run the search on an offload thread
+static void search_offload(IpsContext* c)
+{
+    SnortConfig::set_conf(c->conf);
+    Mpse::MpseRespType resp_ret;
+
+    c->searches.offload_search();
+
+    do
+    {
+        resp_ret = c->searches.receive_offload_responses();
+    }
+    while (resp_ret == Mpse::MPSE_RESP_NOT_COMPLETE);
+
+    if (resp_ret == Mpse::MPSE_RESP_COMPLETE_FAIL)
+    {
+        if (c->searches.can_fallback())
+        {
+            c->searches.search_sync();
+            pc.offload_fallback++;
+        }
+        pc.offload_failures++;
+    }
+
+    c->searches.items.clear();
+}
+
+RegexOffload* RegexOffload::get_offloader(unsigned max, bool async, OffloadWait wait, bool shared)
 {
     if ( async )
-        return new ThreadRegexOffload(max);
+    {
+        // the shared pool needs at least one thread
+        if ( shared and max )
+            return new PoolRegexOffload(max, wait == OFFLOAD_WAIT_SPIN);
+
+        if ( wait == OFFLOAD_WAIT_BLOCK )
+            return new ThreadRegexOffload(max);
+
+        return new RingRegexOffload(max, wait == OFFLOAD_WAIT_ADAPTIVE);
+    }
 
     return new MpseRegexOffload(max);
 }
@@ -175,6 +251,109 @@ bool MpseRegexOffload::get(Packet*& p)
     return false;
 }
 
+//--------------------------------------------------------------------------
+// batched (on the packet thread) offload implementation
+//--------------------------------------------------------------------------
+
+BatchRegexOffload::BatchRegexOffload(unsigned max, unsigned usecs) :
+    RegexOffload(max), timeout(usecs)
+{
+    held.reserve(max);
+    batches.reserve(max);
+}
+
+void BatchRegexOffload::put(Packet* p)
+{
+    Profile profile(mpsePerfStats);
+
+    assert(p);
+    assert(!idle.empty());
+    assert(p->context->searches.items.size() > 0);
+
+    // engines may differ after reload
+    if ( !held.empty() and held.front()->packet->context->conf != p->context->conf )
+        search();
+
+    RegexRequest* req = idle.front();
+    idle.pop_front();
+
+    busy.emplace_back(req);
+    p->context->regex_req_it = std::prev(busy.end());
+    req->packet = p;
+
+    if ( held.empty() )
+        start = std::chrono::steady_clock::now();
+
+    held.emplace_back(req);
+
+#ifdef REG_TEST
+    search();
+#else
+    if ( idle.empty() )
+        search();
+#endif
+}
+
+bool BatchRegexOffload::get(Packet*& p)
+{
+    Profile profile(mpsePerfStats);
+    assert(!busy.empty());
+
+    if ( done.empty() and !held.empty() and
+        std::chrono::steady_clock::now() - start >= timeout )
+    {
+        pc.batch_timeouts++;
+        search();
+    }
+
+    if ( done.empty() )
+    {
+        p = nullptr;
+        return false;
+    }
+
+    RegexRequest* req = done.front();
+    done.pop_front();
+
+    p = req->packet;
+    req->packet = nullptr;
+
+    busy.erase(p->context->regex_req_it);
+    idle.emplace_back(req);
+
+    return true;
+}
+
+void BatchRegexOffload::flush()
+{
+    if ( !held.empty() )
+        search();
+}
+
+void BatchRegexOffload::search()
+{
+    assert(!held.empty());
+
+    for ( auto* req : held )
+        batches.emplace_back(&req->packet->context->searches);
+
+    Mpse* mpse = batches.front()->items.begin()->second.so[0]->get_normal_mpse();
+    mpse->search(batches.data(), batches.size(), Mpse::MPSE_TYPE_NORMAL);
+
+    for ( auto* b : batches )
+    {
+        while ( b->receive_responses() == Mpse::MPSE_RESP_NOT_COMPLETE );
+        b->items.clear();
+    }
+
+    pc.batch_searches++;
+    pc.batched_packets += held.size();
+
+    done.insert(done.end(), held.begin(), held.end());
+    held.clear();
+    batches.clear();
+}
+
 //--------------------------------------------------------------------------
 // async (threads) offload implementation
 //--------------------------------------------------------------------------
@@ -289,43 +468,482 @@ void ThreadRegexOffload::worker(
         assert(req->packet->is_offloaded());
         assert(req->packet->context->searches.items.size() > 0);
 
-        SnortConfig::set_conf(req->packet->context->conf);
-        IpsContext* c = req->packet->context;
-        Mpse::MpseRespType resp_ret;
+        search_offload(req->packet->context);
+        req->offload = false;
+
+#ifdef REG_TEST
+        {
+            std::unique_lock<std::mutex> lock(req->sync_mutex);
+            req->sync_cond.notify_one();
+        }
+#endif
+    }
+    ModuleManager::accumulate_offload("search_engine");
+    ModuleManager::accumulate_offload("detection");
+
+    // FIXIT-M break this over-coupling. In reality we shouldn't be evaluating latency in offload.
+    PacketLatency::tterm();
+    RuleLatency::tterm();
+}
+
+
+//--------------------------------------------------------------------------
+// async (threads with rings) offload implementation
+//--------------------------------------------------------------------------
 
-        c->searches.offload_search();
+RingRegexOffload::RingRegexOffload(unsigned max, bool park) : RegexOffload(max)
+{
+    unsigned id = ThreadConfig::get_instance_max();
+    const SnortConfig* sc = SnortConfig::get_conf();
+
+    for ( unsigned i = 0; i < max; ++i )
+    {
+        RingOffloadWorker* w = new RingOffloadWorker(max, park);
+        w->thread = new std::thread(worker, w, sc, id++);
+        workers.emplace_back(w);
+    }
+}
+
+RingRegexOffload::~RingRegexOffload()
+{
+    for ( auto* w : workers )
+    {
+        w->thread->join();
+        delete w->thread;
+        delete w;
+    }
+}
+
+void RingRegexOffload::stop()
+{
+    RegexOffload::stop();
+
+    for ( auto* w : workers )
+    {
+        std::unique_lock<std::mutex> lock(w->mutex);
+        w->go = false;
+        w->cond.notify_one();
+    }
+}
+
+void RingRegexOffload::put(Packet* p)
+{
+    Profile profile(mpsePerfStats);
+
+    assert(p);
+    assert(!idle.empty());
+    assert(p->context->searches.items.size() > 0);
+
+    RegexRequest* req = idle.front();
+    idle.pop_front();
+
+    busy.emplace_back(req);
+    p->context->regex_req_it = std::prev(busy.end());
+    req->packet = p;
+
+    // least loaded worker, starting after the last one used
+    RingOffloadWorker* w = nullptr;
+
+    for ( unsigned i = 0; i < workers.size(); ++i )
+    {
+        RingOffloadWorker* c = workers[(next + i) % workers.size()];
+
+        if ( !w or c->pending < w->pending )
+            w = c;
+
+        if ( !w->pending )
+            break;
+    }
+    next = (next + 1) % workers.size();
+
+    // depth is max so the ring can't be full
+    bool ok = w->requests.put(p);
+    assert(ok);
+    UNUSED(ok);
+    w->pending++;
+
+    // pairs with the fence in worker() so a parking worker sees the request
+    // or we see that it parked
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if ( w->parked.load(std::memory_order_relaxed) )
+    {
+        std::unique_lock<std::mutex> lock(w->mutex);
+        w->cond.notify_one();
+    }
+
+#ifdef REG_TEST
+    while ( w->responses.empty() )
+        std::this_thread::yield();
+#endif
+}
+
+bool RingRegexOffload::get(Packet*& p)
+{
+    Profile profile(mpsePerfStats);
+    assert(!busy.empty());
+
+    for ( auto* w : workers )
+    {
+        if ( !w->responses.get(p) )
+            continue;
+
+        w->pending--;
+
+        RegexRequest* req = *(p->context->regex_req_it);
+        assert(req->packet == p);
+        req->packet = nullptr;
+
+        busy.erase(p->context->regex_req_it);
+        idle.emplace_back(req);
+
+        return true;
+    }
 
-        do
+    p = nullptr;
+    return false;
+}
+
+void RingRegexOffload::worker(
+    RingOffloadWorker* w, const SnortConfig* initial_config, unsigned id)
+{
+    set_instance_id(id);
+    SnortConfig::set_conf(initial_config);
+
+    std::string name = "regex_offload_" + std::to_string(id - ThreadConfig::get_instance_max());
+    initial_config->thread_config->implement_named_thread_affinity(name);
+
+    unsigned spins = 0;
+
+    while ( w->go )
+    {
+        Packet* p;
+
+        if ( !w->requests.get(p) )
         {
-            resp_ret = c->searches.receive_offload_responses();
+            if ( !w->park or ++spins < max_spins )
+            {
+                cpu_relax();
+                continue;
+            }
+
+            w->parked = true;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if ( w->requests.empty() )
+            {
+                std::unique_lock<std::mutex> lock(w->mutex);
+                w->cond.wait_for(lock, std::chrono::seconds(1),
+                    [w]() { return !w->requests.empty() or !w->go; });
+            }
+            w->parked = false;
+            spins = 0;
+            continue;
         }
-        while (resp_ret == Mpse::MPSE_RESP_NOT_COMPLETE);
 
-        if (resp_ret == Mpse::MPSE_RESP_COMPLETE_FAIL)
+        assert(p->is_offloaded());
+        assert(p->context->searches.items.size() > 0);
+
+        search_offload(p->context);
+
+        // depth is max so the ring can't be full
+        bool ok = w->responses.put(p);
+        assert(ok);
+        UNUSED(ok);
+        spins = 0;
+    }
+    ModuleManager::accumulate_offload("search_engine");
+    ModuleManager::accumulate_offload("detection");
+
+    PacketLatency::tterm();
+    RuleLatency::tterm();
+}
+
+//--------------------------------------------------------------------------
+// shared pool offload implementation
+//
+// the pool is created by the first packet thread and deleted by the last.
+// each packet thread queues to the deque of its home worker.  workers take
+// from the front of their own deque and when that runs dry steal from the
+// back of the fullest deque so one busy packet thread can use all workers.
+// results go back to the owning packet thread's done queue.
+//--------------------------------------------------------------------------
+
+struct PoolQueue
+{
+    std::deque<RegexRequest*> tbd;
+    std::mutex mutex;
+};
+
+class OffloadPool
+{
+public:
+    OffloadPool(unsigned n, bool spin, const SnortConfig*);
+    ~OffloadPool();
+
+    unsigned size() const
+    { return queues.size(); }
+
+    // returns the number of requests queued
+    unsigned put(RegexRequest*, unsigned q);
+
+private:
+    RegexRequest* get(unsigned q, bool& stolen);
+    static void worker(OffloadPool*, unsigned q, const SnortConfig*, unsigned id);
+
+private:
+    std::vector<PoolQueue> queues;
+    std::vector<std::thread> threads;
+
+    std::atomic<unsigned> queued { 0 };
+    std::atomic<unsigned> sleepers { 0 };
+    std::atomic<bool> go { true };
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    const bool spin;
+};
+
+static OffloadPool* s_pool = nullptr;
+static unsigned s_pool_users = 0;
+static std::mutex s_pool_mutex;
+
+OffloadPool::OffloadPool(unsigned n, bool s, const SnortConfig* sc) : queues(n), spin(s)
+{
+    unsigned id = ThreadConfig::get_instance_max();
+
+    for ( unsigned i = 0; i < n; ++i )
+        threads.emplace_back(worker, this, i, sc, id++);
+}
+
+OffloadPool::~OffloadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        go = false;
+        cond.notify_all();
+    }
+    for ( auto& t : threads )
+        t.join();
+
+    assert(!queued);
+}
+
+unsigned OffloadPool::put(RegexRequest* req, unsigned q)
+{
+    {
+        std::lock_guard<std::mutex> lock(queues[q].mutex);
+        queues[q].tbd.emplace_back(req);
+    }
+    unsigned depth = ++queued;
+
+    // pairs with the sleepers increment in worker() so either we see the
+    // sleeper or it sees the request
+    if ( sleepers )
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cond.notify_one();
+    }
+    return depth;
+}
+
+RegexRequest* OffloadPool::get(unsigned q, bool& stolen)
+{
+    stolen = false;
+
+    if ( !queued )
+        return nullptr;
+
+    {
+        std::lock_guard<std::mutex> lock(queues[q].mutex);
+
+        if ( !queues[q].tbd.empty() )
         {
-            if (c->searches.can_fallback())
+            RegexRequest* req = queues[q].tbd.front();
+            queues[q].tbd.pop_front();
+            --queued;
+            return req;
+        }
+    }
+
+    while ( true )
+    {
+        PoolQueue* victim = nullptr;
+        size_t most = 0;
+
+        // sizes are only a hint; the pop below is checked under the lock
+        for ( auto& pq : queues )
+        {
+            std::lock_guard<std::mutex> lock(pq.mutex);
+
+            if ( pq.tbd.size() > most )
             {
-                c->searches.search_sync();
-                pc.offload_fallback++;
+                most = pq.tbd.size();
+                victim = &pq;
             }
-            pc.offload_failures++;
         }
 
-        c->searches.items.clear();
-        req->offload = false;
+        if ( !victim )
+            return nullptr;
 
-#ifdef REG_TEST
+        std::lock_guard<std::mutex> lock(victim->mutex);
+
+        if ( victim->tbd.empty() )
+            continue;
+
+        RegexRequest* req = victim->tbd.back();
+        victim->tbd.pop_back();
+        --queued;
+        stolen = true;
+        return req;
+    }
+}
+
+void OffloadPool::worker(OffloadPool* pool, unsigned q, const SnortConfig* sc, unsigned id)
+{
+    set_instance_id(id);
+    SnortConfig::set_conf(sc);
+
+    std::string name = "regex_offload_" + std::to_string(q);
+    sc->thread_config->implement_named_thread_affinity(name);
+
+    unsigned spins = 0;
+
+    while ( pool->go )
+    {
+        bool stolen;
+        RegexRequest* req = pool->get(q, stolen);
+
+        if ( !req )
         {
-            std::unique_lock<std::mutex> lock(req->sync_mutex);
-            req->sync_cond.notify_one();
+            if ( pool->spin or ++spins < max_spins )
+            {
+                cpu_relax();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            ++pool->sleepers;
+
+            pool->cond.wait_for(lock, std::chrono::seconds(1),
+                [pool]() { return pool->queued or !pool->go; });
+
+            --pool->sleepers;
+            spins = 0;
+            continue;
         }
-#endif
+
+        if ( stolen )
+            pc.offload_steals++;
+
+        assert(req->packet->is_offloaded());
+        assert(req->packet->context->searches.items.size() > 0);
+
+        search_offload(req->packet->context);
+        req->owner->complete(req);
+        spins = 0;
     }
     ModuleManager::accumulate_offload("search_engine");
     ModuleManager::accumulate_offload("detection");
 
-    // FIXIT-M break this over-coupling. In reality we shouldn't be evaluating latency in offload.
     PacketLatency::tterm();
     RuleLatency::tterm();
 }
 
+PoolRegexOffload::PoolRegexOffload(unsigned max, bool spin) : RegexOffload(max)
+{
+    std::lock_guard<std::mutex> lock(s_pool_mutex);
+
+    if ( !s_pool_users++ )
+        s_pool = new OffloadPool(max, spin, SnortConfig::get_conf());
+
+    home = get_instance_id() % s_pool->size();
+
+    for ( auto* req : idle )
+        req->owner = this;
+}
+
+PoolRegexOffload::~PoolRegexOffload()
+{
+    assert(done.empty());
+    std::lock_guard<std::mutex> lock(s_pool_mutex);
+
+    if ( !--s_pool_users )
+    {
+        delete s_pool;
+        s_pool = nullptr;
+    }
+}
+
+void PoolRegexOffload::put(Packet* p)
+{
+    Profile profile(mpsePerfStats);
+
+    assert(p);
+    assert(!idle.empty());
+    assert(p->context->searches.items.size() > 0);
+
+    RegexRequest* req = idle.front();
+    idle.pop_front();
+
+    busy.emplace_back(req);
+    p->context->regex_req_it = std::prev(busy.end());
+
+    req->packet = p;
+    req->queued = std::chrono::steady_clock::now();
+
+    unsigned depth = s_pool->put(req, home);
+
+    if ( depth > pc.offload_max_depth )
+        pc.offload_max_depth = depth;
+
+#ifdef REG_TEST
+    while ( !num_done )
+        std::this_thread::yield();
+#endif
+}
+
+bool PoolRegexOffload::get(Packet*& p)
+{
+    Profile profile(mpsePerfStats);
+    assert(!busy.empty());
+
+    if ( !num_done )
+    {
+        p = nullptr;
+        return false;
+    }
+
+    RegexRequest* req;
+    {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        req = done.front();
+        done.pop_front();
+        --num_done;
+    }
+
+    auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - req->queued).count();
+
+    pc.offload_usecs += usecs;
+
+    if ( (PegCount)usecs > pc.offload_max_usecs )
+        pc.offload_max_usecs = usecs;
+
+    p = req->packet;
+    assert(*(p->context->regex_req_it) == req);
+    req->packet = nullptr;
+
+    busy.erase(p->context->regex_req_it);
+    idle.emplace_back(req);
+
+    return true;
+}
+
+void PoolRegexOffload::complete(RegexRequest* req)
+{
+    std::lock_guard<std::mutex> lock(done_mutex);
+    done.emplace_back(req);
+    ++num_done;
+}
+
@@ -25,26 +25,42 @@
 // There are two flavors: MPSE and thread.  The MpseRegexOffload interfaces to
 // an MPSE that is capable of regex offload such as the RXP whereas
 // ThreadRegexOffload implements the regex search in auxiliary threads w/o
-// requiring extra MPSE instances.  presently all offload is per packet thread;
-// packet threads do not share offload resources.
+// requiring extra MPSE instances.  RingRegexOffload also uses auxiliary
+// threads but hands off requests and results through lock-free rings
+// instead of a mutex and condition per request.  PoolRegexOffload submits
+// to a process wide pool of threads shared by all packet threads; idle
+// threads steal work queued for busy ones.  otherwise offload is per packet
+// thread and packet threads do not share offload resources.
+//
+// BatchRegexOffload doesn't use other threads.  it holds the searches of
+// several packets and runs them together on the packet thread when the
+// batch fills, times out, or the daq batch ends.
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <list>
 #include <mutex>
 #include <thread>
+#include <vector>
+
+#include "main/snort_config.h"
 
 namespace snort
 {
 class Flow;
+struct MpseBatch;
 struct Packet;
-struct SnortConfig;
 }
 struct RegexRequest;
+struct RingOffloadWorker;
 
 class RegexOffload
 {
 public:
-    static RegexOffload* get_offloader(unsigned max, bool async);
+    static RegexOffload* get_offloader(
+        unsigned max, bool async, OffloadWait = OFFLOAD_WAIT_BLOCK, bool shared = false);
     virtual ~RegexOffload();
 
     virtual void stop();
@@ -52,6 +68,9 @@ public:
     virtual void put(snort::Packet*) = 0;
     virtual bool get(snort::Packet*&) = 0;
 
+    // start any held searches
+    virtual void flush() { }
+
     unsigned available() const
     { return idle.size(); }
 
@@ -92,5 +111,63 @@ private:
     static void worker(RegexRequest*, const snort::SnortConfig*, unsigned id);
 };
 
+class RingRegexOffload : public RegexOffload
+{
+public:
+    RingRegexOffload(unsigned max, bool park);
+    ~RingRegexOffload() override;
+
+    void stop() override;
+
+    void put(snort::Packet*) override;
+    bool get(snort::Packet*&) override;
+
+private:
+    static void worker(RingOffloadWorker*, const snort::SnortConfig*, unsigned id);
+
+private:
+    std::vector<RingOffloadWorker*> workers;
+    unsigned next = 0;
+};
+
+class BatchRegexOffload : public RegexOffload
+{
+public:
+    BatchRegexOffload(unsigned max, unsigned usecs);
+
+    void put(snort::Packet*) override;
+    bool get(snort::Packet*&) override;
+    void flush() override;
+
+private:
+    void search();
+
+private:
+    std::vector<RegexRequest*> held;
+    std::vector<snort::MpseBatch*> batches;
+    std::deque<RegexRequest*> done;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::microseconds timeout;
+};
+
+class PoolRegexOffload : public RegexOffload
+{
+public:
+    PoolRegexOffload(unsigned max, bool spin);
+    ~PoolRegexOffload() override;
+
+    void put(snort::Packet*) override;
+    bool get(snort::Packet*&) override;
+
+    // called by pool threads
+    void complete(RegexRequest*);
+
+private:
+    std::deque<RegexRequest*> done;
+    std::mutex done_mutex;
+    std::atomic<unsigned> num_done { 0 };
+    unsigned home;
+};
+
 #endif
 
@@ -0,0 +1,396 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// regex_prefilter.cc - batch hyperscan prefilter for regex options
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "regex_prefilter.h"
+
+#include <hs_compile.h>
+#include <hs_runtime.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <unordered_map>
+
+#include "framework/ips_option.h"
+#include "hash/ghash.h"
+#include "helpers/hyper_scratch_allocator.h"
+#include "log/messages.h"
+#include "main/snort_config.h"
+#include "protocols/packet.h"
+#include "target_based/snort_protocols.h"
+#include "utils/stats.h"
+
+#include "ips_context.h"
+#include "ips_context_data.h"
+#include "treenodes.h"
+
+using namespace snort;
+
+static HyperScratchAllocator* scratcher = nullptr;
+static unsigned ips_id = 0;
+
+namespace snort
+{
+struct PrefilterGroup
+{
+    std::unordered_map<const IpsOption*, unsigned> ids;
+    std::vector<const char*> exprs;  // only during build
+    std::vector<unsigned> flags;
+    hs_database_t* db = nullptr;
+
+    ~PrefilterGroup()
+    {
+        if ( db )
+            hs_free_database(db);
+    }
+
+    void add(const IpsOption* opt, const char* re, unsigned f)
+    {
+        if ( ids.find(opt) != ids.end() )
+            return;
+
+        ids[opt] = exprs.size();
+        exprs.emplace_back(re);
+        flags.emplace_back(f | HS_FLAG_PREFILTER | HS_FLAG_SINGLEMATCH);
+    }
+
+    bool compile();
+};
+
+bool PrefilterGroup::compile()
+{
+    std::vector<unsigned> hs_ids;
+
+    for ( unsigned i = 0; i < exprs.size(); ++i )
+        hs_ids.emplace_back(i);
+
+    hs_compile_error_t* err = nullptr;
+
+    if ( hs_compile_multi(exprs.data(), flags.data(), hs_ids.data(), exprs.size(),
+        HS_MODE_BLOCK, nullptr, &db, &err) or !db )
+    {
+        ParseWarning(WARN_RULES, "can't compile pcre prefilter: %s",
+            (err and err->message) ? err->message : "unknown error");
+
+        hs_free_compile_error(err);
+        return false;
+    }
+
+    exprs.clear();
+    exprs.shrink_to_fit();
+    flags.clear();
+    flags.shrink_to_fit();
+
+    if ( !scratcher->allocate(db) )
+    {
+        ParseWarning(WARN_RULES, "can't allocate scratch for pcre prefilter");
+        return false;
+    }
+    return true;
+}
+}
+
+//-------------------------------------------------------------------------
+// scans are kept per context and cleared with the packet
+//-------------------------------------------------------------------------
+
+class PrefilterScans : public IpsContextData
+{
+public:
+    struct Scan
+    {
+        const PrefilterGroup* group;
+        const uint8_t* buf;
+        unsigned len;
+        std::vector<uint64_t> bits;
+    };
+
+    void clear() override
+    { count = next = 0; }
+
+    const std::vector<uint64_t>& get(const PrefilterGroup*, const uint8_t* buf, unsigned len);
+
+private:
+    static constexpr unsigned max_scans = 8;
+    Scan scans[max_scans];
+    unsigned count = 0;
+    unsigned next = 0;
+};
+
+static int prefilter_match(
+    unsigned int id, unsigned long long /*from*/, unsigned long long /*to*/,
+    unsigned int /*flags*/, void* context)
+{
+    std::vector<uint64_t>& bits = *(std::vector<uint64_t>*)context;
+    bits[id >> 6] |= (uint64_t)1 << (id & 63);
+    return 0;
+}
+
+const std::vector<uint64_t>& PrefilterScans::get(
+    const PrefilterGroup* g, const uint8_t* buf, unsigned len)
+{
+    for ( unsigned i = 0; i < count; ++i )
+    {
+        const Scan& s = scans[i];
+
+        if ( s.group == g and s.buf == buf and s.len == len )
+            return s.bits;
+    }
+
+    // with more buffers than slots the oldest scan is replaced
+    Scan& s = scans[next];
+    next = (next + 1) % max_scans;
+
+    if ( count < max_scans )
+        ++count;
+
+    s.group = g;
+    s.buf = buf;
+    s.len = len;
+    s.bits.assign((g->ids.size() + 63) / 64, 0);
+
+    pc.pcre_prefilter_scans++;
+
+    if ( hs_scan(g->db, (const char*)buf, len, 0, scratcher->get(), prefilter_match, &s.bits)
+        != HS_SUCCESS )
+    {
+        // can't tell so nothing is skipped
+        s.bits.assign(s.bits.size(), ~(uint64_t)0);
+    }
+    return s.bits;
+}
+
+//-------------------------------------------------------------------------
+// build
+//-------------------------------------------------------------------------
+
+// incompatible regexes and those that can match nothing are left out
+static bool compatible(const char* re, unsigned flags)
+{
+    hs_expr_info_t* info = nullptr;
+    hs_compile_error_t* err = nullptr;
+
+    if ( hs_expression_info(re, flags | HS_FLAG_PREFILTER, &info, &err) != HS_SUCCESS )
+    {
+        hs_free_compile_error(err);
+        return false;
+    }
+
+    bool ok = info and info->min_width > 0;
+    free(info);
+
+    return ok;
+}
+
+RegexPrefilter* RegexPrefilter::build(SnortConfig* sc)
+{
+    if ( !sc->otn_map )
+        return nullptr;
+
+    RegexPrefilter* rp = new RegexPrefilter;
+    rp->services.resize(sc->proto_ref->get_count(), nullptr);
+
+    std::unordered_map<const IpsOption*, bool> checked;
+    unsigned regexes = 0, incompatible = 0;
+
+    for ( auto* h = sc->otn_map->find_first(); h; h = sc->otn_map->find_next() )
+    {
+        const OptTreeNode* otn = (const OptTreeNode*)h->data;
+
+        for ( const OptFpList* ofl = otn->opt_func; ofl; ofl = ofl->next )
+        {
+            unsigned flags = 0;
+            const char* re = ofl->ips_opt ? ofl->ips_opt->get_prefilter(flags) : nullptr;
+
+            if ( !re )
+                continue;
+
+            auto it = checked.find(ofl->ips_opt);
+
+            if ( it == checked.end() )
+            {
+                bool ok = compatible(re, flags);
+                it = checked.emplace(ofl->ips_opt, ok).first;
+
+                if ( ok )
+                    ++regexes;
+                else
+                    ++incompatible;
+            }
+
+            if ( !it->second )
+                continue;
+
+            if ( otn->sigInfo.services.empty() )
+            {
+                if ( !rp->any )
+                    rp->any = new PrefilterGroup;
+
+                rp->any->add(ofl->ips_opt, re, flags);
+                continue;
+            }
+
+            for ( const auto& svc : otn->sigInfo.services )
+            {
+                if ( svc.snort_protocol_id >= rp->services.size() )
+                    continue;
+
+                PrefilterGroup*& g = rp->services[svc.snort_protocol_id];
+
+                if ( !g )
+                    g = new PrefilterGroup;
+
+                g->add(ofl->ips_opt, re, flags);
+            }
+        }
+    }
+
+    unsigned dbs = 0;
+
+    for ( auto*& g : rp->services )
+    {
+        if ( g and !g->compile() )
+        {
+            delete g;
+            g = nullptr;
+        }
+        if ( g )
+            ++dbs;
+    }
+
+    if ( rp->any and !rp->any->compile() )
+    {
+        delete rp->any;
+        rp->any = nullptr;
+    }
+    if ( rp->any )
+        ++dbs;
+
+    LogLabel("pcre prefilter");
+    LogCount("databases", dbs);
+    LogCount("regexes", regexes);
+    LogCount("incompatible", incompatible);
+
+    if ( !dbs )
+    {
+        delete rp;
+        return nullptr;
+    }
+
+    if ( !ips_id )
+        ips_id = IpsContextData::get_ips_id();
+
+    return rp;
+}
+
+RegexPrefilter::~RegexPrefilter()
+{
+    for ( auto* g : services )
+        delete g;
+
+    delete any;
+}
+
+void RegexPrefilter::init()
+{ scratcher = new HyperScratchAllocator; }
+
+void RegexPrefilter::term()
+{
+    delete scratcher;
+    scratcher = nullptr;
+}
+
+//-------------------------------------------------------------------------
+// packet threads
+//-------------------------------------------------------------------------
+
+const PrefilterGroup* RegexPrefilter::get_group(
+    Packet* p, const IpsOption* opt, unsigned& id) const
+{
+    SnortProtocolId svc = p->get_snort_protocol_id();
+
+    if ( svc < services.size() and services[svc] )
+    {
+        const PrefilterGroup* g = services[svc];
+        auto it = g->ids.find(opt);
+
+        if ( it != g->ids.end() )
+        {
+            id = it->second;
+            return g;
+        }
+    }
+
+    if ( any )
+    {
+        auto it = any->ids.find(opt);
+
+        if ( it != any->ids.end() )
+        {
+            id = it->second;
+            return any;
+        }
+    }
+    return nullptr;
+}
+
+bool RegexPrefilter::skip(Packet* p, const IpsOption* opt, const uint8_t* buf, unsigned len)
+{
+    const RegexPrefilter* rp = p->context->conf->regex_prefilter;
+
+    if ( !rp )
+        return false;
+
+    unsigned id;
+    const PrefilterGroup* g = rp->get_group(p, opt, id);
+
+    if ( !g )
+        return false;
+
+    PrefilterScans* ps = (PrefilterScans*)p->context->get_context_data(ips_id);
+
+    if ( !ps )
+    {
+        ps = new PrefilterScans;
+        p->context->set_context_data(ips_id, ps);
+    }
+
+    const std::vector<uint64_t>& bits = ps->get(g, buf, len);
+
+    if ( bits[id >> 6] & ((uint64_t)1 << (id & 63)) )
+        return false;
+
+    pc.pcre_prefilter_skips++;
+    return true;
+}
+
+void RegexPrefilter::rewritten(IpsContext* c)
+{
+    if ( !ips_id )
+        return;
+
+    PrefilterScans* ps = (PrefilterScans*)c->get_context_data(ips_id);
+
+    if ( ps )
+        ps->clear();
+}
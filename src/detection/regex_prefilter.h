@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// regex_prefilter.h - batch hyperscan prefilter for regex options
+
+#ifndef REGEX_PREFILTER_H
+#define REGEX_PREFILTER_H
+
+// the regexes of all rules for a service are compiled into one hyperscan
+// database with HS_FLAG_PREFILTER; rules without services share another.
+// the first check of an option on a buffer scans the whole buffer once and
+// the result is kept in the ips context for the other options checked on
+// the same buffer.  if the option's regex wasn't reported it can't match
+// so the option can skip its own engine.  prefilter matches may be false
+// positives but there are no false negatives.
+//
+// options provide their regex with IpsOption::get_prefilter().  the result
+// only applies if the option searches the whole buffer, ie it isn't
+// relative to the cursor.
+//
+// scans are keyed by buffer address and length so anything that rewrites a
+// buffer in place during detection, like base64_decode or a new file_data,
+// must call rewritten() to drop them.
+
+#include <cstdint>
+#include <vector>
+
+#include "main/snort_types.h"
+
+namespace snort
+{
+class IpsContext;
+class IpsOption;
+struct Packet;
+struct SnortConfig;
+
+struct PrefilterGroup;
+
+class SO_PUBLIC RegexPrefilter
+{
+public:
+    ~RegexPrefilter();
+
+    // main thread; returns nullptr if there is nothing to prefilter
+    static RegexPrefilter* build(SnortConfig*);
+
+    // packet threads; true if the option can't match the buffer
+    static bool skip(Packet*, const IpsOption*, const uint8_t* buf, unsigned len);
+
+    // packet threads; drop the scans of the context's buffers
+    static void rewritten(IpsContext*);
+
+    static void init();
+    static void term();
+
+private:
+    RegexPrefilter() = default;
+
+    const PrefilterGroup* get_group(Packet*, const IpsOption*, unsigned& id) const;
+
+private:
+    std::vector<PrefilterGroup*> services;  // indexed by SnortProtocolId
+    PrefilterGroup* any = nullptr;          // rules without services
+};
+}
+
+#endif
@@ -0,0 +1,409 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// option_program_test.cc - flattened option tree checks and benchmarks
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/catch.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include "detection/ips_context.h"
+#include "detection/option_program.h"
+#include "framework/cursor.h"
+#include "framework/ips_option.h"
+#include "ips_options/extract.h"
+#include "ips_options/ips_flowbits.h"
+#include "latency/packet_latency.h"
+#include "main/thread.h"
+#include "profiler/rule_profiler_defs.h"
+#include "utils/stats.h"
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// stubs
+//-------------------------------------------------------------------------
+
+static uint32_t vars[NUM_IPS_OPTIONS_VARS];
+static std::vector<detection_option_tree_node_t*> delegated;
+static unsigned leaf_matches = 0;
+
+namespace snort
+{
+THREAD_LOCAL PacketCount pc;
+
+void mix_str(uint32_t& a, uint32_t&, uint32_t&, const char* s, unsigned)
+{ a += strlen(s); }
+
+unsigned get_instance_id() { return 0; }
+
+int GetVarValueByIndex(uint32_t* dst, uint8_t n)
+{ *dst = vars[n]; return 0; }
+
+int SetVarValueByIndex(uint32_t value, uint8_t n)
+{ vars[n] = value; return 0; }
+
+IpsContext::IpsContext(unsigned) { }
+IpsContext::~IpsContext() = default;
+
+Packet::Packet(bool) { }
+Packet::~Packet() = default;
+}
+
+uint16_t get_run_num() { return 0; }
+
+bool PacketLatency::fastpath() { return false; }
+
+bool RuleContext::enabled = false;
+void RuleContext::stop(bool) { }
+
+bool flowbits_setter(void*) { return false; }
+
+bool detection_option_check_otn(OptTreeNode*, Packet*) { return true; }
+
+Cursor::Cursor(Packet* p)
+{ set("pkt_data", p->data, p->dsize); }
+
+Cursor::Cursor(const Cursor& rhs)
+{
+    name = rhs.name;
+    buf = rhs.buf;
+    sz = rhs.sz;
+    pos = rhs.pos;
+}
+
+// leaves match; anything else must have been delegated
+int detection_option_node_evaluate(
+    detection_option_tree_node_t* node, detection_option_eval_data_t& eval_data, const Cursor&)
+{
+    if ( node->option_type != RULE_OPTION_TYPE_LEAF_NODE )
+    {
+        delegated.emplace_back(node);
+        return 0;
+    }
+
+    if ( eval_data.probe )
+        eval_data.probe->emplace_back((OptTreeNode*)node->option_data);
+    else
+        ++leaf_matches;
+
+    return 1;
+}
+
+//-------------------------------------------------------------------------
+// helpers
+//-------------------------------------------------------------------------
+
+// matches if the byte at off is val
+class ByteOption : public IpsOption
+{
+public:
+    ByteOption(const char* s, unsigned o, uint8_t v) : IpsOption(s), off(o), val(v) { }
+
+    EvalStatus eval(Cursor& c, Packet*) override
+    {
+        ++evals;
+        return (off < c.size() and c.buffer()[off] == val) ? MATCH : NO_MATCH;
+    }
+
+    unsigned evals = 0;
+
+private:
+    unsigned off;
+    uint8_t val;
+};
+
+// always matches after changing var 0
+class SetVarOption : public IpsOption
+{
+public:
+    SetVarOption() : IpsOption("byte_extract") { }
+
+    EvalStatus eval(Cursor&, Packet*) override
+    { vars[0] = 99; return MATCH; }
+};
+
+// matches if var 0 is still its initial value
+class GetVarOption : public IpsOption
+{
+public:
+    GetVarOption() : IpsOption("byte_math") { }
+
+    EvalStatus eval(Cursor&, Packet*) override
+    { return vars[0] == 1 ? MATCH : NO_MATCH; }
+};
+
+static int eval_option(void* v, Cursor& c, Packet* p)
+{ return ((IpsOption*)v)->eval(c, p); }
+
+class Tree
+{
+public:
+    ~Tree()
+    {
+        for ( auto* n : nodes )
+        {
+            delete n->program;
+            delete[] n->children;
+            delete[] n->state;
+            delete n;
+        }
+        for ( auto* o : opts )
+            delete o;
+    }
+
+    detection_option_tree_node_t* node(
+        IpsOption* opt, std::vector<detection_option_tree_node_t*> kids = { })
+    {
+        opts.emplace_back(opt);
+        auto* n = add(kids);
+        n->option_type = opt->get_type();
+        n->option_data = opt;
+        n->evaluate = eval_option;
+        return n;
+    }
+
+    detection_option_tree_node_t* leaf()
+    {
+        auto* n = add({ });
+        n->option_type = RULE_OPTION_TYPE_LEAF_NODE;
+        n->option_data = (void*)(uintptr_t)nodes.size();
+        return n;
+    }
+
+private:
+    detection_option_tree_node_t* add(const std::vector<detection_option_tree_node_t*>& kids)
+    {
+        auto* n = new detection_option_tree_node_t();
+        n->state = new dot_node_state_t[1]();
+        n->node_id = nodes.size();
+        n->num_children = kids.size();
+        n->children = new detection_option_tree_node_t*[kids.size() + 1];
+
+        for ( unsigned i = 0; i < kids.size(); ++i )
+            n->children[i] = kids[i];
+
+        nodes.emplace_back(n);
+        return n;
+    }
+
+public:
+    std::vector<detection_option_tree_node_t*> nodes;
+    std::vector<IpsOption*> opts;
+};
+
+struct TestPacket
+{
+    TestPacket(const char* s)
+    {
+        memset((void*)&pkth, 0, sizeof(pkth));
+        p.context = &context;
+        p.pkth = &pkth;
+        p.packet_flags = 0;
+        p.proto_bits = 0;
+        p.data = (const uint8_t*)s;
+        p.dsize = strlen(s);
+        context.context_num = 1;
+    }
+
+    // the memo starts over
+    void next(unsigned n)
+    {
+        ++context.context_num;
+        context.memo.start(&p, context.context_num, n, 0);
+    }
+
+    IpsContext context;
+    DAQ_PktHdr_t pkth;
+    Packet p { false };
+};
+
+static detection_option_eval_data_t get_eval_data(Packet* p)
+{
+    detection_option_eval_data_t eval_data;
+    eval_data.pmd = nullptr;
+    eval_data.p = p;
+    eval_data.flowbit_failed = 0;
+    eval_data.flowbit_noalert = 0;
+    eval_data.probe = nullptr;
+    return eval_data;
+}
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+TEST_CASE("program layout", "[option_program]")
+{
+    Tree t;
+    auto* l1 = t.leaf();
+    auto* l2 = t.leaf();
+    auto* b = t.node(new ByteOption("byte_test", 1, 'b'), { l1 });
+    auto* c = t.node(new ByteOption("pcre", 2, 'x'), { l2 });
+    auto* a = t.node(new ByteOption("custom", 0, 'a'), { b, c });
+
+    OptionProgram* prog = OptionProgram::compile(a);
+    a->program = prog;
+
+    CHECK(prog->size() == 5);
+    CHECK(prog->get_inline_count() == 3);
+}
+
+TEST_CASE("program eval", "[option_program]")
+{
+    Tree t;
+    auto* l1 = t.leaf();
+    auto* l2 = t.leaf();
+    auto* l3 = t.leaf();
+    auto* bo = new ByteOption("byte_test", 1, 'b');
+    auto* b = t.node(bo, { l1 });
+    auto* c = t.node(new ByteOption("pcre", 2, 'x'), { l2 });
+    auto* a = t.node(new ByteOption("isdataat", 0, 'a'), { b, c, l3 });
+
+    a->program = OptionProgram::compile(a);
+
+    TestPacket tp("abc");
+    tp.next(t.nodes.size());
+
+    SECTION("probe")
+    {
+        std::vector<const OptTreeNode*> rules;
+        auto eval_data = get_eval_data(&tp.p);
+        eval_data.probe = &rules;
+
+        // b and l3 are done, c is not
+        CHECK(a->program->eval(eval_data, Cursor(&tp.p)) == 2);
+
+        REQUIRE(rules.size() == 2);
+        CHECK(rules[0] == (OptTreeNode*)l1->option_data);
+        CHECK(rules[1] == (OptTreeNode*)l3->option_data);
+        CHECK(leaf_matches == 0);
+    }
+    SECTION("memo")
+    {
+        auto eval_data = get_eval_data(&tp.p);
+        leaf_matches = 0;
+        pc.option_memo_hits = 0;
+
+        CHECK(a->program->eval(eval_data, Cursor(&tp.p)) == 2);
+        CHECK(leaf_matches == 2);
+        CHECK(bo->evals == 1);
+
+        // same packet
+        CHECK(a->program->eval(eval_data, Cursor(&tp.p)) == 2);
+        CHECK(pc.option_memo_hits == 1);
+        CHECK(bo->evals == 1);
+
+        // new packet
+        tp.next(t.nodes.size());
+        CHECK(a->program->eval(eval_data, Cursor(&tp.p)) == 2);
+        CHECK(pc.option_memo_hits == 1);
+        CHECK(bo->evals == 2);
+    }
+}
+
+TEST_CASE("program delegates retries", "[option_program]")
+{
+    Tree t;
+    auto* l1 = t.leaf();
+    auto* r = t.node(new ByteOption("byte_jump", 1, 'b'), { l1 });
+    auto* a = t.node(new ByteOption("byte_test", 0, 'a'), { r });
+
+    r->relative_children = 1;
+    a->program = OptionProgram::compile(a);
+
+    // r and its subtree are one op
+    CHECK(a->program->size() == 2);
+    CHECK(a->program->get_inline_count() == 1);
+
+    TestPacket tp("ab");
+    tp.next(t.nodes.size());
+    delegated.clear();
+
+    auto eval_data = get_eval_data(&tp.p);
+    a->program->eval(eval_data, Cursor(&tp.p));
+
+    REQUIRE(delegated.size() == 1);
+    CHECK(delegated[0] == r);
+}
+
+TEST_CASE("program restores vars", "[option_program]")
+{
+    Tree t;
+    auto* l1 = t.leaf();
+    auto* l2 = t.leaf();
+    auto* set = t.node(new SetVarOption, { l1 });
+    auto* get = t.node(new GetVarOption, { l2 });
+    auto* a = t.node(new ByteOption("byte_test", 0, 'a'), { set, get });
+
+    a->program = OptionProgram::compile(a);
+
+    TestPacket tp("a");
+    tp.next(t.nodes.size());
+
+    vars[0] = 1;
+    std::vector<const OptTreeNode*> rules;
+    auto eval_data = get_eval_data(&tp.p);
+    eval_data.probe = &rules;
+
+    // get sees the value from before set
+    CHECK(a->program->eval(eval_data, Cursor(&tp.p)) == 2);
+    CHECK(rules.size() == 2);
+}
+
+//-------------------------------------------------------------------------
+// benchmarks
+//-------------------------------------------------------------------------
+
+#ifdef BENCHMARK_TEST
+
+// 64 rules of 4 options each, half of which fail at the last option
+TEST_CASE("program throughput", "[option_program]")
+{
+    Tree t;
+    std::vector<detection_option_tree_node_t*> rules;
+
+    for ( unsigned i = 0; i < 64; ++i )
+    {
+        auto* n = t.leaf();
+        n = t.node(new ByteOption("byte_test", 3, (i % 2) ? 'd' : 'x'), { n });
+        n = t.node(new ByteOption("isdataat", 2, 'c'), { n });
+        n = t.node(new ByteOption("pcre", 1, 'b'), { n });
+        rules.emplace_back(n);
+    }
+    auto* root = t.node(new ByteOption("byte_jump", 0, 'a'), rules);
+    root->program = OptionProgram::compile(root);
+
+    TestPacket tp("abcd");
+    auto eval_data = get_eval_data(&tp.p);
+    Cursor c(&tp.p);
+
+    BENCHMARK("64 rules")
+    {
+        tp.next(t.nodes.size());
+        return root->program->eval(eval_data, c);
+    };
+}
+
+#endif
+
@@ -122,6 +122,12 @@ void FileCache::set_max_files(int64_t max)
     fileHash->set_max_nodes(max_files);
 }
 
+size_t FileCache::get_mem_used()
+{
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return fileHash->get_mem_used() + fileHash->get_num_nodes() * sizeof(FileContext);
+}
+
 FileContext* FileCache::add(const FileHashKey& hashKey, int64_t timeout)
 {
     FileNode new_node;
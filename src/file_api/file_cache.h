@@ -60,6 +60,9 @@ PADDING_GUARD_END
     void set_lookup_timeout(int64_t);
     void set_max_files(int64_t);
 
+    // bytes held by the cached file contexts
+    size_t get_mem_used();
+
     snort::FileContext* get_file(snort::Flow*, uint64_t file_id, bool to_create);
     FileVerdict cached_verdict_lookup(snort::Packet*, snort::FileInfo*,
         snort::FilePolicyBase*);
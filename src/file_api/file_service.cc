@@ -31,6 +31,7 @@
 
 #include "log/messages.h"
 #include "main/snort_config.h"
+#include "memory/memory_reclaim.h"
 #include "mime/file_mime_process.h"
 #include "search_engines/search_tool.h"
 
@@ -59,6 +60,14 @@ void FileService::init()
     FileFlows::init();
 }
 
+// the cache is shared by all packet threads and bounded by max_files_cached
+// rather than the thread cap so it only reports what it holds
+static size_t file_cache_held()
+{
+    FileCache* fc = FileService::get_file_cache();
+    return fc ? fc->get_mem_used() : 0;
+}
+
 void FileService::post_init(const SnortConfig* sc)
 {
     SearchTool::set_conf(sc);
@@ -76,6 +85,10 @@ void FileService::post_init(const SnortConfig* sc)
         max_files_cached = conf->max_files_cached;
         file_cache->set_block_timeout(conf->file_block_timeout);
         file_cache->set_lookup_timeout(conf->file_lookup_timeout);
+
+        memory::Reclaimer r;
+        r.held = file_cache_held;
+        memory::MemoryReclaim::add(memory::Consumer::FILE_CACHE, r);
     }
 
     if (file_capture_enabled)
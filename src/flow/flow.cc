@@ -23,7 +23,11 @@
 
 #include "flow.h"
 
+#include <unordered_map>
+#include <vector>
+
 #include "detection/detection_engine.h"
+#include "flow/flow_data_queue.h"
 #include "flow/ha.h"
 #include "flow/session.h"
 #include "framework/data_bus.h"
@@ -38,6 +42,12 @@
 
 using namespace snort;
 
+namespace snort
+{
+struct FlowDataMap : public std::unordered_map<unsigned, FlowData*>
+{ };
+}
+
 Flow::Flow()
 {
     memory::MemoryCap::update_allocations(sizeof(*this) + sizeof(FlowStash));
@@ -76,7 +86,7 @@ void Flow::term()
     delete session;
     session = nullptr;
 
-    if ( flow_data )
+    if ( flow_data_mask or flow_data_map )
         free_flow_data();
 
     if ( mpls_client.length )
@@ -164,7 +174,7 @@ void Flow::flush(bool do_cleanup)
         free_flow_data();
 }
 
-void Flow::reset(bool do_cleanup)
+void Flow::reset(bool do_cleanup, FlowDataQueue* fdq)
 {
     if ( session )
     {
@@ -183,7 +193,11 @@ void Flow::reset(bool do_cleanup)
             session->clear();
     }
 
-    free_flow_data();
+    if ( fdq )
+        free_flow_data(*fdq);
+    else
+        free_flow_data();
+
     clean();
 
     // FIXIT-M cleanup() winds up calling clear()
@@ -267,19 +281,28 @@ void Flow::trust()
 
 int Flow::set_flow_data(FlowData* fd)
 {
-    FlowData* old = get_flow_data(fd->get_id());
+    unsigned id = fd->get_id();
+    FlowData* old = get_flow_data(id);
     assert(old != fd);
 
     if (old)
         free_flow_data(old);
 
-    fd->prev = nullptr;
-    fd->next = flow_data;
+    // the links are only used while the data is pending on an expected flow
+    fd->prev = fd->next = nullptr;
 
-    if ( flow_data )
-        flow_data->prev = fd;
+    if ( id - 1 < FLOW_DATA_SLOTS )
+    {
+        flow_data_slots[id - 1] = fd;
+        flow_data_mask |= 1u << (id - 1);
+    }
+    else
+    {
+        if ( !flow_data_map )
+            flow_data_map = new FlowDataMap;
 
-    flow_data = fd;
+        (*flow_data_map)[id] = fd;
+    }
 
     // this is after actual allocation so we can't prune beforehand
     // but if we are that close to the edge we are in trouble anyway
@@ -291,36 +314,41 @@ int Flow::set_flow_data(FlowData* fd)
 
 FlowData* Flow::get_flow_data(unsigned id) const
 {
-    FlowData* fd = flow_data;
+    // id 0 wraps to the overflow map
+    if ( id - 1 < FLOW_DATA_SLOTS )
+        return flow_data_slots[id - 1];
 
-    while (fd)
-    {
-        if (fd->get_id() == id)
-            return fd;
+    if ( !flow_data_map )
+        return nullptr;
 
-        fd = fd->next;
-    }
-    return nullptr;
+    auto it = flow_data_map->find(id);
+    return it != flow_data_map->end() ? it->second : nullptr;
 }
 
-// FIXIT-L: implement doubly linked list with STL to cut down on code we maintain
-void Flow::free_flow_data(FlowData* fd)
+void Flow::remove_flow_data(FlowData* fd)
 {
-    if ( fd == flow_data )
-    {
-        flow_data = fd->next;
-        if ( flow_data )
-            flow_data->prev = nullptr;
-    }
-    else if ( !fd->next )
+    unsigned id = fd->get_id();
+
+    if ( id - 1 < FLOW_DATA_SLOTS )
     {
-        fd->prev->next = nullptr;
+        assert(flow_data_slots[id - 1] == fd);
+        flow_data_slots[id - 1] = nullptr;
+        flow_data_mask &= ~(1u << (id - 1));
+        return;
     }
-    else
+    assert(flow_data_map);
+    flow_data_map->erase(id);
+
+    if ( flow_data_map->empty() )
     {
-        fd->prev->next = fd->next;
-        fd->next->prev = fd->prev;
+        delete flow_data_map;
+        flow_data_map = nullptr;
     }
+}
+
+void Flow::free_flow_data(FlowData* fd)
+{
+    remove_flow_data(fd);
     fd->update_deallocations(fd->size_of());
     delete fd;
 }
@@ -333,29 +361,70 @@ void Flow::free_flow_data(uint32_t proto)
         free_flow_data(fd);
 }
 
+// each item is removed before it is deleted in case the destructor
+// looks up or frees other flow data
 void Flow::free_flow_data()
 {
-    while (flow_data)
+    while ( flow_data_mask )
     {
-        FlowData* tmp = flow_data;
-        flow_data = flow_data->next;
-        tmp->update_deallocations(tmp->size_of());
-        delete tmp;
+        FlowData* fd = flow_data_slots[__builtin_ctz(flow_data_mask)];
+        free_flow_data(fd);
     }
+
+    while ( flow_data_map )
+        free_flow_data(flow_data_map->begin()->second);
+}
+
+// as above but flow data that can be deleted later is queued instead
+void Flow::free_flow_data(FlowDataQueue& fdq)
+{
+    auto release = [this, &fdq](FlowData* fd)
+    {
+        remove_flow_data(fd);
+
+        if ( !fd->can_defer_delete() or !fdq.push(fd) )
+        {
+            fd->update_deallocations(fd->size_of());
+            delete fd;
+        }
+    };
+
+    while ( flow_data_mask )
+        release(flow_data_slots[__builtin_ctz(flow_data_mask)]);
+
+    while ( flow_data_map )
+        release(flow_data_map->begin()->second);
 }
 
 void Flow::call_handlers(Packet* p, bool eof)
 {
-    FlowData* fd = flow_data;
+    std::vector<FlowData*> overflow;
 
-    while (fd)
+    if ( flow_data_map )
     {
+        for ( const auto& it : *flow_data_map )
+            overflow.emplace_back(it.second);
+    }
+
+    for ( uint32_t mask = flow_data_mask; mask; mask &= mask - 1 )
+    {
+        FlowData* fd = flow_data_slots[__builtin_ctz(mask)];
+
+        if ( !fd )
+            continue;
+
         if ( eof )
             fd->handle_eof(p);
         else
             fd->handle_retransmit(p);
+    }
 
-        fd = fd->next;
+    for ( auto fd : overflow )
+    {
+        if ( eof )
+            fd->handle_eof(p);
+        else
+            fd->handle_retransmit(p);
     }
 }
 
@@ -24,8 +24,8 @@
 // Flow is the object that captures all the data we know about a session,
 // including IP for defragmentation and TCP for desegmentation.  For all
 // protocols, it used to track connection status bindings, and inspector
-// state.  Inspector state is stored in FlowData, and Flow manages a list
-// of FlowData items.
+// state.  Inspector state is stored in FlowData, and Flow manages the
+// FlowData items by id.
 
 #include <sys/time.h>
 
@@ -98,12 +98,19 @@
 #define STREAM_STATE_BLOCK_PENDING     0x0400
 #define STREAM_STATE_RELEASING         0x0800
 
+// FlowData ids are dense and assigned as inspectors register so the first
+// ids index directly into an array on the flow.  any others go into an
+// overflow map allocated on demand.
+#define FLOW_DATA_SLOTS 16
+
 class BitOp;
+class FlowDataQueue;
 class Session;
 
 namespace snort
 {
 class FlowHAState;
+struct FlowDataMap;
 struct FlowKey;
 class IpsContext;
 struct Packet;
@@ -176,7 +183,7 @@ public:
     void term();
 
     void flush(bool do_cleanup = true);
-    void reset(bool do_cleanup = true);
+    void reset(bool do_cleanup = true, FlowDataQueue* = nullptr);
     void restart(bool dump_flow_data = true);
     void clear(bool dump_flow_data = true);
 
@@ -185,6 +192,7 @@ public:
     void free_flow_data(uint32_t proto);
     void free_flow_data(FlowData*);
     void free_flow_data();
+    void free_flow_data(FlowDataQueue&);
 
     void call_handlers(Packet* p, bool eof = false);
     void markup_packet_flags(Packet*);
@@ -411,16 +419,22 @@ public:  // FIXIT-M privatize if possible
 
     // these fields are always set; not zeroed
     Flow* prev, * next;
+    Flow* timer_prev, * timer_next;  // owned by FlowTimerWheel
+    Flow* lru_prev, * lru_next;      // owned by FlowLruList
     Session* session;
     Inspector* ssn_client;
     Inspector* ssn_server;
 
     long last_data_seen;
+    long timer_deadline;
     Layer mpls_client, mpls_server;
+    uint16_t timer_slot;  // 0 if not scheduled
 
     // everything from here down is zeroed
     IpsContextChain context_chain;
-    FlowData* flow_data;
+    FlowData* flow_data_slots[FLOW_DATA_SLOTS];  // by id - 1
+    FlowDataMap* flow_data_map;
+    uint32_t flow_data_mask;  // occupied slots
     FlowStats flowstats;
 
     SfIp client_ip;
@@ -489,6 +503,9 @@ public:  // FIXIT-M privatize if possible
 
 private:
     void clean();
+    void remove_flow_data(FlowData*);
+
+    static_assert(FLOW_DATA_SLOTS <= 32, "flow_data_mask is too small");
 };
 
 inline void Flow::set_to_client_detection(bool enable)
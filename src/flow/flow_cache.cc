@@ -26,6 +26,7 @@
 
 #include "detection/detection_engine.h"
 #include "hash/hash_defs.h"
+#include "hash/ohash.h"
 #include "hash/zhash.h"
 #include "helpers/flag_context.h"
 #include "ips_options/ips_flowbits.h"
@@ -57,10 +58,15 @@ THREAD_LOCAL bool FlowCache::pruning_in_progress = false;
 
 FlowCache::FlowCache(const FlowCacheConfig& cfg) : config(cfg)
 {
-    hash_table = new ZHash(config.max_flows, sizeof(FlowKey));
+    if ( config.table_type == FlowTableType::OPEN )
+        hash_table = new OHash(config.max_flows, sizeof(FlowKey));
+    else
+        hash_table = new ZHash(config.max_flows, sizeof(FlowKey));
+
     uni_flows = new FlowUniList;
     uni_ip_flows = new FlowUniList;
     flags = 0x0;
+    set_queue_limit();
 
     assert(prune_stats.get_total() == 0);
 }
@@ -71,6 +77,20 @@ FlowCache::~FlowCache()
     delete_uni();
 }
 
+// flow data is only held back if it will be drained per packet.  the
+// queue is bounded by the cache size so it can't grow without limit when
+// flows are released faster than the budget.
+void FlowCache::set_queue_limit()
+{
+    flow_data_queue.set_limit(config.release_budget ? config.max_flows : 0);
+}
+
+// the flows themselves, not what their sessions and flow data hold
+size_t FlowCache::get_memory_held() const
+{
+    return (size_t)flows_allocated * (hash_table->get_node_size() + sizeof(Flow) + sizeof(FlowStash));
+}
+
 void FlowCache::delete_uni()
 {
     delete uni_flows;
@@ -102,11 +122,23 @@ Flow* FlowCache::find(const FlowKey* key)
 
         if ( flow->last_data_seen < t )
             flow->last_data_seen = t;
+
+        type_lru[to_utype(key->pkt_type)].touch(flow);
+
+        // idle deadlines only move out and are picked up when they come
+        // due but a hard expiration may have been moved in
+        if ( flow->is_hard_expiration() and (long)flow->expire_time < flow->timer_deadline )
+            timers.arm(flow, flow->expire_time, t);
     }
 
     return flow;
 }
 
+void FlowCache::prefetch(const FlowKey* key)
+{
+    hash_table->prefetch(key);
+}
+
 // always prepend
 void FlowCache::link_uni(Flow* flow)
 {
@@ -135,7 +167,7 @@ Flow* FlowCache::allocate(const FlowKey* key)
         {
             Flow* new_flow = new Flow();
             push(new_flow);
-            memory::MemoryCap::update_allocations(sizeof(HashNode) + sizeof(FlowKey));
+            memory::MemoryCap::update_allocations(hash_table->get_node_size());
         }
         else if ( !prune_stale(timestamp, nullptr) )
         {
@@ -158,12 +190,25 @@ Flow* FlowCache::allocate(const FlowKey* key)
 
     memory::MemoryCap::update_allocations(config.proto[to_utype(key->pkt_type)].cap_weight);
     flow->last_data_seen = timestamp;
+    timers.arm(flow, get_deadline(flow), timestamp);
+    type_lru[to_utype(key->pkt_type)].touch(flow);
 
     return flow;
 }
 
+time_t FlowCache::get_deadline(Flow* flow)
+{
+    if ( flow->is_hard_expiration() )
+        return (time_t)flow->expire_time;
+
+    return flow->last_data_seen + config.proto[to_utype(flow->key->pkt_type)].nominal_timeout;
+}
+
 void FlowCache::remove(Flow* flow)
 {
+    timers.disarm(flow);
+    type_lru[to_utype(flow->key->pkt_type)].unlink(flow);
+
     if ( flow->next )
         unlink_uni(flow);
 
@@ -190,8 +235,12 @@ bool FlowCache::release(Flow* flow, PruneReason reason, bool do_cleanup)
         }
     }
 
-    flow->reset(do_cleanup);
+    flow->reset(do_cleanup, &flow_data_queue);
     prune_stats.update(reason);
+
+    if ( reason != PruneReason::NONE and reason != PruneReason::TIMEOUT )
+        ++type_prunes[to_utype(flow->key->pkt_type)];
+
     remove(flow);
     pruning_in_progress = false;
     return true;
@@ -205,12 +254,92 @@ void FlowCache::retire(Flow* flow)
     remove(flow);
 }
 
+bool FlowCache::has_shares() const
+{
+    for ( const auto& p : config.proto )
+        if ( p.share )
+            return true;
+
+    return false;
+}
+
+// true if the type holds no more than its share
+bool FlowCache::in_share(PktType type) const
+{
+    unsigned share = config.proto[to_utype(type)].share;
+
+    if ( !share )
+        return false;
+
+    return type_lru[to_utype(type)].get_count() <= (uint64_t)config.max_flows * share / 100;
+}
+
+// with shares configured, flows are pruned from the type furthest over its
+// share of max_flows.  a type under its share only loses flows when no other
+// type is borrowing.  the newest flow of each type may be the current one so
+// single flow types are passed over.  NONE means use the cache wide lru.
+PktType FlowCache::get_prune_type() const
+{
+    PktType type = PktType::NONE;
+
+    if ( !has_shares() )
+        return type;
+
+    int64_t most = INT64_MIN;
+
+    for ( unsigned i = to_utype(PktType::IP); i < to_utype(PktType::MAX); ++i )
+    {
+        unsigned n = type_lru[i].get_count();
+
+        if ( n < 2 )
+            continue;
+
+        int64_t over = (int64_t)n - (int64_t)((uint64_t)config.max_flows * config.proto[i].share / 100);
+
+        if ( over > most )
+        {
+            most = over;
+            type = (PktType)i;
+        }
+    }
+    return type;
+}
+
+Flow* FlowCache::get_oldest(PktType type)
+{
+    if ( type == PktType::NONE )
+        return static_cast<Flow*>(hash_table->lru_first());
+
+    return type_lru[to_utype(type)].get_oldest();
+}
+
+// move the flow returned by get_oldest() to the back of the line
+void FlowCache::skip_oldest(PktType type)
+{
+    if ( type == PktType::NONE )
+        hash_table->lru_touch();
+    else
+        type_lru[to_utype(type)].touch(type_lru[to_utype(type)].get_oldest());
+}
+
 unsigned FlowCache::prune_stale(uint32_t thetime, const Flow* save_me)
+{
+    PktType type = get_prune_type();
+    unsigned pruned = prune_stale(thetime, save_me, type);
+
+    // the type furthest over its share may have nothing stale while others do
+    if ( !pruned and type != PktType::NONE )
+        pruned = prune_stale(thetime, save_me, PktType::NONE);
+
+    return pruned;
+}
+
+unsigned FlowCache::prune_stale(uint32_t thetime, const Flow* save_me, PktType type)
 {
     ActiveSuspendContext act_susp(Active::ASP_PRUNE);
 
     unsigned pruned = 0;
-    auto flow = static_cast<Flow*>(hash_table->lru_first());
+    auto flow = get_oldest(type);
 
     {
         PacketTracerSuspend pt_susp;
@@ -242,7 +371,7 @@ unsigned FlowCache::prune_stale(uint32_t thetime, const Flow* save_me)
             if ( release(flow, PruneReason::IDLE) )
                 ++pruned;
 
-            flow = static_cast<Flow*>(hash_table->lru_first());
+            flow = get_oldest(type);
         }
     }
 
@@ -276,7 +405,7 @@ unsigned FlowCache::prune_unis(PktType pkt_type)
             Flow* prune_me = flow;
             flow = uni_list->get_prev(prune_me);
 
-            if ( prune_me->was_blocked() )
+            if ( prune_me->was_blocked() or in_share(prune_me->key->pkt_type) )
                 continue;
 
             if ( release(prune_me, PruneReason::UNI) )
@@ -309,7 +438,8 @@ unsigned FlowCache::prune_excess(const Flow* save_me)
 
         while ( hash_table->get_num_nodes() > max_cap and hash_table->get_num_nodes() > blocks )
         {
-            auto flow = static_cast<Flow*>(hash_table->lru_first());
+            PktType type = get_prune_type();
+            auto flow = get_oldest(type);
             assert(flow); // holds true because hash_table->get_count() > 0
 
             if ( (save_me and flow == save_me) or flow->was_blocked() or
@@ -322,7 +452,7 @@ unsigned FlowCache::prune_excess(const Flow* save_me)
 
                 // FIXIT-M we should update last_data_seen upon touch to ensure
                 // the hash_table LRU list remains sorted by time
-                hash_table->lru_touch();
+                skip_oldest(type);
             }
             else
             {
@@ -353,8 +483,8 @@ bool FlowCache::prune_one(PruneReason reason, bool do_cleanup)
     if ( hash_table->get_num_nodes() <= 1 )
         return false;
 
-    // ZHash returns in LRU order, which is updated per packet via find --> move_to_front call
-    auto flow = static_cast<Flow*>(hash_table->lru_first());
+    // the table returns in LRU order, which is updated per packet via find --> move_to_front call
+    auto flow = get_oldest(get_prune_type());
     assert(flow);
 
     flow->ssn_state.session_flags |= SSNFLAG_PRUNED;
@@ -372,33 +502,35 @@ unsigned FlowCache::timeout(unsigned num_flows, time_t thetime)
     {
         PacketTracerSuspend pt_susp;
 
-        auto flow = static_cast<Flow*>(hash_table->lru_current());
+        while ( retired < num_flows )
+        {
+            Flow* flow = timers.next_due(thetime);
 
-        if ( !flow )
-            flow = static_cast<Flow*>(hash_table->lru_first());
+            if ( !flow )
+                break;
 
-        while ( flow and (retired < num_flows) )
-        {
-            if ( flow->is_hard_expiration() )
+            // seen again since it was scheduled
+            time_t deadline = get_deadline(flow);
+
+            if ( deadline > thetime )
             {
-                if ( flow->expire_time > (uint64_t) thetime )
-                    break;
+                timers.arm(flow, deadline, thetime);
+                ++timer_rearms;
+                continue;
             }
-            else if ( flow->last_data_seen + config.proto[to_utype(flow->key->pkt_type)].nominal_timeout > thetime )
-                break;
 
             if ( HighAvailabilityManager::in_standby(flow) or
                     flow->is_suspended() )
             {
-                flow = static_cast<Flow*>(hash_table->lru_next());
+                timers.arm(flow, thetime + 1, thetime);
                 continue;
             }
 
             flow->ssn_state.session_flags |= SSNFLAG_TIMEDOUT;
-            if ( release(flow, PruneReason::IDLE) )
+            if ( release(flow, PruneReason::TIMEOUT) )
                 ++retired;
-
-            flow = static_cast<Flow*>(hash_table->lru_current());
+            else
+                timers.arm(flow, thetime + 1, thetime);
         }
     }
 
@@ -423,6 +555,9 @@ unsigned FlowCache::delete_active_flows(unsigned mode, unsigned num_to_delete, u
         }
 
         // we have a winner...
+        timers.disarm(flow);
+        type_lru[to_utype(flow->key->pkt_type)].unlink(flow);
+
         if ( flow->next )
             unlink_uni(flow);
 
@@ -437,7 +572,7 @@ unsigned FlowCache::delete_active_flows(unsigned mode, unsigned num_to_delete, u
         //The flow should not be removed from the hash before reset
         hash_table->remove();
         delete flow;
-        memory::MemoryCap::update_deallocations(sizeof(HashNode) + sizeof(FlowKey));
+        memory::MemoryCap::update_deallocations(hash_table->get_node_size());
         --flows_allocated;
         ++deleted;
         --num_to_delete;
@@ -464,7 +599,7 @@ unsigned FlowCache::delete_flows(unsigned num_to_delete)
 
             delete flow;
             delete_stats.update(FlowDeleteState::FREELIST);
-            memory::MemoryCap::update_deallocations(sizeof(HashNode) + sizeof(FlowKey));
+            memory::MemoryCap::update_deallocations(hash_table->get_node_size());
 
             --flows_allocated;
             ++deleted;
@@ -497,11 +632,12 @@ unsigned FlowCache::purge()
         ++retired;
     }
     pruning_in_progress = false;
+    flow_data_queue.drain(flow_data_queue.get_depth());
 
     while ( Flow* flow = (Flow*)hash_table->pop() )
     {
         delete flow;
-        memory::MemoryCap::update_deallocations(sizeof(HashNode) + sizeof(FlowKey));
+        memory::MemoryCap::update_deallocations(hash_table->get_node_size());
         --flows_allocated;
     }
 
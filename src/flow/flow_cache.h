@@ -23,7 +23,7 @@
 #define FLOW_CACHE_H
 
 // there is a FlowCache instance for each protocol.
-// Flows are stored in a ZHash instance by FlowKey.
+// Flows are stored in a FlowTable (ZHash or OHash) instance by FlowKey.
 
 #include <ctime>
 #include <type_traits>
@@ -32,6 +32,9 @@
 #include "main/thread.h"
 
 #include "flow_config.h"
+#include "flow_data_queue.h"
+#include "flow_lru_list.h"
+#include "flow_timer_wheel.h"
 #include "prune_stats.h"
 
 namespace snort
@@ -40,6 +43,7 @@ class Flow;
 struct FlowKey;
 }
 
+class FlowTable;
 class FlowUniList;
 
 class FlowCache
@@ -53,6 +57,7 @@ public:
 
     snort::Flow* find(const snort::FlowKey*);
     snort::Flow* allocate(const snort::FlowKey*);
+    void prefetch(const snort::FlowKey*);
 
     bool release(snort::Flow*, PruneReason = PruneReason::NONE, bool do_cleanup = true);
 
@@ -80,16 +85,50 @@ public:
     PegCount get_deletes(FlowDeleteState state) const
     { return delete_stats.get(state); }
 
+    PegCount get_timer_rearms() const
+    { return timer_rearms; }
+
+    unsigned delete_flow_data(unsigned max)
+    { return flow_data_queue.drain(max); }
+
+    unsigned get_flow_data_queued() const
+    { return flow_data_queue.get_depth(); }
+
+    size_t get_flow_data_bytes() const
+    { return flow_data_queue.get_bytes(); }
+
+    size_t get_memory_held() const;
+
+    const FlowDataQueueStats& get_flow_data_stats() const
+    { return flow_data_queue.get_stats(); }
+
+    PegCount get_type_prunes(PktType type) const
+    { return type_prunes[to_utype(type)]; }
+
+    unsigned get_type_count(PktType type) const
+    { return type_lru[to_utype(type)].get_count(); }
+
     void reset_stats()
     {
         prune_stats = PruneStats();
         delete_stats = FlowDeleteStats();
+        timer_rearms = 0;
+        flow_data_queue.reset_stats();
+
+        for ( auto& n : type_prunes )
+            n = 0;
     }
 
     void unlink_uni(snort::Flow*);
 
+    // the table type is fixed when the cache is constructed
     void set_flow_cache_config(const FlowCacheConfig& cfg)
-    { config = cfg; }
+    {
+        FlowTableType type = config.table_type;
+        config = cfg;
+        config.table_type = type;
+        set_queue_limit();
+    }
 
     const FlowCacheConfig& get_flow_cache_config() const
     { return config; }
@@ -106,6 +145,15 @@ private:
     void link_uni(snort::Flow*);
     void remove(snort::Flow*);
     void retire(snort::Flow*);
+    time_t get_deadline(snort::Flow*);
+    void set_queue_limit();
+
+    bool has_shares() const;
+    bool in_share(PktType) const;
+    PktType get_prune_type() const;
+    snort::Flow* get_oldest(PktType);
+    void skip_oldest(PktType);
+    unsigned prune_stale(uint32_t thetime, const snort::Flow* save_me, PktType);
     unsigned prune_unis(PktType);
     unsigned delete_active_flows
         (unsigned mode, unsigned num_to_delete, unsigned &deleted);
@@ -116,13 +164,18 @@ private:
     FlowCacheConfig config;
     uint32_t flags;
 
-    class ZHash* hash_table;
+    FlowTable* hash_table;
     unsigned flows_allocated = 0;
     FlowUniList* uni_flows;
     FlowUniList* uni_ip_flows;
+    FlowTimerWheel timers;
+    FlowLruList type_lru[to_utype(PktType::MAX)];
+    FlowDataQueue flow_data_queue;
 
     PruneStats prune_stats;
     FlowDeleteStats delete_stats;
+    PegCount timer_rearms = 0;
+    PegCount type_prunes[to_utype(PktType::MAX)] { };
 };
 #endif
 
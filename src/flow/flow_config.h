@@ -28,12 +28,19 @@ struct FlowTypeConfig
 {
     unsigned nominal_timeout = 0;
     unsigned cap_weight = 0;
+    unsigned share = 0;  // percent of max_flows kept from other types when pruning
 };
 
+enum class FlowTableType : uint8_t
+{ CHAINED, OPEN };
+
 struct FlowCacheConfig
 {
     unsigned max_flows = 0;
     unsigned pruning_timeout = 0;
+    FlowTableType table_type = FlowTableType::CHAINED;
+    unsigned prefetch_window = 0;
+    unsigned release_budget = 0;  // deferred flow data deleted per packet; 0 to delete at once
     FlowTypeConfig proto[to_utype(PktType::MAX)];
 };
 
@@ -31,6 +31,8 @@
 #include "packet_io/active.h"
 #include "packet_tracer/packet_tracer.h"
 #include "protocols/icmp4.h"
+#include "protocols/ipv4.h"
+#include "protocols/ipv6.h"
 #include "protocols/tcp.h"
 #include "protocols/udp.h"
 #include "protocols/vlan.h"
@@ -68,6 +70,24 @@ PegCount FlowControl::get_total_prunes() const
 PegCount FlowControl::get_prunes(PruneReason reason) const
 { return cache->get_prunes(reason); }
 
+PegCount FlowControl::get_timer_rearms() const
+{ return cache->get_timer_rearms(); }
+
+PegCount FlowControl::get_type_prunes(PktType type) const
+{ return cache->get_type_prunes(type); }
+
+const FlowDataQueueStats& FlowControl::get_flow_data_stats() const
+{ return cache->get_flow_data_stats(); }
+
+unsigned FlowControl::get_flow_data_queued() const
+{ return cache->get_flow_data_queued(); }
+
+size_t FlowControl::get_flow_data_bytes() const
+{ return cache->get_flow_data_bytes(); }
+
+size_t FlowControl::get_memory_held() const
+{ return cache->get_memory_held(); }
+
 PegCount FlowControl::get_total_deletes() const
 { return cache->get_total_deletes(); }
 
@@ -118,19 +138,14 @@ unsigned FlowControl::delete_flows(unsigned num_to_delete)
 bool FlowControl::prune_one(PruneReason reason, bool do_cleanup)
 { return cache->prune_one(reason, do_cleanup); }
 
-void FlowControl::timeout_flows(time_t cur_time)
+void FlowControl::timeout_flows(unsigned max, time_t cur_time)
 {
-    cache->timeout(1, cur_time);
+    cache->timeout(max, cur_time);
 }
 
-void FlowControl::preemptive_cleanup()
+unsigned FlowControl::delete_flow_data(unsigned max)
 {
-    // FIXIT-RC is there a possibility of this looping forever?
-    while ( memory::MemoryCap::over_threshold() )
-    {
-        if ( !prune_one(PruneReason::PREEMPTIVE, true) )
-            break;
-    }
+    return cache->delete_flow_data(max);
 }
 
 Flow* FlowControl::stale_flow_cleanup(FlowCache* cache, Flow* flow, Packet* p)
@@ -157,6 +172,113 @@ Flow* FlowControl::stale_flow_cleanup(FlowCache* cache, Flow* flow, Packet* p)
 // packet foo
 //-------------------------------------------------------------------------
 
+// build the key that decode would produce for the common cases (ethernet
+// with at most one vlan tag, ipv4 or ipv6, and tcp, udp, or icmp) without
+// decoding.  the key is only used to prefetch so it is ok to give up on
+// anything else and to get tunneled traffic wrong.
+static bool peek_key(
+    const SnortConfig* sc, FlowKey& key, const DAQ_PktHdr_t& pkth, const uint8_t* pkt, uint32_t len)
+{
+    const unsigned eth_len = 14;
+    const unsigned vlan_len = 4;
+
+    if ( len < eth_len )
+        return false;
+
+    uint16_t vlan_id = 0;
+    uint16_t ether_type = (pkt[12] << 8) | pkt[13];
+    unsigned off = eth_len;
+
+    if ( ether_type == to_utype(ProtocolId::ETHERTYPE_8021Q) )
+    {
+        if ( len < off + vlan_len )
+            return false;
+
+        vlan_id = ((pkt[off] << 8) | pkt[off + 1]) & 0x0FFF;
+        ether_type = (pkt[off + 2] << 8) | pkt[off + 3];
+        off += vlan_len;
+    }
+
+    SfIp src, dst;
+    IpProtocol ip_proto;
+
+    if ( ether_type == to_utype(ProtocolId::ETHERTYPE_IPV4) )
+    {
+        const uint8_t* ip = pkt + off;
+
+        if ( len < off + ip::IP4_HEADER_LEN )
+            return false;
+
+        unsigned hlen = (ip[0] & 0x0F) << 2;
+
+        if ( (ip[0] >> 4) != 4 or hlen < ip::IP4_HEADER_LEN or len < off + hlen )
+            return false;
+
+        // fragments are keyed by ip id
+        if ( ((ip[6] << 8) | ip[7]) & 0x3FFF )
+            return false;
+
+        ip_proto = (IpProtocol)ip[9];
+        src.set(ip + 12, AF_INET);
+        dst.set(ip + 16, AF_INET);
+        off += hlen;
+    }
+    else if ( ether_type == to_utype(ProtocolId::ETHERTYPE_IPV6) )
+    {
+        const uint8_t* ip = pkt + off;
+
+        if ( len < off + ip::IP6_HEADER_LEN )
+            return false;
+
+        ip_proto = (IpProtocol)ip[6];
+        src.set(ip + 8, AF_INET6);
+        dst.set(ip + 24, AF_INET6);
+        off += ip::IP6_HEADER_LEN;
+    }
+    else
+        return false;
+
+    PktType type;
+    uint16_t sp, dp;
+
+    switch ( ip_proto )
+    {
+    case IpProtocol::TCP:
+    case IpProtocol::UDP:
+        if ( len < off + 4 )
+            return false;
+
+        type = (ip_proto == IpProtocol::TCP) ? PktType::TCP : PktType::UDP;
+        sp = (pkt[off] << 8) | pkt[off + 1];
+        dp = (pkt[off + 2] << 8) | pkt[off + 3];
+        break;
+
+    case IpProtocol::ICMPV4:
+    case IpProtocol::ICMPV6:
+        if ( len < off + 1 )
+            return false;
+
+        type = PktType::ICMP;
+        sp = pkt[off];
+        dp = 0;
+        break;
+
+    default:
+        return false;
+    }
+
+    key.init(sc, type, ip_proto, &src, sp, &dst, dp, vlan_id, 0, pkth);
+    return true;
+}
+
+void FlowControl::prefetch_flow(const DAQ_PktHdr_t* pkth, const uint8_t* pkt, uint32_t len)
+{
+    FlowKey key;
+
+    if ( peek_key(SnortConfig::get_conf(), key, *pkth, pkt, len) )
+        cache->prefetch(&key);
+}
+
 void FlowControl::set_key(FlowKey* key, Packet* p)
 {
     const ip::IpApi& ip_api = p->ptrs.ip_api;
@@ -430,7 +552,7 @@ unsigned FlowControl::process(Flow* flow, Packet* p)
     p->disable_inspect = flow->is_inspection_disabled();
 
     last_pkt_type = p->type();
-    preemptive_cleanup();
+    memory::MemoryCap::reclaim();
 
     // If this code is executed on a flow in SETUP state, it will result in a packet from both
     // client and server on packets from 0.0.0.0 or ::
@@ -28,6 +28,8 @@
 #include <cstdint>
 #include <vector>
 
+#include <daq_common.h>
+
 #include "flow/flow_config.h"
 #include "framework/counts.h"
 #include "framework/decode_data.h"
@@ -42,6 +44,7 @@ struct Packet;
 struct SfIp;
 }
 class FlowCache;
+struct FlowDataQueueStats;
 
 enum class PruneReason : uint8_t;
 enum class FlowDeleteState : uint8_t;
@@ -59,6 +62,7 @@ public:
     unsigned get_flows_allocated() const;
 
     bool process(PktType, snort::Packet*, bool* new_flow = nullptr);
+    void prefetch_flow(const DAQ_PktHdr_t*, const uint8_t* pkt, uint32_t len);
     snort::Flow* find_flow(const snort::FlowKey*);
     snort::Flow* new_flow(const snort::FlowKey*);
     void release_flow(const snort::FlowKey*);
@@ -67,7 +71,8 @@ public:
     unsigned delete_flows(unsigned num_to_delete);
     bool prune_one(PruneReason, bool do_cleanup);
     snort::Flow* stale_flow_cleanup(FlowCache*, snort::Flow*, snort::Packet*);
-    void timeout_flows(time_t cur_time);
+    void timeout_flows(unsigned max, time_t cur_time);
+    unsigned delete_flow_data(unsigned max);
     void check_expected_flow(snort::Flow*, snort::Packet*);
     bool is_expected(snort::Packet*);
 
@@ -90,6 +95,12 @@ public:
 
     PegCount get_total_prunes() const;
     PegCount get_prunes(PruneReason) const;
+    PegCount get_timer_rearms() const;
+    PegCount get_type_prunes(PktType) const;
+    const FlowDataQueueStats& get_flow_data_stats() const;
+    unsigned get_flow_data_queued() const;
+    size_t get_flow_data_bytes() const;
+    size_t get_memory_held() const;
     PegCount get_total_deletes() const;
     PegCount get_deletes(FlowDeleteState state) const;
     void clear_counts();
@@ -97,7 +108,6 @@ public:
 private:
     void set_key(snort::FlowKey*, snort::Packet*);
     unsigned process(snort::Flow*, snort::Packet*);
-    void preemptive_cleanup();
     void update_stats(snort::Flow*, snort::Packet*);
 
 private:
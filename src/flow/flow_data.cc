@@ -61,6 +61,7 @@ void FlowData::update_allocations(size_t n)
     {
         mem_in_use += n;
         net_allocation_calls++;
+        memory::MemoryArena::charge(arena, n);
     }
 }
 
@@ -74,6 +75,7 @@ void FlowData::update_deallocations(size_t n)
         mem_in_use -= n;
         assert(net_allocation_calls > 0);
         net_allocation_calls--;
+        memory::MemoryArena::credit(arena, n);
     }
 }
 
@@ -21,6 +21,7 @@
 #define FLOW_DATA_H
 
 #include "main/snort_types.h"
+#include "memory/memory_arena.h"
 
 namespace snort
 {
@@ -51,11 +52,23 @@ public:
     // track significant supplemental allocations with the above updaters
     virtual size_t size_of() = 0;
 
+    // return true if the destructor doesn't use the flow so it can be
+    // deleted after the flow is reused; see FlowDataQueue
+    virtual bool can_defer_delete() const
+    { return false; }
+
     virtual void handle_expected(Packet*) { }
     virtual void handle_retransmit(Packet*) { }
     virtual void handle_eof(Packet*) { }
 
+protected:
+    // charges the tracked allocations to the given arena;
+    // call from the constructor before anything is tracked
+    void set_arena(memory::Arena a)
+    { arena = a; }
+
 public:  // FIXIT-L privatize
+    // only used to chain data on an expected flow
     FlowData* next;
     FlowData* prev;
 
@@ -65,6 +78,7 @@ private:
     size_t mem_in_use = 0;
     unsigned net_allocation_calls = 0;
     unsigned id;
+    memory::Arena arena = memory::Arena::NONE;
 };
 
 // The flow data created from SO rules must use RuleFlowData
@@ -0,0 +1,87 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// flow_data_queue.cc - flow data released with its flow but deleted later
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "flow_data_queue.h"
+
+#include <cassert>
+
+#include "flow_data.h"
+
+using namespace snort;
+
+FlowDataQueue::~FlowDataQueue()
+{
+    drain(depth);
+}
+
+// queued flow data is detached from its flow so the expected flow links
+// are free to chain it here
+bool FlowDataQueue::push(FlowData* fd)
+{
+    if ( depth >= limit )
+        return false;
+
+    fd->next = nullptr;
+    fd->prev = tail;
+
+    if ( tail )
+        tail->next = fd;
+    else
+        head = fd;
+
+    tail = fd;
+    bytes += fd->size_of();
+
+    if ( ++depth > stats.max_depth )
+        stats.max_depth = depth;
+
+    stats.deferred++;
+    return true;
+}
+
+unsigned FlowDataQueue::drain(unsigned max)
+{
+    unsigned n = 0;
+
+    while ( head and n < max )
+    {
+        FlowData* fd = head;
+        head = fd->next;
+
+        if ( head )
+            head->prev = nullptr;
+        else
+            tail = nullptr;
+
+        --depth;
+        bytes -= fd->size_of();
+        fd->update_deallocations(fd->size_of());
+        delete fd;
+        ++n;
+    }
+    stats.deleted += n;
+    assert(head or !depth);
+    return n;
+}
+
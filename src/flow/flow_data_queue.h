@@ -0,0 +1,88 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// flow_data_queue.h - flow data released with its flow but deleted later
+
+#ifndef FLOW_DATA_QUEUE_H
+#define FLOW_DATA_QUEUE_H
+
+// tearing down the flow data of a busy flow can take a while so releasing
+// many flows at once, eg when pruning, can stall the packet thread.  flow
+// data that doesn't need the flow to delete itself is detached when the
+// flow is released and queued here.  the queue is drained a few at a time
+// after each packet and completely when idle.
+
+#include <cstddef>
+
+#include "framework/counts.h"
+
+namespace snort
+{
+class FlowData;
+}
+
+struct FlowDataQueueStats
+{
+    PegCount deferred;
+    PegCount deleted;
+    PegCount max_depth;
+};
+
+class FlowDataQueue
+{
+public:
+    FlowDataQueue() = default;
+    ~FlowDataQueue();
+
+    FlowDataQueue(const FlowDataQueue&) = delete;
+    FlowDataQueue& operator=(const FlowDataQueue&) = delete;
+
+    // limit is the most that may be waiting; 0 disables deferral
+    void set_limit(unsigned n)
+    { limit = n; }
+
+    // false if full; the caller must delete it
+    bool push(snort::FlowData*);
+
+    // delete up to max, oldest first; returns the number deleted
+    unsigned drain(unsigned max);
+
+    unsigned get_depth() const
+    { return depth; }
+
+    // as given by size_of()
+    size_t get_bytes() const
+    { return bytes; }
+
+    const FlowDataQueueStats& get_stats() const
+    { return stats; }
+
+    void reset_stats()
+    { stats = { 0, 0, depth }; }
+
+private:
+    snort::FlowData* head = nullptr;
+    snort::FlowData* tail = nullptr;
+    size_t bytes = 0;
+    unsigned depth = 0;
+    unsigned limit = 0;
+    FlowDataQueueStats stats = { };
+};
+
+#endif
+
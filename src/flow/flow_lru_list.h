@@ -0,0 +1,96 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// flow_lru_list.h - flows of one type in least recently used order
+
+#ifndef FLOW_LRU_LIST_H
+#define FLOW_LRU_LIST_H
+
+#include "flow.h"
+
+class FlowLruList
+{
+public:
+    FlowLruList() = default;
+
+    FlowLruList(const FlowLruList&) = delete;
+    FlowLruList& operator=(const FlowLruList&) = delete;
+
+    bool is_linked(const snort::Flow* flow) const
+    { return flow->lru_prev or flow == head; }
+
+    // as the most recent
+    void link(snort::Flow* flow)
+    {
+        flow->lru_prev = nullptr;
+        flow->lru_next = head;
+
+        if ( head )
+            head->lru_prev = flow;
+        else
+            tail = flow;
+
+        head = flow;
+        ++count;
+    }
+
+    void unlink(snort::Flow* flow)
+    {
+        if ( !is_linked(flow) )
+            return;
+
+        if ( flow->lru_prev )
+            flow->lru_prev->lru_next = flow->lru_next;
+        else
+            head = flow->lru_next;
+
+        if ( flow->lru_next )
+            flow->lru_next->lru_prev = flow->lru_prev;
+        else
+            tail = flow->lru_prev;
+
+        flow->lru_prev = flow->lru_next = nullptr;
+        --count;
+    }
+
+    void touch(snort::Flow* flow)
+    {
+        if ( flow == head )
+            return;
+
+        unlink(flow);
+        link(flow);
+    }
+
+    snort::Flow* get_oldest() const
+    { return tail; }
+
+    snort::Flow* get_newest() const
+    { return head; }
+
+    unsigned get_count() const
+    { return count; }
+
+private:
+    snort::Flow* head = nullptr;
+    snort::Flow* tail = nullptr;
+    unsigned count = 0;
+};
+
+#endif
+
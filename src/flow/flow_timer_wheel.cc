@@ -0,0 +1,190 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// flow_timer_wheel.cc - per thread expiration schedule for flows
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "flow_timer_wheel.h"
+
+#include <cassert>
+
+#include "flow.h"
+
+using namespace snort;
+
+// slot + 1 is stored in the flow so 0 means not scheduled
+
+bool FlowTimerWheel::is_armed(const Flow* flow)
+{ return flow->timer_slot != 0; }
+
+unsigned FlowTimerWheel::get_slot(time_t deadline) const
+{
+    if ( deadline <= clock )
+        return due_slot;
+
+    time_t delta = deadline - clock;
+
+    for ( unsigned lvl = 0; lvl < levels; ++lvl )
+    {
+        unsigned shift = bits * lvl;
+
+        if ( delta < ((time_t)1 << (shift + bits)) )
+            return lvl * slots + ((deadline >> shift) & (slots - 1));
+    }
+
+    // beyond the top level; cascaded again when this comes up
+    deadline = clock + ((time_t)1 << (bits * levels)) - 1;
+    return (levels - 1) * slots + ((deadline >> (bits * (levels - 1))) & (slots - 1));
+}
+
+void FlowTimerWheel::insert(Flow* flow, unsigned slot)
+{
+    Flow*& head = heads[slot];
+
+    flow->timer_prev = nullptr;
+    flow->timer_next = head;
+
+    if ( head )
+        head->timer_prev = flow;
+
+    head = flow;
+    flow->timer_slot = slot + 1;
+
+    if ( slot < due_slot )
+        ++level_count[slot / slots];
+}
+
+void FlowTimerWheel::unlink(Flow* flow)
+{
+    unsigned slot = flow->timer_slot - 1;
+
+    if ( flow->timer_prev )
+        flow->timer_prev->timer_next = flow->timer_next;
+    else
+        heads[slot] = flow->timer_next;
+
+    if ( flow->timer_next )
+        flow->timer_next->timer_prev = flow->timer_prev;
+
+    flow->timer_slot = 0;
+
+    if ( slot < due_slot )
+        --level_count[slot / slots];
+}
+
+void FlowTimerWheel::arm(Flow* flow, time_t deadline, time_t now)
+{
+    if ( is_armed(flow) )
+        unlink(flow);
+    else
+        ++count;
+
+    // nothing scheduled so no need to step up to now
+    if ( count == 1 )
+        clock = now;
+
+    flow->timer_deadline = deadline;
+    insert(flow, get_slot(deadline));
+}
+
+void FlowTimerWheel::disarm(Flow* flow)
+{
+    if ( !is_armed(flow) )
+        return;
+
+    unlink(flow);
+    --count;
+}
+
+Flow* FlowTimerWheel::next_due(time_t now)
+{
+    advance(now);
+    return heads[due_slot];
+}
+
+void FlowTimerWheel::advance(time_t now)
+{
+    while ( clock < now )
+    {
+        unsigned lvl = 0;
+
+        while ( lvl < levels and !level_count[lvl] )
+            ++lvl;
+
+        if ( lvl == levels )
+        {
+            clock = now;
+            break;
+        }
+
+        if ( lvl )
+        {
+            // nothing happens below lvl until its next cascade
+            time_t next = (clock | (((time_t)1 << (bits * lvl)) - 1)) + 1;
+
+            if ( next > now )
+            {
+                clock = now;
+                break;
+            }
+            clock = next - 1;
+        }
+        ++clock;
+        tick();
+    }
+}
+
+void FlowTimerWheel::tick()
+{
+    // refill the lower levels first when their index wraps
+    for ( unsigned lvl = 1; lvl < levels; ++lvl )
+    {
+        unsigned shift = bits * lvl;
+
+        if ( clock & (((time_t)1 << shift) - 1) )
+            break;
+
+        cascade(lvl * slots + ((clock >> shift) & (slots - 1)));
+    }
+
+    unsigned slot = clock & (slots - 1);
+
+    while ( Flow* flow = heads[slot] )
+    {
+        unlink(flow);
+        insert(flow, due_slot);
+    }
+}
+
+void FlowTimerWheel::cascade(unsigned slot)
+{
+    Flow* flow = heads[slot];
+
+    while ( flow )
+    {
+        Flow* next = flow->timer_next;
+        unlink(flow);
+        insert(flow, get_slot(flow->timer_deadline));
+        assert(flow->timer_slot != slot + 1);
+        flow = next;
+    }
+}
+
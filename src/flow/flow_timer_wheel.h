@@ -0,0 +1,84 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// flow_timer_wheel.h - per thread expiration schedule for flows
+
+#ifndef FLOW_TIMER_WHEEL_H
+#define FLOW_TIMER_WHEEL_H
+
+// FlowTimerWheel schedules flows by deadline in one second ticks.  there
+// are 4 levels of 64 slots so any deadline up to about 194 days out is a
+// single list insertion; farther deadlines are clamped and reinserted when
+// they come up.  as the clock advances, higher level slots cascade down and
+// each level 0 slot reached is moved to the due list.
+//
+// the wheel doesn't know how deadlines are computed.  FlowCache checks each
+// due flow and reschedules it if it was seen in the meantime so touching a
+// flow costs nothing here.
+
+#include <ctime>
+
+namespace snort
+{
+class Flow;
+}
+
+class FlowTimerWheel
+{
+public:
+    FlowTimerWheel() = default;
+
+    FlowTimerWheel(const FlowTimerWheel&) = delete;
+    FlowTimerWheel& operator=(const FlowTimerWheel&) = delete;
+
+    // (re)schedule; the clock starts at now if nothing is scheduled
+    void arm(snort::Flow*, time_t deadline, time_t now);
+    void disarm(snort::Flow*);
+
+    // advance the clock to now and return a due flow if any.  the flow
+    // remains due until it is armed again or disarmed.
+    snort::Flow* next_due(time_t now);
+
+    static bool is_armed(const snort::Flow*);
+
+    unsigned get_count() const
+    { return count; }
+
+private:
+    static constexpr unsigned bits = 6;
+    static constexpr unsigned slots = 1 << bits;
+    static constexpr unsigned levels = 4;
+    static constexpr unsigned due_slot = levels * slots;
+
+    unsigned get_slot(time_t deadline) const;
+    void insert(snort::Flow*, unsigned slot);
+    void unlink(snort::Flow*);
+
+    void advance(time_t now);
+    void tick();
+    void cascade(unsigned slot);
+
+private:
+    snort::Flow* heads[due_slot + 1] { };
+    unsigned level_count[levels] { };
+    unsigned count = 0;
+    time_t clock = 0;
+};
+
+#endif
+
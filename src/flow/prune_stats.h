@@ -35,6 +35,7 @@ enum class PruneReason : uint8_t
     MEMCAP,
     HA,
     STALE,
+    TIMEOUT,
     NONE,
     MAX
 };
@@ -73,7 +73,9 @@ DetectionEngine::~DetectionEngine() = default;
 void Flow::init(PktType) { }
 void Flow::term() { }
 void Flow::flush(bool) { }
-void Flow::reset(bool) { }
+void Flow::reset(bool, FlowDataQueue*) { }
+FlowData::~FlowData() = default;
+void FlowData::update_deallocations(size_t) { }
 void Flow::free_flow_data() { }
 void set_network_policy(const SnortConfig*, unsigned) { }
 void DataBus::publish(const char*, const uint8_t*, unsigned, Flow*) { }
@@ -91,13 +93,13 @@ ExpectCache::ExpectCache(uint32_t) { }
 bool ExpectCache::check(Packet*, Flow*) { return true; }
 bool ExpectCache::is_expected(Packet*) { return true; }
 Flow* HighAvailabilityManager::import(Packet&, FlowKey&) { return nullptr; }
-bool HighAvailabilityManager::in_standby(Flow*) { return true; }
+bool HighAvailabilityManager::in_standby(Flow*) { return false; }
 SfIpRet SfIp::set(void const*, int) { return SFIP_SUCCESS; }
 namespace memory
 {
 void MemoryCap::update_allocations(size_t) { }
 void MemoryCap::update_deallocations(size_t) { }
-bool MemoryCap::over_threshold() { return true; }
+void MemoryCap::reclaim() { }
 }
 
 namespace snort
@@ -259,6 +261,159 @@ TEST(flow_prune, prune_all_blocked_flows)
     delete cache;
 }
 
+// Same as prune_flows but with flows stored in the open addressing table
+TEST(flow_prune, open_table_prune_flows)
+{
+    FlowCacheConfig fcg;
+    fcg.max_flows = 3;
+    fcg.table_type = FlowTableType::OPEN;
+    FlowCache *cache = new FlowCache(fcg);
+    int port = 1;
+
+    FlowKey flow_key;
+    memset(&flow_key, 0, sizeof(FlowKey));
+    flow_key.pkt_type = PktType::TCP;
+
+    for ( unsigned i = 0; i < fcg.max_flows; i++ )
+    {
+        flow_key.port_l = port++;
+        Flow* flow = cache->allocate(&flow_key);
+        CHECK(cache->find(&flow_key) == flow);
+    }
+
+    CHECK(cache->get_count() == fcg.max_flows);
+    CHECK(cache->delete_flows(1) == 1);
+    CHECK(cache->get_count() == fcg.max_flows-1);
+    cache->purge();
+    CHECK(cache->get_flows_allocated() == 0);
+    delete cache;
+}
+
+// Flows time out by their own type's timeout regardless of cache order
+TEST(flow_prune, timeout_by_type)
+{
+    FlowCacheConfig fcg;
+    fcg.max_flows = 4;
+    fcg.proto[to_utype(PktType::TCP)].nominal_timeout = 3600;
+    fcg.proto[to_utype(PktType::UDP)].nominal_timeout = 30;
+    FlowCache *cache = new FlowCache(fcg);
+
+    FlowKey flow_key;
+    memset(&flow_key, 0, sizeof(FlowKey));
+
+    flow_key.port_l = 1;
+    flow_key.pkt_type = PktType::TCP;
+    cache->allocate(&flow_key);
+
+    flow_key.pkt_type = PktType::UDP;
+    Flow* flows[3];
+
+    for ( auto& flow : flows )
+    {
+        flow_key.port_l++;
+        flow = cache->allocate(&flow_key);
+    }
+
+    // seen again so rescheduled instead of retired
+    flows[2]->last_data_seen = 20;
+
+    CHECK(cache->timeout(10, 29) == 0);
+    CHECK(cache->timeout(10, 30) == 2);
+    CHECK(cache->get_prunes(PruneReason::TIMEOUT) == 2);
+    CHECK(cache->get_timer_rearms() == 1);
+    CHECK(cache->get_count() == 2);
+
+    CHECK(cache->timeout(10, 50) == 1);
+    CHECK(cache->timeout(10, 3599) == 0);
+    CHECK(cache->timeout(10, 3600) == 1);
+    CHECK(cache->get_count() == 0);
+
+    cache->purge();
+    CHECK(cache->get_flows_allocated() == 0);
+    delete cache;
+}
+
+// A flood of one type is pruned from itself rather than the shared LRU
+TEST(flow_prune, prune_by_share)
+{
+    FlowCacheConfig fcg;
+    fcg.max_flows = 8;
+    fcg.proto[to_utype(PktType::TCP)].share = 50;
+    FlowCache *cache = new FlowCache(fcg);
+
+    FlowKey flow_key;
+    memset(&flow_key, 0, sizeof(FlowKey));
+
+    flow_key.pkt_type = PktType::TCP;
+
+    for ( unsigned i = 0; i < 3; i++ )
+    {
+        flow_key.port_l++;
+        cache->allocate(&flow_key);
+    }
+
+    flow_key.pkt_type = PktType::UDP;
+
+    for ( unsigned i = 0; i < 20; i++ )
+    {
+        flow_key.port_l++;
+        CHECK(cache->allocate(&flow_key) != nullptr);
+    }
+
+    CHECK(cache->get_count() == fcg.max_flows);
+    CHECK(cache->get_type_count(PktType::TCP) == 3);
+    CHECK(cache->get_type_count(PktType::UDP) == 5);
+    CHECK(cache->get_type_prunes(PktType::TCP) == 0);
+    CHECK(cache->get_type_prunes(PktType::UDP) == 15);
+
+    // the oldest tcp flow is still there
+    flow_key.pkt_type = PktType::TCP;
+    flow_key.port_l = 1;
+    CHECK(cache->find(&flow_key) != nullptr);
+
+    cache->purge();
+    CHECK(cache->get_flows_allocated() == 0);
+    CHECK(cache->get_type_count(PktType::UDP) == 0);
+    delete cache;
+}
+
+// Stale flows are pruned even when the type over its share has none
+TEST(flow_prune, prune_stale_by_share)
+{
+    FlowCacheConfig fcg;
+    fcg.max_flows = 8;
+    fcg.pruning_timeout = 30;
+    fcg.proto[to_utype(PktType::TCP)].share = 50;
+    FlowCache *cache = new FlowCache(fcg);
+
+    FlowKey flow_key;
+    memset(&flow_key, 0, sizeof(FlowKey));
+
+    flow_key.pkt_type = PktType::TCP;
+
+    for ( unsigned i = 0; i < 2; i++ )
+    {
+        flow_key.port_l++;
+        cache->allocate(&flow_key);
+    }
+
+    flow_key.pkt_type = PktType::UDP;
+
+    for ( unsigned i = 0; i < 4; i++ )
+    {
+        flow_key.port_l++;
+        cache->allocate(&flow_key)->last_data_seen = 100;
+    }
+
+    CHECK(cache->prune_stale(100, nullptr) == 2);
+    CHECK(cache->get_type_count(PktType::TCP) == 0);
+    CHECK(cache->get_type_count(PktType::UDP) == 4);
+
+    cache->purge();
+    CHECK(cache->get_flows_allocated() == 0);
+    delete cache;
+}
+
 int main(int argc, char** argv)
 {
     return CommandLineTestRunner::RunAllTests(argc, argv);
@@ -76,10 +76,15 @@ ExpectCache::~ExpectCache() = default;
 unsigned FlowCache::purge() { return 1; }
 Flow* FlowCache::find(const FlowKey*) { return nullptr; }
 Flow* FlowCache::allocate(const FlowKey*) { return nullptr; }
+void FlowCache::prefetch(const FlowKey*) { }
 void FlowCache::push(Flow*) { }
 bool FlowCache::prune_one(PruneReason, bool) { return true; }
 unsigned FlowCache::delete_flows(unsigned) { return 0; }
 unsigned FlowCache::timeout(unsigned, time_t) { return 1; }
+void FlowCache::set_queue_limit() { }
+size_t FlowCache::get_memory_held() const { return 0; }
+FlowDataQueue::~FlowDataQueue() = default;
+unsigned FlowDataQueue::drain(unsigned) { return 0; }
 void Flow::init(PktType) { }
 void set_network_policy(const SnortConfig*, unsigned) { }
 void DataBus::publish(const char*, const uint8_t*, unsigned, Flow*) { }
@@ -98,10 +103,11 @@ ExpectCache::ExpectCache(uint32_t) { }
 bool ExpectCache::check(Packet*, Flow*) { return true; }
 bool ExpectCache::is_expected(Packet*) { return true; }
 Flow* HighAvailabilityManager::import(Packet&, FlowKey&) { return nullptr; }
+SfIpRet SfIp::set(void const*, int) { return SFIP_SUCCESS; }
 
 namespace memory
 {
-bool MemoryCap::over_threshold() { return true; }
+void MemoryCap::reclaim() { }
 }
 
 namespace snort
@@ -0,0 +1,285 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// flow_data_test.cc - unit tests and benchmarks for flow data lookup
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/catch.hpp"
+
+#include <vector>
+
+#include "detection/detection_engine.h"
+#include "flow/flow.h"
+#include "flow/flow_data_queue.h"
+#include "flow/flow_stash.h"
+#include "flow/ha.h"
+#include "framework/data_bus.h"
+#include "framework/inspector.h"
+#include "main/snort_config.h"
+#include "memory/memory_cap.h"
+#include "protocols/layer.h"
+#include "protocols/packet.h"
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// stubs
+//-------------------------------------------------------------------------
+
+Packet::Packet(bool) { }
+Packet::~Packet() = default;
+void Inspector::rem_ref() { }
+void Inspector::add_ref() { }
+void memory::MemoryCap::update_allocations(size_t) { }
+void memory::MemoryCap::update_deallocations(size_t) { }
+void memory::MemoryCap::free_space(size_t) { }
+THREAD_LOCAL memory::ArenaStats memory::MemoryArena::stats[(unsigned)memory::Arena::MAX];
+THREAD_LOCAL unsigned memory::MemoryArena::packet_allocs[(unsigned)memory::Arena::MAX];
+bool HighAvailabilityManager::active() { return false; }
+FlowHAState::FlowHAState() = default;
+void FlowHAState::reset() { }
+FlowStash::~FlowStash() = default;
+void FlowStash::reset() { }
+void DetectionEngine::onload(Flow*) { }
+Packet* DetectionEngine::set_next_packet(Packet*, Flow*) { return nullptr; }
+IpsContext* DetectionEngine::get_context() { return nullptr; }
+DetectionEngine::DetectionEngine() = default;
+DetectionEngine::~DetectionEngine() = default;
+bool layer::set_outer_ip_api(const Packet* const, ip::IpApi&, int8_t&) { return false; }
+uint8_t ip::IpApi::ttl() const { return 0; }
+const Layer* layer::get_mpls_layer(const Packet* const) { return nullptr; }
+void DataBus::publish(const char*, Packet*, Flow*) { }
+const SnortConfig* SnortConfig::get_conf() { return nullptr; }
+
+//-------------------------------------------------------------------------
+// helpers
+//-------------------------------------------------------------------------
+
+static unsigned s_deleted = 0;
+static unsigned s_eofs = 0;
+
+class TestData : public FlowData
+{
+public:
+    TestData(unsigned id) : FlowData(id) { }
+    ~TestData() override { ++s_deleted; }
+
+    size_t size_of() override
+    { return sizeof(*this); }
+
+    void handle_eof(Packet*) override
+    { ++s_eofs; }
+};
+
+// frees another item from its destructor like some inspectors do
+class OwnerData : public TestData
+{
+public:
+    OwnerData(unsigned id, Flow* f, unsigned o) : TestData(id), flow(f), other(o) { }
+    ~OwnerData() override { flow->free_flow_data(other); }
+
+private:
+    Flow* flow;
+    unsigned other;
+};
+
+class LaterData : public TestData
+{
+public:
+    LaterData(unsigned id) : TestData(id) { }
+
+    bool can_defer_delete() const override
+    { return true; }
+};
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+TEST_CASE("flow data slots and overflow", "[flow_data]")
+{
+    Flow flow;
+    std::vector<TestData*> fd;
+    const unsigned max = FLOW_DATA_SLOTS + 8;
+
+    for ( unsigned id = 1; id <= max; ++id )
+    {
+        fd.emplace_back(new TestData(id));
+        flow.set_flow_data(fd.back());
+    }
+
+    for ( unsigned id = 1; id <= max; ++id )
+        CHECK(flow.get_flow_data(id) == fd[id - 1]);
+
+    CHECK(flow.get_flow_data(max + 1) == nullptr);
+
+    s_deleted = 0;
+    flow.free_flow_data(2);
+    flow.free_flow_data(max);
+    CHECK(s_deleted == 2);
+    CHECK(flow.get_flow_data(2) == nullptr);
+    CHECK(flow.get_flow_data(max) == nullptr);
+    CHECK(flow.get_flow_data(3) == fd[2]);
+    CHECK(flow.get_flow_data(max - 1) == fd[max - 2]);
+
+    // replacing an id frees the old item
+    TestData* again = new TestData(3);
+    flow.set_flow_data(again);
+    CHECK(s_deleted == 3);
+    CHECK(flow.get_flow_data(3) == again);
+
+    s_eofs = 0;
+    flow.call_handlers(nullptr, true);
+    CHECK(s_eofs == max - 2);
+
+    flow.free_flow_data();
+    CHECK(s_deleted == max + 1);
+
+    for ( unsigned id = 1; id <= max; ++id )
+        CHECK(flow.get_flow_data(id) == nullptr);
+}
+
+TEST_CASE("flow data freed by a destructor", "[flow_data]")
+{
+    Flow flow;
+    s_deleted = 0;
+
+    flow.set_flow_data(new OwnerData(1, &flow, FLOW_DATA_SLOTS + 1));
+    flow.set_flow_data(new TestData(FLOW_DATA_SLOTS + 1));
+    flow.set_flow_data(new OwnerData(FLOW_DATA_SLOTS + 2, &flow, 4));
+    flow.set_flow_data(new TestData(4));
+
+    flow.free_flow_data();
+    CHECK(s_deleted == 4);
+    CHECK(flow.get_flow_data(1) == nullptr);
+    CHECK(flow.get_flow_data(FLOW_DATA_SLOTS + 2) == nullptr);
+}
+
+TEST_CASE("flow data deferred delete", "[flow_data]")
+{
+    Flow flow;
+    FlowDataQueue fdq;
+    s_deleted = 0;
+
+    flow.set_flow_data(new LaterData(1));
+    flow.set_flow_data(new TestData(2));
+    flow.set_flow_data(new LaterData(FLOW_DATA_SLOTS + 1));
+
+    // disabled
+    flow.free_flow_data(fdq);
+    CHECK(s_deleted == 3);
+    CHECK(fdq.get_depth() == 0);
+
+    flow.set_flow_data(new LaterData(1));
+    flow.set_flow_data(new TestData(2));
+    flow.set_flow_data(new LaterData(3));
+    flow.set_flow_data(new LaterData(FLOW_DATA_SLOTS + 1));
+
+    // only as many as the limit are held
+    fdq.set_limit(2);
+    flow.free_flow_data(fdq);
+    CHECK(s_deleted == 5);
+    CHECK(fdq.get_depth() == 2);
+    CHECK(flow.get_flow_data(1) == nullptr);
+    CHECK(flow.get_flow_data(FLOW_DATA_SLOTS + 1) == nullptr);
+
+    CHECK(fdq.drain(1) == 1);
+    CHECK(s_deleted == 6);
+    CHECK(fdq.drain(8) == 1);
+    CHECK(s_deleted == 7);
+    CHECK(fdq.drain(8) == 0);
+
+    const FlowDataQueueStats& stats = fdq.get_stats();
+    CHECK(stats.deferred == 2);
+    CHECK(stats.deleted == 2);
+    CHECK(stats.max_depth == 2);
+}
+
+//-------------------------------------------------------------------------
+// benchmarks
+//-------------------------------------------------------------------------
+
+#ifdef BENCHMARK_TEST
+
+// the lookup flows used before the slots were added
+static FlowData* list_lookup(FlowData* head, unsigned id)
+{
+    while ( head )
+    {
+        if ( head->get_id() == id )
+            return head;
+
+        head = head->next;
+    }
+    return nullptr;
+}
+
+TEST_CASE("flow data access per packet", "[flow_data]")
+{
+    // a typical http flow: stream, appid, http_inspect, http2, file, rna
+    // and a few others, each looked up several times per packet
+    const unsigned ids[] = { 1, 3, 5, 7, 9, 11, 13, 15 };
+    const unsigned lookups = 4;
+
+    std::vector<Flow> flows(1024);
+    std::vector<FlowData*> heads(flows.size(), nullptr);
+
+    for ( unsigned f = 0; f < flows.size(); ++f )
+    {
+        for ( auto id : ids )
+        {
+            TestData* fd = new TestData(id);
+            flows[f].set_flow_data(fd);
+
+            fd->next = heads[f];
+            heads[f] = fd;
+        }
+    }
+
+    BENCHMARK("linked list")
+    {
+        uintptr_t sum = 0;
+
+        for ( auto head : heads )
+            for ( unsigned i = 0; i < lookups; ++i )
+                for ( auto id : ids )
+                    sum += (uintptr_t)list_lookup(head, id);
+
+        return sum;
+    };
+
+    BENCHMARK("slots")
+    {
+        uintptr_t sum = 0;
+
+        for ( const auto& flow : flows )
+            for ( unsigned i = 0; i < lookups; ++i )
+                for ( auto id : ids )
+                    sum += (uintptr_t)flow.get_flow_data(id);
+
+        return sum;
+    };
+
+    for ( auto& flow : flows )
+        flow.free_flow_data();
+}
+
+#endif
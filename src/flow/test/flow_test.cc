@@ -52,6 +52,8 @@ void memory::MemoryCap::update_allocations(size_t) {}
 void memory::MemoryCap::update_deallocations(size_t) {}
 
 void memory::MemoryCap::free_space(size_t) { }
+THREAD_LOCAL memory::ArenaStats memory::MemoryArena::stats[(unsigned)memory::Arena::MAX];
+THREAD_LOCAL unsigned memory::MemoryArena::packet_allocs[(unsigned)memory::Arena::MAX];
 
 bool HighAvailabilityManager::active() { return false; }
 
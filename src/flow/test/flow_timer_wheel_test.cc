@@ -0,0 +1,160 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// flow_timer_wheel_test.cc - flow expiration schedule checks
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cstring>
+
+#include "flow/flow.h"
+#include "flow/flow_timer_wheel.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace snort;
+
+Flow::Flow() { memset(this, 0, sizeof(*this)); }
+Flow::~Flow() = default;
+
+// step one second at a time and return when flow came due
+static time_t due_at(FlowTimerWheel& tw, Flow* flow, time_t from, time_t to)
+{
+    for ( time_t t = from; t <= to; ++t )
+    {
+        if ( Flow* f = tw.next_due(t) )
+        {
+            CHECK(f == flow);
+            tw.disarm(f);
+            return t;
+        }
+    }
+    return 0;
+}
+
+TEST_GROUP(flow_timer_wheel) { };
+
+TEST(flow_timer_wheel, due_at_deadline)
+{
+    FlowTimerWheel tw;
+    Flow flow;
+
+    tw.arm(&flow, 105, 100);
+    CHECK(tw.is_armed(&flow));
+    CHECK(tw.get_count() == 1);
+
+    CHECK(tw.next_due(104) == nullptr);
+    CHECK(tw.next_due(105) == &flow);
+
+    // still due until handled
+    CHECK(tw.next_due(106) == &flow);
+    tw.disarm(&flow);
+
+    CHECK(!tw.is_armed(&flow));
+    CHECK(tw.get_count() == 0);
+    CHECK(tw.next_due(200) == nullptr);
+}
+
+TEST(flow_timer_wheel, each_level)
+{
+    const time_t deadlines[] = { 1030, 1000 + 5000, 1000 + 300000, 1000 + 2000000 };
+
+    for ( auto d : deadlines )
+    {
+        FlowTimerWheel tw;
+        Flow flow, other;
+
+        // another flow keeps the clock from jumping
+        tw.arm(&other, 1000 + 20000000, 1000);
+        tw.arm(&flow, d, 1000);
+
+        CHECK(due_at(tw, &flow, 1000, d) == d);
+        CHECK(tw.get_count() == 1);
+        tw.disarm(&other);
+    }
+}
+
+TEST(flow_timer_wheel, beyond_range)
+{
+    FlowTimerWheel tw;
+    Flow flow;
+    time_t far = 1000 + 40000000;
+
+    // clamped to the top level and inserted again when it comes up
+    tw.arm(&flow, far, 1000);
+    CHECK(due_at(tw, &flow, 1000, far) == far);
+}
+
+TEST(flow_timer_wheel, rearm)
+{
+    FlowTimerWheel tw;
+    Flow a, b;
+
+    tw.arm(&a, 105, 100);
+    tw.arm(&b, 110, 100);
+    tw.arm(&a, 200, 101);
+    CHECK(tw.get_count() == 2);
+
+    CHECK(tw.next_due(105) == nullptr);
+    CHECK(tw.next_due(110) == &b);
+    tw.disarm(&b);
+
+    CHECK(tw.next_due(199) == nullptr);
+    CHECK(tw.next_due(200) == &a);
+
+    // due flows are rescheduled by arming again
+    tw.arm(&a, 300, 200);
+    CHECK(tw.next_due(200) == nullptr);
+    CHECK(tw.next_due(300) == &a);
+    tw.disarm(&a);
+}
+
+TEST(flow_timer_wheel, jump)
+{
+    FlowTimerWheel tw;
+    Flow flows[8];
+    time_t now = 1000;
+
+    for ( unsigned i = 0; i < 8; ++i )
+        tw.arm(flows + i, now + (1 << (3 * i)), now);
+
+    // past deadlines are due on the next check
+    Flow late;
+    tw.arm(&late, now - 10, now);
+    CHECK(tw.next_due(now) == &late);
+    tw.disarm(&late);
+
+    unsigned n = 0;
+
+    while ( Flow* f = tw.next_due(now + 10000000) )
+    {
+        tw.disarm(f);
+        ++n;
+    }
+    CHECK(n == 8);
+    CHECK(tw.get_count() == 0);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
+
@@ -149,6 +149,9 @@ struct CodecData
     uint8_t curr_ip6_extension = 0;
     IpProtocol ip6_csum_proto = IpProtocol::IP;   /* Used for IPv6 checksums */
     bool tunnel_bypass = false;
+    bool lazy_checksums = false;
+
+    DeferredChecksum deferred_cksum { };
 
     CompoundLayer compound_layers[COMPOUND_LAYERS_MAX]{};
     uint8_t compound_layer_cnt = 0;
@@ -158,6 +161,18 @@ struct CodecData
 
     bool inline is_cooked() const
     { return codec_flags & CODEC_STREAM_REBUILT; }
+
+    // returns true if the checksum of this layer will be evaluated later.
+    // only one is deferred per packet and never while probing an encap.
+    bool defer_checksum(const RawData& raw, uint32_t pseudo_sum, uint16_t err_flag)
+    {
+        if ( !lazy_checksums or deferred_cksum.pending() or
+            (codec_flags & (CODEC_STREAM_REBUILT | CODEC_UNSURE_ENCAP)) )
+            return false;
+
+        deferred_cksum = { raw.data, raw.len, pseudo_sum, err_flag };
+        return true;
+    }
 };
 
 typedef uint64_t EncodeFlags;
@@ -384,7 +399,7 @@ private:
 //-------------------------------------------------------------------------
 
 // this is the current version of the api
-#define CDAPI_VERSION ((BASE_API_VERSION << 16) | 1)
+#define CDAPI_VERSION ((BASE_API_VERSION << 16) | 2)
 
 typedef Codec* (* CdNewFunc)(Module*);
 typedef void (* CdDelFunc)(Codec*);
@@ -145,5 +145,24 @@ struct DecodeData
     { return type; }
 };
 
+// a tcp or udp checksum left for evaluation until the packet is known to be
+// inspected.  see network.checksum_lazy.
+struct DeferredChecksum
+{
+    const uint8_t* data;    // start of the l4 header; nullptr if none pending
+    uint32_t len;
+    uint32_t pseudo_sum;    // unfolded sum of the pseudoheader
+    uint16_t err_flag;      // DECODE_ERR_CKSUM_* to set if bad
+
+    bool pending() const
+    { return data != nullptr; }
+
+    void reset()
+    {
+        data = nullptr;
+        err_flag = 0;
+    }
+};
+
 #endif
 
@@ -44,7 +44,7 @@ struct SnortConfig;
 class Module;
 
 // this is the current version of the api
-#define IPSAPI_VERSION ((BASE_API_VERSION << 16) | 0)
+#define IPSAPI_VERSION ((BASE_API_VERSION << 16) | 1)
 
 enum CursorActionType
 {
@@ -108,6 +108,11 @@ public:
     virtual PatternMatchData* get_alternate_pattern()
     { return nullptr; }
 
+    // for regex options that search the whole buffer, like pcre; the
+    // regex must be hyperscan compatible and flags are HS_FLAG_*
+    virtual const char* get_prefilter(unsigned& /*flags*/) const
+    { return nullptr; }
+
     static void set_buffer(const char*);
 
 protected:
@@ -23,7 +23,9 @@
 
 #include "mpse.h"
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 #include "profiler/profiler_defs.h"
 #include "search_engines/pat_stats.h"
@@ -97,6 +99,67 @@ void Mpse::_search(MpseBatch& batch, MpseType mpse_type)
     }
 }
 
+void Mpse::search(MpseBatch** batches, unsigned n, MpseType mpse_type)
+{
+    _search(batches, n, mpse_type);
+}
+
+void Mpse::_search(MpseBatch** batches, unsigned n, MpseType mpse_type)
+{
+    vector<MpseGroup*> groups;
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        for ( auto& item : batches[i]->items )
+        {
+            if ( item.second.done )
+                continue;
+
+            item.second.error = false;
+            item.second.matches = 0;
+
+            for ( auto* so : item.second.so )
+            {
+                if ( find(groups.begin(), groups.end(), so) == groups.end() )
+                    groups.emplace_back(so);
+            }
+        }
+    }
+
+    for ( auto* so : groups )
+    {
+        Mpse* mpse = (mpse_type == MPSE_TYPE_OFFLOAD) ?
+            so->get_offload_mpse() : so->get_normal_mpse();
+
+        for ( unsigned i = 0; i < n; ++i )
+        {
+            MpseBatch* b = batches[i];
+
+            for ( auto& item : b->items )
+            {
+                if ( item.second.done )
+                    continue;
+
+                for ( auto* s : item.second.so )
+                {
+                    if ( s != so )
+                        continue;
+
+                    int start_state = 0;
+                    item.second.matches += mpse->search(
+                        item.first.buf, item.first.len, b->mf, b->context, &start_state);
+                }
+            }
+        }
+    }
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        for ( auto& item : batches[i]->items )
+            item.second.done = true;
+    }
+}
+
 Mpse::MpseRespType Mpse::poll_responses(MpseBatch*& batch, MpseType mpse_type)
 {
     // FIXIT-L validate for reload during offload
@@ -36,7 +36,7 @@
 namespace snort
 {
 // this is the current version of the api
-#define SEAPI_VERSION ((BASE_API_VERSION << 16) | 0)
+#define SEAPI_VERSION ((BASE_API_VERSION << 16) | 1)
 
 struct SnortConfig;
 class Mpse;
@@ -89,6 +89,9 @@ public:
 
     void search(MpseBatch&, MpseType);
 
+    // search the batches of several packets together
+    void search(MpseBatch**, unsigned n, MpseType);
+
     virtual MpseRespType receive_responses(MpseBatch&, MpseType)
     { return MPSE_RESP_COMPLETE_SUCCESS; }
 
@@ -112,6 +115,10 @@ protected:
 
     virtual void _search(MpseBatch&, MpseType);
 
+    // the default runs each search engine over all of the batches in turn
+    // to keep its tables in cache
+    virtual void _search(MpseBatch**, unsigned n, MpseType);
+
 private:
     std::string method;
     int verbose;
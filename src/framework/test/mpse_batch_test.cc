@@ -0,0 +1,351 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mpse_batch_test.cc - combined search of several packets' batches
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/catch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "framework/mpse.h"
+#include "framework/mpse_batch.h"
+#include "main/snort_config.h"
+#include "search_engines/acsmx2.h"
+#include "search_engines/pat_stats.h"
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// stubs
+//-------------------------------------------------------------------------
+
+namespace snort
+{
+THREAD_LOCAL PatMatQStat pmqs;
+
+SnortConfig::SnortConfig(const SnortConfig* const) { }
+SnortConfig::~SnortConfig() = default;
+
+const SnortConfig* SnortConfig::get_conf() { return nullptr; }
+
+void LogValue(const char*, const char*, FILE*) { }
+void LogMessage(const char*, ...) { }
+void LogCount(char const*, uint64_t, FILE*) { }
+void LogStat(const char*, double, FILE*) { }
+
+MpseGroup::~MpseGroup()
+{
+    delete normal_mpse;
+}
+}
+
+static MpseAgent s_agent =
+{
+    [](SnortConfig*, void* id, void** ppt)
+    {
+        if ( id )
+            *ppt = id;
+        return 0;
+    },
+    [](void*, void**) { return 0; },
+
+    [](void*) { },
+    [](void**) { },
+    [](void**) { }
+};
+
+//-------------------------------------------------------------------------
+// helpers
+//-------------------------------------------------------------------------
+
+class AcMpse : public Mpse
+{
+public:
+    AcMpse() : Mpse("ac_test")
+    {
+        acsm = acsmNew2(&s_agent, ACF_FULL);
+        acsm->enable_dfa();
+    }
+
+    ~AcMpse() override
+    { acsmFree2(acsm); }
+
+    int add_pattern(const uint8_t* pat, unsigned len, const PatternDescriptor&, void* user) override
+    { return acsmAddPattern2(acsm, pat, len, false, false, user); }
+
+    int prep_patterns(SnortConfig*) override
+    { return acsmCompile2(nullptr, acsm); }
+
+    int _search(const uint8_t* T, int n, MpseMatch mf, void* context, int* state) override
+    { return acsm_search_dfa_full(acsm, T, n, mf, context, state); }
+
+private:
+    ACSM_STRUCT2* acsm;
+};
+
+struct Hit
+{
+    uintptr_t id;
+    int index;
+
+    bool operator<(const Hit& h) const
+    { return id < h.id or (id == h.id and index < h.index); }
+
+    bool operator==(const Hit& h) const
+    { return id == h.id and index == h.index; }
+};
+
+static int match(void* id, void*, int index, void* context, void*)
+{
+    std::vector<Hit>* hits = (std::vector<Hit>*)context;
+    hits->push_back({ (uintptr_t)id, index });
+    return 0;
+}
+
+static std::string make_text(std::mt19937& rng, unsigned n)
+{
+    std::string s(n, ' ');
+
+    for ( auto& c : s )
+        c = 'a' + rng() % 8;
+
+    return s;
+}
+
+// several groups as if from different port groups and buffers
+struct Groups
+{
+    Groups(std::mt19937& rng, unsigned num, unsigned pats)
+    {
+        for ( unsigned g = 0; g < num; ++g )
+        {
+            AcMpse* mpse = new AcMpse;
+
+            for ( unsigned i = 0; i < pats; ++i )
+            {
+                std::string p = make_text(rng, 4 + rng() % 6);
+                mpse->add_pattern((const uint8_t*)p.c_str(), p.size(), { },
+                    (void*)(uintptr_t)((g << 16) + i + 1));
+            }
+            mpse->prep_patterns(nullptr);
+            groups.emplace_back(new MpseGroup(mpse));
+        }
+    }
+
+    ~Groups()
+    {
+        for ( auto* g : groups )
+            delete g;
+    }
+
+    std::vector<MpseGroup*> groups;
+};
+
+// each packet has a few buffers, each searched with some of the groups
+struct Packets
+{
+    Packets(std::mt19937& rng, const Groups& g, unsigned num)
+    {
+        data.resize(num);
+        hits.resize(num);
+        batches.resize(num);
+
+        for ( unsigned i = 0; i < num; ++i )
+        {
+            for ( unsigned b = 0; b < 3; ++b )
+                data[i].emplace_back(make_text(rng, 256 + rng() % 1024));
+
+            batches[i].mf = match;
+            batches[i].context = &hits[i];
+        }
+        for ( unsigned i = 0; i < num; ++i )
+        {
+            for ( auto& d : data[i] )
+            {
+                MpseBatchKey<> key((const uint8_t*)d.c_str(), d.size());
+                auto& item = batches[i].items[key];
+                item.so.push_back(g.groups[rng() % g.groups.size()]);
+                item.so.push_back(g.groups[rng() % g.groups.size()]);
+            }
+        }
+    }
+
+    void reset()
+    {
+        for ( unsigned i = 0; i < batches.size(); ++i )
+        {
+            hits[i].clear();
+
+            for ( auto& item : batches[i].items )
+                item.second.done = false;
+        }
+    }
+
+    void search(unsigned size)
+    {
+        std::vector<MpseBatch*> v;
+
+        for ( unsigned i = 0; i < batches.size(); i += size )
+        {
+            v.clear();
+
+            for ( unsigned j = i; j < i + size and j < batches.size(); ++j )
+                v.emplace_back(&batches[j]);
+
+            Mpse* mpse = v[0]->items.begin()->second.so[0]->get_normal_mpse();
+
+            if ( size == 1 )
+                mpse->search(*v[0], Mpse::MPSE_TYPE_NORMAL);
+            else
+                mpse->search(v.data(), v.size(), Mpse::MPSE_TYPE_NORMAL);
+        }
+    }
+
+    std::vector<std::vector<std::string>> data;
+    std::vector<std::vector<Hit>> hits;
+    std::vector<MpseBatch> batches;
+};
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+TEST_CASE("combined batches", "[mpse_batch]")
+{
+    std::mt19937 rng(7);
+    Groups g(rng, 4, 200);
+    Packets pkts(rng, g, 40);
+
+    pkts.search(1);
+    auto expected = pkts.hits;
+    unsigned total = 0;
+
+    for ( auto& h : expected )
+    {
+        std::sort(h.begin(), h.end());
+        total += h.size();
+    }
+    CHECK(total > 0);
+
+    for ( unsigned size : { 2, 7, 40, 64 } )
+    {
+        pkts.reset();
+        pkts.search(size);
+
+        for ( unsigned i = 0; i < pkts.hits.size(); ++i )
+        {
+            std::sort(pkts.hits[i].begin(), pkts.hits[i].end());
+            CHECK(pkts.hits[i] == expected[i]);
+
+            for ( auto& item : pkts.batches[i].items )
+                CHECK(item.second.done);
+        }
+    }
+}
+
+TEST_CASE("combined batches skip done", "[mpse_batch]")
+{
+    std::mt19937 rng(11);
+    Groups g(rng, 2, 50);
+    Packets pkts(rng, g, 4);
+
+    pkts.search(4);
+    auto first = pkts.hits;
+
+    // nothing is searched again until reset
+    pkts.search(4);
+    CHECK(pkts.hits == first);
+}
+
+// a batched pdu is searched after its segments are purged so stream_tcp
+// must not inspect it in place
+TEST_CASE("batches disable zero copy", "[mpse_batch]")
+{
+    SnortConfig sc;
+    CHECK(!sc.offload_enabled());
+
+    sc.batch_size = 1;
+    CHECK(!sc.offload_enabled());
+
+    sc.batch_size = 8;
+    CHECK(sc.offload_enabled());
+
+    sc.batch_size = 0;
+    sc.offload_threads = 2;
+    CHECK(sc.offload_enabled());
+}
+
+#ifdef BENCHMARK_TEST
+// packets per iteration is fixed so the times compare packets / sec
+TEST_CASE("combined batch sizes", "[mpse_batch]")
+{
+    std::mt19937 rng(13);
+    Groups g(rng, 16, 5000);
+    Packets pkts(rng, g, 256);
+
+    for ( unsigned size : { 1, 4, 16, 64, 256 } )
+    {
+        std::string name = "256 packets, batch " + std::to_string(size);
+
+        BENCHMARK(name.c_str())
+        {
+            pkts.reset();
+            pkts.search(size);
+        };
+    }
+}
+
+// the same work reported as packets / sec for each batch size
+TEST_CASE("combined batch packets per second", "[mpse_batch]")
+{
+    std::mt19937 rng(13);
+    Groups g(rng, 16, 5000);
+    Packets pkts(rng, g, 256);
+
+    for ( unsigned size : { 1, 4, 16, 64, 256 } )
+    {
+        using clock = std::chrono::steady_clock;
+        auto start = clock::now();
+        std::chrono::duration<double> secs;
+        unsigned iters = 0;
+
+        do
+        {
+            pkts.reset();
+            pkts.search(size);
+            ++iters;
+            secs = clock::now() - start;
+        }
+        while ( secs.count() < 1.0 );
+
+        double pps = 256.0 * iters / secs.count();
+        printf("batch %3u: %.0f packets/sec\n", size, pps);
+        CHECK(pps > 0);
+    }
+}
+#endif
+
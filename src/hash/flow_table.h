@@ -0,0 +1,63 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef FLOW_TABLE_H
+#define FLOW_TABLE_H
+
+// FlowTable is the interface a FlowCache uses to store flows by key.
+// nodes are provisioned up front with push() and recycled by get() and
+// release_node(); data pointers are opaque to the table.  the table also
+// maintains an lru list with a cursor used by pruning and timeouts.
+
+#include <cstddef>
+
+class FlowTable
+{
+public:
+    virtual ~FlowTable() = default;
+
+    // add an unused node for data; returns the node's key storage
+    virtual void* push(void* data) = 0;
+
+    // delete an unused node; returns its data or nullptr if none left
+    virtual void* pop() = 0;
+
+    // find key or insert it using an unused node; nullptr if none left
+    virtual void* get(const void* key) = 0;
+    virtual void* get_user_data(const void* key) = 0;
+
+    // return the node for key to the unused list; HASH_OK if found
+    virtual int release_node(const void* key) = 0;
+
+    // unlink and delete the node at the lru cursor; returns its data
+    virtual void* remove() = 0;
+
+    virtual void* lru_first() = 0;
+    virtual void* lru_next() = 0;
+    virtual void* lru_current() = 0;
+    virtual void lru_touch() = 0;
+
+    // hint that key will be looked up soon
+    virtual void prefetch(const void*) { }
+
+    virtual unsigned get_num_nodes() = 0;
+    virtual size_t get_node_size() const = 0;
+};
+
+#endif
+
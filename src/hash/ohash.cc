@@ -0,0 +1,423 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "ohash.h"
+
+#include <cassert>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "flow/flow_key.h"
+#include "utils/util.h"
+
+#include "hash_defs.h"
+#include "hash_key_operations.h"
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// tags
+//-------------------------------------------------------------------------
+
+// live tags are the top 7 bits of the hash so free slots are exactly
+// those with the high bit set
+static const uint8_t EMPTY = 0x80;
+static const uint8_t DELETED = 0xFE;
+
+static inline uint8_t get_tag(uint32_t hash)
+{ return hash >> 25; }
+
+#ifdef __SSE2__
+static inline unsigned match_tag(const uint8_t* group, uint8_t tag)
+{
+    __m128i g = _mm_loadu_si128((const __m128i*)group);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)tag)));
+}
+
+static inline unsigned match_free(const uint8_t* group)
+{
+    __m128i g = _mm_loadu_si128((const __m128i*)group);
+    return _mm_movemask_epi8(g);
+}
+#else
+static inline unsigned match_tag(const uint8_t* group, uint8_t tag)
+{
+    unsigned m = 0;
+
+    for ( unsigned i = 0; i < OHash::group_size; ++i )
+        if ( group[i] == tag )
+            m |= (1u << i);
+
+    return m;
+}
+
+static inline unsigned match_free(const uint8_t* group)
+{
+    unsigned m = 0;
+
+    for ( unsigned i = 0; i < OHash::group_size; ++i )
+        if ( group[i] & 0x80 )
+            m |= (1u << i);
+
+    return m;
+}
+#endif
+
+//-------------------------------------------------------------------------
+// nodes
+//-------------------------------------------------------------------------
+
+struct OHash::Node
+{
+    Node* gnext;     // toward lru or next unused
+    Node* gprev;     // toward mru
+    void* data;
+    uint32_t hash;
+    uint32_t slot;
+
+    uint8_t* key()
+    { return (uint8_t*)this + sizeof(*this); }
+};
+
+//-------------------------------------------------------------------------
+// table
+//-------------------------------------------------------------------------
+
+OHash::OHash(unsigned max_nodes, unsigned key_len) :
+    keysize(key_len), node_size(sizeof(Node) + key_len)
+{
+    // keep load under 1/2 for the configured node count; more nodes
+    // may be pushed later (eg on reload) and the table grows as needed
+    unsigned size = hash_nearest_power_of_2(2 * max_nodes);
+
+    if ( size < 2 * group_size )
+        size = 2 * group_size;
+
+    hashkey_ops = new FlowHashKeyOps(size);
+    allocate_table(size);
+}
+
+OHash::~OHash()
+{
+    for ( Node* list : { head, free_list } )
+    {
+        while ( list )
+        {
+            Node* node = list;
+            list = list->gnext;
+            snort_free(node);
+        }
+    }
+    delete[] tags;
+    delete[] slots;
+    delete hashkey_ops;
+}
+
+void OHash::allocate_table(unsigned size)
+{
+    num_slots = size;
+    group_mask = (size / group_size) - 1;
+    num_used = 0;
+
+    tags = new uint8_t[size];
+    memset(tags, EMPTY, size);
+
+    slots = new Node*[size]();
+}
+
+void OHash::rehash(unsigned size)
+{
+    delete[] tags;
+    delete[] slots;
+
+    allocate_table(size);
+
+    for ( Node* node = head; node; node = node->gnext )
+        link(node);
+}
+
+uint32_t OHash::hash(const void* key)
+{ return hashkey_ops->do_hash((const unsigned char*)key, keysize); }
+
+OHash::Node* OHash::find(const void* key, uint32_t h)
+{
+    const uint8_t tag = get_tag(h);
+    unsigned g = h & group_mask;
+
+    for ( unsigned n = 0; n <= group_mask; ++n )
+    {
+        const unsigned base = g * group_size;
+        const uint8_t* group = tags + base;
+        unsigned m = match_tag(group, tag);
+
+        while ( m )
+        {
+            Node* node = slots[base + __builtin_ctz(m)];
+
+            if ( node->hash == h and hashkey_ops->key_compare(node->key(), key, keysize) )
+                return node;
+
+            m &= m - 1;
+        }
+
+        // nothing was ever displaced past a group with an empty slot
+        if ( match_tag(group, EMPTY) )
+            break;
+
+        g = (g + 1) & group_mask;
+    }
+
+    return nullptr;
+}
+
+void OHash::link(Node* node)
+{
+    unsigned g = node->hash & group_mask;
+
+    // terminates because load is kept under 7/8
+    while ( true )
+    {
+        const unsigned base = g * group_size;
+
+        if ( unsigned m = match_free(tags + base) )
+        {
+            unsigned i = base + __builtin_ctz(m);
+
+            if ( tags[i] == EMPTY )
+                ++num_used;
+
+            tags[i] = get_tag(node->hash);
+            slots[i] = node;
+            node->slot = i;
+            return;
+        }
+        g = (g + 1) & group_mask;
+    }
+}
+
+void OHash::unlink(Node* node)
+{
+    unsigned i = node->slot;
+    const uint8_t* group = tags + (i & ~(group_size - 1));
+
+    // a group with an empty slot has never been full so no probe
+    // sequence continues past it and the slot can be emptied
+    if ( match_tag(group, EMPTY) )
+    {
+        tags[i] = EMPTY;
+        --num_used;
+    }
+    else
+        tags[i] = DELETED;
+
+    slots[i] = nullptr;
+}
+
+//-------------------------------------------------------------------------
+// lru
+//-------------------------------------------------------------------------
+
+void OHash::lru_insert(Node* node)
+{
+    node->gprev = nullptr;
+    node->gnext = head;
+
+    if ( head )
+        head->gprev = node;
+    else
+        tail = node;
+
+    head = node;
+}
+
+void OHash::lru_remove(Node* node)
+{
+    if ( cursor == node )
+        cursor = node->gprev;
+
+    if ( head == node )
+        head = node->gnext;
+
+    if ( tail == node )
+        tail = node->gprev;
+
+    if ( node->gprev )
+        node->gprev->gnext = node->gnext;
+
+    if ( node->gnext )
+        node->gnext->gprev = node->gprev;
+}
+
+void OHash::lru_move_to_front(Node* node)
+{
+    if ( node == cursor )
+        cursor = node->gprev;
+
+    if ( node != head )
+    {
+        lru_remove(node);
+        lru_insert(node);
+    }
+}
+
+void* OHash::lru_first()
+{
+    cursor = tail;
+    return cursor ? cursor->data : nullptr;
+}
+
+void* OHash::lru_next()
+{
+    if ( cursor )
+        cursor = cursor->gprev;
+
+    return cursor ? cursor->data : nullptr;
+}
+
+void* OHash::lru_current()
+{ return cursor ? cursor->data : nullptr; }
+
+void OHash::lru_touch()
+{
+    assert(cursor);
+    lru_move_to_front(cursor);
+}
+
+//-------------------------------------------------------------------------
+// FlowTable methods
+//-------------------------------------------------------------------------
+
+void* OHash::push(void* p)
+{
+    Node* node = (Node*)snort_calloc(node_size);
+    node->data = p;
+    node->gnext = free_list;
+    free_list = node;
+    return node->key();
+}
+
+void* OHash::pop()
+{
+    Node* node = free_list;
+
+    if ( !node )
+        return nullptr;
+
+    free_list = node->gnext;
+    void* pv = node->data;
+    snort_free(node);
+
+    return pv;
+}
+
+void* OHash::get(const void* key)
+{
+    assert(key);
+
+    uint32_t h = hash(key);
+    Node* node = find(key, h);
+
+    if ( node )
+    {
+        lru_move_to_front(node);
+        return node->data;
+    }
+
+    if ( !free_list )
+        return nullptr;
+
+    if ( (num_used + 1) * 8 > num_slots * 7 )
+    {
+        // grow if live nodes would exceed 1/2, otherwise just clear tombstones
+        unsigned size = ((num_nodes + 1) * 2 > num_slots) ? num_slots * 2 : num_slots;
+        rehash(size);
+    }
+
+    node = free_list;
+    free_list = node->gnext;
+
+    memcpy(node->key(), key, keysize);
+    node->hash = h;
+
+    link(node);
+    lru_insert(node);
+    ++num_nodes;
+
+    return node->data;
+}
+
+void* OHash::get_user_data(const void* key)
+{
+    assert(key);
+    Node* node = find(key, hash(key));
+
+    if ( !node )
+        return nullptr;
+
+    lru_move_to_front(node);
+    return node->data;
+}
+
+int OHash::release_node(const void* key)
+{
+    assert(key);
+    Node* node = find(key, hash(key));
+
+    if ( !node )
+        return HASH_NOT_FOUND;
+
+    unlink(node);
+    lru_remove(node);
+    --num_nodes;
+
+    node->gnext = free_list;
+    free_list = node;
+
+    return HASH_OK;
+}
+
+void* OHash::remove()
+{
+    Node* node = cursor;
+    assert(node);
+    void* pv = node->data;
+
+    unlink(node);
+    lru_remove(node);
+    --num_nodes;
+
+    snort_free(node);
+    return pv;
+}
+
+void OHash::prefetch(const void* key)
+{
+    const unsigned base = (hash(key) & group_mask) * group_size;
+
+    __builtin_prefetch(tags + base);
+    __builtin_prefetch(slots + base);
+    __builtin_prefetch(slots + base + group_size / 2);
+}
+
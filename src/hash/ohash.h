@@ -0,0 +1,111 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+#ifndef OHASH_H
+#define OHASH_H
+
+// OHash is an open addressing alternative to ZHash for the flow cache.
+// slots are grouped 16 to a group and each slot has a 1 byte tag holding
+// 7 bits of the key hash.  a lookup compares all tags in a group at once
+// and only visits nodes whose tag matches, so a hit normally costs the
+// tag group, the slot pointer, and the node.  nodes hold the key, the
+// full hash, and the lru links inline and never move, so the key storage
+// returned by push() remains valid for the life of the node.
+//
+// each packet thread has its own flow cache so no locking is required.
+
+#include <cstdint>
+
+#include "hash/flow_table.h"
+
+namespace snort
+{
+class HashKeyOperations;
+}
+
+class OHash final : public FlowTable
+{
+public:
+    OHash(unsigned max_nodes, unsigned keysize);
+    ~OHash() override;
+
+    OHash(const OHash&) = delete;
+    OHash& operator=(const OHash&) = delete;
+
+    void* push(void* p) override;
+    void* pop() override;
+
+    void* get(const void* key) override;
+    void* get_user_data(const void* key) override;
+    int release_node(const void* key) override;
+    void* remove() override;
+
+    void* lru_first() override;
+    void* lru_next() override;
+    void* lru_current() override;
+    void lru_touch() override;
+
+    void prefetch(const void* key) override;
+
+    unsigned get_num_nodes() override
+    { return num_nodes; }
+
+    size_t get_node_size() const override
+    { return node_size; }
+
+    unsigned get_num_slots() const
+    { return num_slots; }
+
+    static const unsigned group_size = 16;
+
+private:
+    struct Node;
+
+    uint32_t hash(const void* key);
+    Node* find(const void* key, uint32_t hash);
+    void link(Node*);
+    void unlink(Node*);
+    void rehash(unsigned size);
+    void allocate_table(unsigned size);
+
+    void lru_insert(Node*);
+    void lru_remove(Node*);
+    void lru_move_to_front(Node*);
+
+private:
+    snort::HashKeyOperations* hashkey_ops;
+
+    uint8_t* tags = nullptr;
+    Node** slots = nullptr;
+
+    unsigned num_slots = 0;
+    unsigned group_mask = 0;
+    unsigned num_used = 0;   // live + deleted slots
+    unsigned num_nodes = 0;  // live slots
+
+    unsigned keysize;
+    size_t node_size;
+
+    Node* free_list = nullptr;
+    Node* head = nullptr;    // mru
+    Node* tail = nullptr;    // lru
+    Node* cursor = nullptr;
+};
+
+#endif
+
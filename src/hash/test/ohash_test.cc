@@ -0,0 +1,389 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ohash_test.cc - unit tests and benchmarks for the open addressing flow table
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/catch.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include "flow/flow_key.h"
+#include "hash/hash_defs.h"
+#include "hash/ohash.h"
+#include "hash/zhash.h"
+#include "main/snort_config.h"
+
+using namespace snort;
+
+namespace snort
+{
+// same hash as flow_key.cc so probe behavior matches production
+unsigned FlowHashKeyOps::do_hash(const unsigned char* k, int)
+{
+    uint32_t a, b, c;
+    a = b = c = hardener;
+
+    const uint32_t* d = (const uint32_t*)k;
+
+    a += d[0]; b += d[1]; c += d[2];
+    mix(a, b, c);
+    a += d[3]; b += d[4]; c += d[5];
+    mix(a, b, c);
+    a += d[6]; b += d[7]; c += d[8];
+    mix(a, b, c);
+    a += d[9]; b += d[10]; c += d[11];
+    mix(a, b, c);
+    a += d[12];
+    finalize(a, b, c);
+
+    return c;
+}
+
+bool FlowHashKeyOps::key_compare(const void* k1, const void* k2, size_t len)
+{ return !memcmp(k1, k2, len); }
+}
+
+// Stubs whose sole purpose is to make the test code link
+static SnortConfig my_config;
+THREAD_LOCAL SnortConfig* snort_conf = &my_config;
+
+SnortConfig::SnortConfig(const SnortConfig* const)
+{ snort_conf->run_flags = 0; }
+
+SnortConfig::~SnortConfig() = default;
+
+const SnortConfig* SnortConfig::get_conf()
+{ return snort_conf; }
+
+//-------------------------------------------------------------------------
+// helpers
+//-------------------------------------------------------------------------
+
+static void make_key(FlowKey& key, unsigned n)
+{
+    memset(&key, 0, sizeof(key));
+    key.ip_l[3] = 0x0a000000 | (n >> 16);
+    key.ip_h[3] = 0xc0a80000 | (n & 0xffff);
+    key.port_l = 1024 + (n % 60000);
+    key.port_h = 80;
+    key.ip_protocol = 6;
+    key.pkt_type = PktType::TCP;
+    key.version = 4;
+}
+
+struct Data
+{
+    unsigned id;
+    FlowKey* key;
+};
+
+static void provision(FlowTable& ft, std::vector<Data>& data)
+{
+    for ( unsigned i = 0; i < data.size(); ++i )
+    {
+        data[i].id = 0;
+        data[i].key = (FlowKey*)ft.push(&data[i]);
+    }
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+TEST_CASE("ohash insert and find", "[ohash]")
+{
+    const unsigned max = 1000;
+    OHash ht(max, sizeof(FlowKey));
+    std::vector<Data> data(max);
+    provision(ht, data);
+
+    FlowKey key;
+
+    for ( unsigned i = 0; i < max; ++i )
+    {
+        make_key(key, i);
+        CHECK(!ht.get_user_data(&key));
+
+        Data* d = (Data*)ht.get(&key);
+        REQUIRE(d);
+        d->id = i + 1;
+        CHECK(!memcmp(d->key, &key, sizeof(key)));
+    }
+    CHECK(ht.get_num_nodes() == max);
+
+    // no unused nodes left
+    make_key(key, max);
+    CHECK(!ht.get(&key));
+
+    for ( unsigned i = 0; i < max; ++i )
+    {
+        make_key(key, i);
+        Data* d = (Data*)ht.get_user_data(&key);
+        REQUIRE(d);
+        CHECK(d->id == i + 1);
+    }
+}
+
+TEST_CASE("ohash lru order", "[ohash]")
+{
+    const unsigned max = 10;
+    OHash ht(max, sizeof(FlowKey));
+    std::vector<Data> data(max);
+    provision(ht, data);
+
+    FlowKey key;
+
+    for ( unsigned i = 0; i < max; ++i )
+    {
+        make_key(key, i);
+        ((Data*)ht.get(&key))->id = i;
+    }
+
+    unsigned n = 0;
+    for ( Data* d = (Data*)ht.lru_first(); d; d = (Data*)ht.lru_next() )
+        CHECK(d->id == n++);
+    CHECK(n == max);
+
+    // lookup moves to mru
+    make_key(key, 0);
+    ht.get_user_data(&key);
+    CHECK(((Data*)ht.lru_first())->id == 1);
+
+    // touch moves lru to mru and advances the cursor
+    ht.lru_touch();
+    CHECK(((Data*)ht.lru_first())->id == 2);
+
+    Data* d = (Data*)ht.lru_first();
+    d = (Data*)ht.lru_next();
+    CHECK(d->id == 3);
+    CHECK(((Data*)ht.lru_current())->id == 3);
+}
+
+TEST_CASE("ohash release and reuse", "[ohash]")
+{
+    const unsigned max = 64;
+    OHash ht(max, sizeof(FlowKey));
+    std::vector<Data> data(max);
+    provision(ht, data);
+
+    FlowKey key;
+
+    // churn through many more keys than nodes to exercise tombstones
+    for ( unsigned i = 0; i < 100 * max; ++i )
+    {
+        make_key(key, i);
+        REQUIRE(ht.get(&key));
+
+        if ( i >= max / 2 )
+        {
+            make_key(key, i - max / 2);
+            CHECK(ht.release_node(&key) == HASH_OK);
+            CHECK(ht.release_node(&key) == HASH_NOT_FOUND);
+        }
+    }
+    CHECK(ht.get_num_nodes() == max / 2);
+    CHECK(ht.get_num_slots() == 2 * max);
+
+    for ( unsigned i = 100 * max - max / 2; i < 100 * max; ++i )
+    {
+        make_key(key, i);
+        CHECK(ht.get_user_data(&key));
+    }
+}
+
+TEST_CASE("ohash remove and pop", "[ohash]")
+{
+    const unsigned max = 8;
+    OHash ht(max, sizeof(FlowKey));
+    std::vector<Data> data(max);
+    provision(ht, data);
+
+    FlowKey key;
+
+    for ( unsigned i = 0; i < max / 2; ++i )
+    {
+        make_key(key, i);
+        ht.get(&key);
+    }
+
+    unsigned removed = 0;
+    while ( ht.lru_first() )
+    {
+        CHECK(ht.remove());
+        ++removed;
+    }
+    CHECK(removed == max / 2);
+    CHECK(ht.get_num_nodes() == 0);
+
+    unsigned popped = 0;
+    while ( ht.pop() )
+        ++popped;
+    CHECK(popped == max / 2);
+}
+
+TEST_CASE("ohash grows when overprovisioned", "[ohash]")
+{
+    const unsigned max = 16;
+    OHash ht(max, sizeof(FlowKey));
+    std::vector<Data> data(8 * max);
+    provision(ht, data);
+
+    FlowKey key;
+
+    for ( unsigned i = 0; i < data.size(); ++i )
+    {
+        make_key(key, i);
+        REQUIRE(ht.get(&key));
+    }
+    CHECK(ht.get_num_slots() > 2 * max);
+
+    for ( unsigned i = 0; i < data.size(); ++i )
+    {
+        make_key(key, i);
+        CHECK(ht.get_user_data(&key));
+    }
+}
+
+//-------------------------------------------------------------------------
+// benchmarks
+//-------------------------------------------------------------------------
+
+#ifdef BENCHMARK_TEST
+
+static const unsigned bench_flows = 1 << 20;
+
+template <typename T>
+static void fill(T& ht, std::vector<Data>& data, std::vector<FlowKey>& keys)
+{
+    provision(ht, data);
+
+    for ( unsigned i = 0; i < keys.size(); ++i )
+        ht.get(&keys[i]);
+}
+
+static std::vector<FlowKey> make_keys(unsigned n)
+{
+    std::vector<FlowKey> keys(n);
+
+    for ( unsigned i = 0; i < n; ++i )
+        make_key(keys[i], i * 2654435761u);
+
+    return keys;
+}
+
+TEST_CASE("flow table lookup", "[ohash]")
+{
+    std::vector<FlowKey> keys = make_keys(bench_flows);
+    std::vector<Data> zdata(bench_flows), odata(bench_flows);
+
+    ZHash zh(bench_flows, sizeof(FlowKey));
+    OHash oh(bench_flows, sizeof(FlowKey));
+
+    fill(zh, zdata, keys);
+    fill(oh, odata, keys);
+
+    unsigned zi = 0, oi = 0;
+
+    BENCHMARK("zhash hit")
+    {
+        zi = (zi + 7919) & (bench_flows - 1);
+        return zh.get_user_data(&keys[zi]);
+    };
+
+    BENCHMARK("ohash hit")
+    {
+        oi = (oi + 7919) & (bench_flows - 1);
+        return oh.get_user_data(&keys[oi]);
+    };
+
+    const unsigned batch = 64;
+
+    BENCHMARK("ohash hit with batch prefetch")
+    {
+        void* p = nullptr;
+        unsigned start = oi;
+
+        for ( unsigned n = 0; n < batch; ++n )
+            oh.prefetch(&keys[(start + n * 7919) & (bench_flows - 1)]);
+
+        for ( unsigned n = 0; n < batch; ++n )
+            p = oh.get_user_data(&keys[(start + n * 7919) & (bench_flows - 1)]);
+
+        oi = (start + batch * 7919) & (bench_flows - 1);
+        return p;
+    };
+
+    FlowKey miss;
+    make_key(miss, bench_flows + 1);
+    miss.port_h = 443;
+
+    BENCHMARK("zhash miss")
+    {
+        miss.ip_l[0]++;
+        return zh.get_user_data(&miss);
+    };
+
+    BENCHMARK("ohash miss")
+    {
+        miss.ip_l[0]++;
+        return oh.get_user_data(&miss);
+    };
+}
+
+TEST_CASE("flow table insert and prune", "[ohash]")
+{
+    std::vector<FlowKey> keys = make_keys(bench_flows);
+    std::vector<Data> zdata(bench_flows / 2), odata(bench_flows / 2);
+
+    ZHash zh(bench_flows / 2, sizeof(FlowKey));
+    OHash oh(bench_flows / 2, sizeof(FlowKey));
+
+    provision(zh, zdata);
+    provision(oh, odata);
+
+    unsigned zi = 0, oi = 0;
+
+    // steady state churn: insert a new flow and release the lru one
+    BENCHMARK("zhash insert + prune lru")
+    {
+        if ( !zh.get(&keys[zi]) )
+        {
+            zh.release_node(((Data*)zh.lru_first())->key);
+            zh.get(&keys[zi]);
+        }
+        zi = (zi + 1) & (bench_flows - 1);
+    };
+
+    BENCHMARK("ohash insert + prune lru")
+    {
+        if ( !oh.get(&keys[oi]) )
+        {
+            oh.release_node(((Data*)oh.lru_first())->key);
+            oh.get(&keys[oi]);
+        }
+        oi = (oi + 1) & (bench_flows - 1);
+    };
+}
+
+#endif
+
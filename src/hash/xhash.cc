@@ -412,6 +412,13 @@ HashNode* XHash::find_node_row(const void* key, int& rindex)
     return nullptr;
 }
 
+// only the row head; following it to the first node would wait on the miss
+void XHash::prefetch_row(const void* key)
+{
+    unsigned hashkey = hashkey_ops->do_hash((const unsigned char*)key, keysize);
+    __builtin_prefetch(table + (hashkey & (nrows - 1)));
+}
+
 void XHash::save_free_node(HashNode* hnode)
 {
     if ( fhead )
@@ -95,6 +95,7 @@ protected:
     void initialize_node (HashNode*, const void* key, void* data, int index);
     HashNode* allocate_node(const void* key, void* data, int index);
     HashNode* find_node_row(const void* key, int& rindex);
+    void prefetch_row(const void* key);
     void link_node(HashNode*);
     void unlink_node(HashNode*);
     bool delete_a_node();
@@ -121,6 +121,11 @@ void* ZHash::lru_current()
     return node ? node->data : nullptr;
 }
 
+size_t ZHash::get_node_size() const
+{
+    return sizeof(HashNode) + keysize;
+}
+
 void ZHash::lru_touch()
 {
     HashNode* node = lru_cache->get_current_node();
@@ -22,9 +22,10 @@
 
 #include <cstddef>
 
+#include "hash/flow_table.h"
 #include "hash/xhash.h"
 
-class ZHash : public snort::XHash
+class ZHash final : public snort::XHash, public FlowTable
 {
 public:
     ZHash(int nrows, int keysize);
@@ -32,16 +33,30 @@ public:
     ZHash(const ZHash&) = delete;
     ZHash& operator=(const ZHash&) = delete;
 
-    void* push(void* p);
-    void* pop();
+    void* push(void* p) override;
+    void* pop() override;
 
-    void* get(const void* key);
-    void* remove();
+    void* get(const void* key) override;
+    void* remove() override;
 
-    void* lru_first();
-    void* lru_next();
-    void* lru_current();
-    void lru_touch();
+    void* get_user_data(const void* key) override
+    { return XHash::get_user_data(key); }
+
+    int release_node(const void* key) override
+    { return XHash::release_node(key); }
+
+    void* lru_first() override;
+    void* lru_next() override;
+    void* lru_current() override;
+    void lru_touch() override;
+
+    void prefetch(const void* key) override
+    { prefetch_row(key); }
+
+    unsigned get_num_nodes() override
+    { return num_nodes; }
+
+    size_t get_node_size() const override;
 };
 
 #endif
@@ -21,7 +21,7 @@
 #define BOYER_MOORE_SEARCH_H
 
 // Boyer-Moore literal content matching routines (single pattern)
-// use LiteralSearch::instantiate to get hyperscan if available
+// LiteralSearch::instantiate uses SimdSearch or hyperscan instead
 
 #include "helpers/literal_search.h"
 #include "main/snort_types.h"
@@ -26,8 +26,8 @@
 #include <cstring>
 
 #include "main/snort_config.h"
-#include "boyer_moore_search.h"
 #include "hyper_search.h"
+#include "simd_search.h"
 
 namespace snort
 {
@@ -65,10 +65,7 @@ LiteralSearch* LiteralSearch::instantiate(
     UNUSED(h);
     UNUSED(hs);
 #endif
-    if ( no_case )
-        return new snort::BoyerMooreSearchNoCase(pattern, pattern_len);
-
-    return new snort::BoyerMooreSearchCase(pattern, pattern_len);
+    return new snort::SimdSearch(pattern, pattern_len, no_case);
 }
 
 }
@@ -0,0 +1,278 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mpse_cache.cc - persistent cache of compiled search engine databases
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "mpse_cache.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#include "detection/fp_config.h"
+#include "log/messages.h"
+#include "main/snort_config.h"
+#include "utils/stats.h"
+#include "utils/util.h"
+
+using namespace snort;
+
+static const char s_magic[8] = { 'S', 'N', 'O', 'R', 'T', 'M', 'P', 'C' };
+static const uint32_t s_file_version = 1;
+
+struct MpseCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint8_t key[SHA256_HASH_SIZE];
+    uint64_t size;
+};
+
+MpseCacheStats MpseCache::stats;
+
+// compiled state by engine and key; entries expire with their last instance
+static std::unordered_map<std::string, std::weak_ptr<const void>> s_shared;
+static std::mutex s_shared_mutex;
+
+//-------------------------------------------------------------------------
+// cache
+//-------------------------------------------------------------------------
+
+MpseCache::MpseCache(const SnortConfig* sc, const char* name, unsigned format_version)
+{
+    if ( sc and sc->fast_pattern_config )
+        dir = sc->fast_pattern_config->get_cache_dir();
+
+    engine = name;
+
+    update(std::string(VERSION));
+    update(engine);
+    update(format_version);
+}
+
+void MpseCache::update(const void* p, size_t n)
+{
+    assert(!keyed);
+    data.append((const char*)p, n);
+}
+
+void MpseCache::finish_key()
+{
+    if ( keyed )
+        return;
+
+    sha256((const unsigned char*)data.c_str(), data.size(), key);
+    std::string().swap(data);
+    keyed = true;
+}
+
+std::string MpseCache::get_path() const
+{
+    std::string path = dir + "/" + engine + "-";
+    char hex[3];
+
+    for ( auto b : key )
+    {
+        snprintf(hex, sizeof(hex), "%02x", b);
+        path += hex;
+    }
+    return path + ".mpse";
+}
+
+std::string MpseCache::get_id()
+{
+    finish_key();
+    return engine + std::string((const char*)key, sizeof(key));
+}
+
+std::shared_ptr<const void> MpseCache::find_shared_state()
+{
+    std::string id = get_id();
+    std::lock_guard<std::mutex> lock(s_shared_mutex);
+    auto it = s_shared.find(id);
+
+    if ( it == s_shared.end() )
+        return nullptr;
+
+    std::shared_ptr<const void> sp = it->second.lock();
+
+    if ( sp )
+        ++stats.shared;
+    else
+        s_shared.erase(it);
+
+    return sp;
+}
+
+void MpseCache::share(const std::shared_ptr<const void>& sp)
+{
+    std::string id = get_id();
+    std::lock_guard<std::mutex> lock(s_shared_mutex);
+    auto& wp = s_shared[id];
+
+    // a parallel compile of the same patterns may have published first
+    if ( wp.expired() )
+        wp = sp;
+}
+
+bool MpseCache::load(std::vector<uint8_t>& buf)
+{
+    if ( !enabled() )
+        return false;
+
+    finish_key();
+
+    std::ifstream file(get_path(), std::ios::binary | std::ios::ate);
+    std::streamoff len = file ? (std::streamoff)file.tellg() : 0;
+    MpseCacheHeader hdr;
+
+    // check the size against the file before trusting it for an allocation
+    if ( len < (std::streamoff)sizeof(hdr) or !file.seekg(0) or
+        !file.read((char*)&hdr, sizeof(hdr)) or memcmp(hdr.magic, s_magic, sizeof(s_magic)) or
+        hdr.version != s_file_version or memcmp(hdr.key, key, sizeof(key)) or
+        hdr.size != (uint64_t)(len - sizeof(hdr)) )
+    {
+        ++stats.misses;
+        return false;
+    }
+
+    buf.resize(hdr.size);
+
+    if ( !file.read((char*)buf.data(), hdr.size) or file.peek() != EOF )
+    {
+        buf.clear();
+        ++stats.misses;
+        return false;
+    }
+
+    ++stats.hits;
+    return true;
+}
+
+void MpseCache::reject()
+{
+    --stats.hits;
+    ++stats.misses;
+}
+
+bool MpseCache::store(const void* p, size_t n)
+{
+    if ( !enabled() )
+        return false;
+
+    finish_key();
+
+    MpseCacheHeader hdr = { };
+    memcpy(hdr.magic, s_magic, sizeof(s_magic));
+    hdr.version = s_file_version;
+    memcpy(hdr.key, key, sizeof(key));
+    hdr.size = n;
+
+    std::string path = get_path();
+    std::stringstream tmp;
+    tmp << path << ".tmp." << getpid() << "." << std::this_thread::get_id();
+
+    std::ofstream file(tmp.str(), std::ios::binary | std::ios::trunc);
+    file.write((const char*)&hdr, sizeof(hdr));
+    file.write((const char*)p, n);
+    file.close();
+
+    if ( !file or rename(tmp.str().c_str(), path.c_str()) )
+    {
+        if ( !stats.errors++ )
+            WarningMessage("can't write search engine cache %s: %s\n",
+                path.c_str(), get_error(errno));
+
+        unlink(tmp.str().c_str());
+        return false;
+    }
+
+    ++stats.stores;
+    return true;
+}
+
+void MpseCache::reset_stats()
+{
+    stats.hits = 0;
+    stats.misses = 0;
+    stats.stores = 0;
+    stats.errors = 0;
+    stats.shared = 0;
+
+    std::lock_guard<std::mutex> lock(s_shared_mutex);
+
+    for ( auto it = s_shared.begin(); it != s_shared.end(); )
+    {
+        if ( it->second.expired() )
+            it = s_shared.erase(it);
+        else
+            ++it;
+    }
+}
+
+void MpseCache::print_stats()
+{
+    LogCount("shared engines", stats.shared);
+
+    if ( !stats.hits and !stats.misses )
+        return;
+
+    LogCount("cache hits", stats.hits);
+    LogCount("cache misses", stats.misses);
+    LogCount("cache stores", stats.stores);
+    LogCount("cache errors", stats.errors);
+}
+
+//-------------------------------------------------------------------------
+// payload access
+//-------------------------------------------------------------------------
+
+bool MpseCacheReader::read(void* p, size_t n)
+{
+    if ( !n )
+        return true;
+
+    if ( n > buf.size() - pos )
+        return false;
+
+    memcpy(p, buf.data() + pos, n);
+    pos += n;
+    return true;
+}
+
+void MpseCacheWriter::write(const void* p, size_t n)
+{
+    if ( !n )
+        return;
+
+    const uint8_t* b = (const uint8_t*)p;
+    buf.insert(buf.end(), b, b + n);
+}
@@ -0,0 +1,175 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// mpse_cache.h - persistent cache of compiled search engine databases
+
+#ifndef MPSE_CACHE_H
+#define MPSE_CACHE_H
+
+// search engines that can dump their compiled state use this to skip the
+// compile on startup and reload when the same pattern set was compiled
+// before.  the key is a hash of everything that went into the compile;
+// engines add their name, format version, options, and each pattern in
+// order with update().  user data is not cached - engines rebind it by
+// pattern order and build the detection trees as usual.
+//
+// files are written to a temporary name and renamed into place so parallel
+// compiles and concurrent snort instances may share a directory.  anything
+// that doesn't validate on load is treated as a miss and overwritten.
+//
+// the same key is used to share compiled state in memory.  engines that
+// keep their compiled state apart from user data publish it with share()
+// and look for it with find_shared() before compiling.  on reload, the
+// old config still holds its engines so only the pattern sets that changed
+// are compiled and the unchanged ones use the same memory.  this does not
+// depend on the cache directory.
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hash/hashes.h"
+#include "main/snort_types.h"
+
+namespace snort
+{
+struct SnortConfig;
+
+struct MpseCacheStats
+{
+    std::atomic<unsigned> hits;
+    std::atomic<unsigned> misses;
+    std::atomic<unsigned> stores;
+    std::atomic<unsigned> errors;
+    std::atomic<unsigned> shared;
+};
+
+class SO_PUBLIC MpseCache
+{
+public:
+    MpseCache(const SnortConfig*, const char* engine, unsigned format_version);
+
+    bool enabled() const
+    { return !dir.empty(); }
+
+    void update(const void*, size_t);
+
+    void update(const std::string& s)
+    { update(s.c_str(), s.size() + 1); }
+
+    template<typename T>
+    void update(const T& v)
+    { update(&v, sizeof(v)); }
+
+    // true if a valid entry was found
+    bool load(std::vector<uint8_t>&);
+
+    // the loaded entry was rejected by the engine, count it as a miss
+    void reject();
+
+    // true if the entry was written
+    bool store(const void*, size_t);
+
+    bool store(const std::vector<uint8_t>& v)
+    { return store(v.data(), v.size()); }
+
+    // compiled state of a live instance with the same key, if any
+    template<typename T>
+    std::shared_ptr<const T> find_shared()
+    { return std::static_pointer_cast<const T>(find_shared_state()); }
+
+    void share(const std::shared_ptr<const void>&);
+
+    static void reset_stats();
+    static void print_stats();
+
+    static const MpseCacheStats& get_stats()
+    { return stats; }
+
+private:
+    void finish_key();
+    std::string get_path() const;
+    std::string get_id();
+    std::shared_ptr<const void> find_shared_state();
+
+private:
+    std::string dir;
+    std::string engine;
+    std::string data;
+
+    uint8_t key[SHA256_HASH_SIZE];
+    bool keyed = false;
+
+    static MpseCacheStats stats;
+};
+
+// simple sequential access to cache payloads
+class SO_PUBLIC MpseCacheReader
+{
+public:
+    MpseCacheReader(const std::vector<uint8_t>& v) : buf(v) { }
+
+    bool read(void*, size_t);
+
+    template<typename T>
+    bool read(T& v)
+    { return read(&v, sizeof(v)); }
+
+    template<typename T>
+    bool read(std::vector<T>& v)
+    {
+        uint64_t n;
+        if ( !read(n) or n > (buf.size() - pos) / sizeof(T) )
+            return false;
+        v.resize(n);
+        return read(v.data(), n * sizeof(T));
+    }
+
+    bool done() const
+    { return pos == buf.size(); }
+
+private:
+    const std::vector<uint8_t>& buf;
+    size_t pos = 0;
+};
+
+class SO_PUBLIC MpseCacheWriter
+{
+public:
+    void write(const void*, size_t);
+
+    template<typename T>
+    void write(const T& v)
+    { write(&v, sizeof(v)); }
+
+    template<typename T>
+    void write(const std::vector<T>& v)
+    {
+        write((uint64_t)v.size());
+        write(v.data(), v.size() * sizeof(T));
+    }
+
+    const std::vector<uint8_t>& get() const
+    { return buf; }
+
+private:
+    std::vector<uint8_t> buf;
+};
+}
+#endif
@@ -0,0 +1,267 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// simd_search.cc - vectorized literal content matching (single pattern)
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "simd_search.h"
+
+#include <cassert>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SIMD_SEARCH_X86
+#endif
+
+using namespace snort;
+
+static constexpr unsigned min_vector_len = 4;
+
+//-------------------------------------------------------------------------
+// scalar
+//-------------------------------------------------------------------------
+
+// ascii only to match the vector folds
+static inline uint8_t fold(uint8_t c)
+{ return (uint8_t)(c - 'a') < 26 ? c - ('a' - 'A') : c; }
+
+template<bool no_case>
+static inline bool equal(const uint8_t* s, const uint8_t* p, unsigned n)
+{
+    if ( !no_case )
+        return !memcmp(s, p, n);
+
+    for ( unsigned i = 0; i < n; ++i )
+        if ( fold(s[i]) != p[i] )
+            return false;
+
+    return true;
+}
+
+static inline const uint8_t* find(const uint8_t* s, const uint8_t* end, uint8_t c)
+{ return (const uint8_t*)memchr(s, c, end - s); }
+
+// memchr for the first byte, or for both cases of it, then verify the rest
+template<bool no_case>
+static int search_memchr(const uint8_t* pat, unsigned n, const uint8_t* buf, unsigned len)
+{
+    if ( len < n )
+        return -1;
+
+    const uint8_t* end = buf + len - n + 1;
+    const uint8_t up = pat[0];
+    const uint8_t lo = (no_case and up >= 'A' and up <= 'Z') ? up + ('a' - 'A') : up;
+
+    const uint8_t* u = find(buf, end, up);
+    const uint8_t* l = (lo != up) ? find(buf, end, lo) : nullptr;
+
+    while ( u or l )
+    {
+        const uint8_t* c = (!l or (u and u < l)) ? u : l;
+
+        if ( equal<no_case>(c + 1, pat + 1, n - 1) )
+            return c - buf;
+
+        if ( c == u )
+            u = find(c + 1, end, up);
+        else
+            l = find(c + 1, end, lo);
+    }
+    return -1;
+}
+
+//-------------------------------------------------------------------------
+// vector
+//-------------------------------------------------------------------------
+
+#ifdef SIMD_SEARCH_X86
+// candidates are where the first and last pattern bytes both match; the
+// unaligned loads never read past the buffer and the tail is left to memchr
+
+// 'a' - 'z' => 'A' - 'Z'; bytes >= 0x80 are negative and never in range
+static inline __m128i fold_sse2(__m128i v)
+{
+    const __m128i lo = _mm_set1_epi8('a' - 1);
+    const __m128i hi = _mm_set1_epi8('z' + 1);
+    const __m128i diff = _mm_set1_epi8('a' - 'A');
+
+    __m128i m = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+    return _mm_sub_epi8(v, _mm_and_si128(m, diff));
+}
+
+template<bool no_case>
+static int search_sse2(const uint8_t* pat, unsigned n, const uint8_t* buf, unsigned len)
+{
+    const __m128i first = _mm_set1_epi8(pat[0]);
+    const __m128i last = _mm_set1_epi8(pat[n - 1]);
+    unsigned i = 0;
+
+    for ( ; i + n + 15 <= len; i += 16 )
+    {
+        __m128i f = _mm_loadu_si128((const __m128i*)(buf + i));
+        __m128i l = _mm_loadu_si128((const __m128i*)(buf + i + n - 1));
+
+        if ( no_case )
+        {
+            f = fold_sse2(f);
+            l = fold_sse2(l);
+        }
+        unsigned mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(f, first), _mm_cmpeq_epi8(l, last)));
+
+        while ( mask )
+        {
+            unsigned bit = __builtin_ctz(mask);
+
+            if ( equal<no_case>(buf + i + bit + 1, pat + 1, n - 2) )
+                return i + bit;
+
+            mask &= mask - 1;
+        }
+    }
+    int pos = search_memchr<no_case>(pat, n, buf + i, len - i);
+    return pos < 0 ? pos : pos + i;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i fold_avx2(__m256i v)
+{
+    const __m256i lo = _mm256_set1_epi8('a' - 1);
+    const __m256i hi = _mm256_set1_epi8('z' + 1);
+    const __m256i diff = _mm256_set1_epi8('a' - 'A');
+
+    __m256i m = _mm256_and_si256(_mm256_cmpgt_epi8(v, lo), _mm256_cmpgt_epi8(hi, v));
+    return _mm256_sub_epi8(v, _mm256_and_si256(m, diff));
+}
+
+template<bool no_case>
+__attribute__((target("avx2")))
+static int search_avx2(const uint8_t* pat, unsigned n, const uint8_t* buf, unsigned len)
+{
+    const __m256i first = _mm256_set1_epi8(pat[0]);
+    const __m256i last = _mm256_set1_epi8(pat[n - 1]);
+    unsigned i = 0;
+
+    for ( ; i + n + 31 <= len; i += 32 )
+    {
+        __m256i f = _mm256_loadu_si256((const __m256i*)(buf + i));
+        __m256i l = _mm256_loadu_si256((const __m256i*)(buf + i + n - 1));
+
+        if ( no_case )
+        {
+            f = fold_avx2(f);
+            l = fold_avx2(l);
+        }
+        unsigned mask = _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(f, first), _mm256_cmpeq_epi8(l, last)));
+
+        while ( mask )
+        {
+            unsigned bit = __builtin_ctz(mask);
+
+            if ( equal<no_case>(buf + i + bit + 1, pat + 1, n - 2) )
+                return i + bit;
+
+            mask &= mask - 1;
+        }
+    }
+    // finish with 16 byte blocks before falling back to memchr
+    int pos = search_sse2<no_case>(pat, n, buf + i, len - i);
+    return pos < 0 ? pos : pos + i;
+}
+#endif
+
+//-------------------------------------------------------------------------
+// selection
+//-------------------------------------------------------------------------
+
+static bool supported(SimdSearch::Kernel k)
+{
+    switch ( k )
+    {
+    case SimdSearch::Kernel::SCALAR:
+        return true;
+
+#ifdef SIMD_SEARCH_X86
+    case SimdSearch::Kernel::SSE2:
+        return __builtin_cpu_supports("sse2");
+
+    case SimdSearch::Kernel::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+
+    default:
+        break;
+    }
+    return false;
+}
+
+static SimdSearch::Kernel best_kernel()
+{
+    if ( supported(SimdSearch::Kernel::AVX2) )
+        return SimdSearch::Kernel::AVX2;
+
+    if ( supported(SimdSearch::Kernel::SSE2) )
+        return SimdSearch::Kernel::SSE2;
+
+    return SimdSearch::Kernel::SCALAR;
+}
+
+static SimdSearch::Kernel s_kernel = best_kernel();
+
+bool SimdSearch::set_kernel(Kernel k)
+{
+    if ( !supported(k) )
+        return false;
+
+    s_kernel = k;
+    return true;
+}
+
+SimdSearch::Kernel SimdSearch::get_kernel()
+{ return s_kernel; }
+
+SimdSearch::SimdSearch(const uint8_t* pat, unsigned pat_len, bool no_case)
+    : pattern(pat), pattern_len(pat_len)
+{
+    assert(pattern_len > 0);
+
+    Kernel k = pattern_len < min_vector_len ? Kernel::SCALAR : s_kernel;
+
+    switch ( k )
+    {
+#ifdef SIMD_SEARCH_X86
+    case Kernel::AVX2:
+        func = no_case ? search_avx2<true> : search_avx2<false>;
+        break;
+
+    case Kernel::SSE2:
+        func = no_case ? search_sse2<true> : search_sse2<false>;
+        break;
+#endif
+
+    default:
+        func = no_case ? search_memchr<true> : search_memchr<false>;
+        break;
+    }
+}
+
@@ -0,0 +1,69 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// simd_search.h - vectorized literal content matching (single pattern)
+
+#ifndef SIMD_SEARCH_H
+#define SIMD_SEARCH_H
+
+// SimdSearch compares the first and last bytes of the pattern against 16
+// or 32 candidate positions at a time and only verifies the middle of the
+// pattern where both ends match.  nocase buffers are folded to upper case
+// in register so, as with BoyerMooreSearchNoCase, nocase patterns must be
+// upper case.  patterns shorter than 4 bytes are anchored with memchr
+// instead since the vector filter gains little over it.
+//
+// the kernel is selected by cpu feature at startup and is bound to each
+// instance when it is constructed.
+// use LiteralSearch::instantiate to get hyperscan if configured.
+
+#include "helpers/literal_search.h"
+#include "main/snort_types.h"
+
+namespace snort
+{
+
+class SO_PUBLIC SimdSearch : public LiteralSearch
+{
+public:
+    enum class Kernel { SCALAR, SSE2, AVX2 };
+
+    SimdSearch(const uint8_t* pattern, unsigned pattern_len, bool no_case = false);
+
+    int search(const uint8_t* buffer, unsigned buffer_len) const
+    { return func(pattern, pattern_len, buffer, buffer_len); }
+
+    int search(void*, const uint8_t* buffer, unsigned buffer_len) const override
+    { return search(buffer, buffer_len); }
+
+    // applies to instances constructed after the call
+    // returns false if the kernel is not supported on this cpu
+    static bool set_kernel(Kernel);
+    static Kernel get_kernel();
+
+private:
+    using SearchFunc = int (*)(const uint8_t*, unsigned, const uint8_t*, unsigned);
+
+    const uint8_t* pattern;
+    unsigned pattern_len;
+    SearchFunc func;
+};
+
+}
+#endif
+
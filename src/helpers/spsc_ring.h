@@ -0,0 +1,129 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// spsc_ring.h - lock-free single producer single consumer ring
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+// Lock-free ring with exactly one producer thread and one consumer thread.
+// unlike Ring, the indices are atomics with acquire / release ordering so
+// it is safe to use between threads without any other synchronization.
+
+#include <atomic>
+#include <cassert>
+
+template <typename T>
+class SpscRing
+{
+public:
+    // size is rounded up to a power of 2
+    SpscRing<T>(unsigned size);
+    ~SpscRing<T>();
+
+    SpscRing<T>(const SpscRing<T>&) = delete;
+    SpscRing<T>& operator=(const SpscRing<T>&) = delete;
+
+    // producer only
+    bool put(const T&);
+
+    // consumer only
+    bool get(T&);
+
+    // approximate unless called from the producer or consumer
+    unsigned count() const;
+    bool empty() const;
+
+private:
+    // keep the indices on separate cache lines so the producer and
+    // consumer don't contend.  padding instead of alignas avoids
+    // requiring over aligned new.
+    static constexpr unsigned line = 64;
+
+    struct Index
+    {
+        std::atomic<unsigned> ix { 0 };
+        char pad[line - sizeof(std::atomic<unsigned>)];
+    };
+
+    Index head;  // written by consumer
+    Index tail;  // written by producer
+
+    unsigned mask;
+    T* store;
+};
+
+template <typename T>
+SpscRing<T>::SpscRing(unsigned size)
+{
+    assert(size > 0);
+    unsigned sz = 1;
+
+    while ( sz < size )
+        sz <<= 1;
+
+    mask = sz - 1;
+    store = new T[sz];
+}
+
+template <typename T>
+SpscRing<T>::~SpscRing()
+{
+    delete[] store;
+}
+
+template <typename T>
+bool SpscRing<T>::put(const T& v)
+{
+    unsigned t = tail.ix.load(std::memory_order_relaxed);
+
+    if ( t - head.ix.load(std::memory_order_acquire) > mask )
+        return false;
+
+    store[t & mask] = v;
+    tail.ix.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+bool SpscRing<T>::get(T& v)
+{
+    unsigned h = head.ix.load(std::memory_order_relaxed);
+
+    if ( h == tail.ix.load(std::memory_order_acquire) )
+        return false;
+
+    v = store[h & mask];
+    head.ix.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+unsigned SpscRing<T>::count() const
+{
+    return tail.ix.load(std::memory_order_acquire) - head.ix.load(std::memory_order_acquire);
+}
+
+template <typename T>
+bool SpscRing<T>::empty() const
+{
+    return count() == 0;
+}
+
+#endif
+
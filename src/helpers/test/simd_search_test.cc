@@ -0,0 +1,308 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// simd_search_test.cc - vectorized literal search checks and benchmarks
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/catch.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "helpers/boyer_moore_search.h"
+#include "helpers/simd_search.h"
+
+#ifdef HAVE_HYPERSCAN
+#include "helpers/hyper_search.h"
+#include "helpers/scratch_allocator.h"
+#include "main/snort_config.h"
+#endif
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// stubs
+//-------------------------------------------------------------------------
+
+#ifdef HAVE_HYPERSCAN
+namespace snort
+{
+static std::vector<void*> s_state;
+static ScratchAllocator* scratcher = nullptr;
+
+SnortConfig::SnortConfig(const SnortConfig* const)
+{
+    state = &s_state;
+    num_slots = 1;
+}
+
+SnortConfig::~SnortConfig() = default;
+
+int SnortConfig::request_scratch(ScratchAllocator* s)
+{
+    scratcher = s;
+    s_state.resize(1);
+    return 0;
+}
+
+void SnortConfig::release_scratch(int)
+{
+    scratcher = nullptr;
+    s_state.clear();
+}
+
+static SnortConfig s_conf;
+THREAD_LOCAL SnortConfig* snort_conf = &s_conf;
+
+const SnortConfig* SnortConfig::get_conf()
+{ return snort_conf; }
+
+void ParseError(const char*, ...) { }
+
+unsigned get_instance_id()
+{ return 0; }
+}
+#endif
+
+//-------------------------------------------------------------------------
+// checks
+//-------------------------------------------------------------------------
+
+static const SimdSearch::Kernel kernels[] =
+{
+    SimdSearch::Kernel::SCALAR, SimdSearch::Kernel::SSE2, SimdSearch::Kernel::AVX2
+};
+
+static int simd_find(const char* pat, const char* buf, bool no_case)
+{
+    SimdSearch ss((const uint8_t*)pat, strlen(pat), no_case);
+    return ss.search((const uint8_t*)buf, strlen(buf));
+}
+
+TEST_CASE("simd search case", "[simd_search]")
+{
+    SimdSearch::Kernel save = SimdSearch::get_kernel();
+
+    for ( auto k : kernels )
+    {
+        if ( !SimdSearch::set_kernel(k) )
+            continue;
+
+        CHECK(simd_find("a", "bbbba", false) == 4);
+        CHECK(simd_find("ab", "aaab", false) == 2);
+        CHECK(simd_find("abc", "ABCabc", false) == 3);
+        CHECK(simd_find("abcd", "abcd", false) == 0);
+        CHECK(simd_find("abcd", "abc", false) == -1);
+        CHECK(simd_find("abcd", "ABCD", false) == -1);
+        CHECK(simd_find("needle", "a haystack with a needle in it", false) == 18);
+        CHECK(simd_find("needle", "a haystack with a needl in it", false) == -1);
+        CHECK(simd_find("xyzzy",
+            "0123456789abcdef0123456789abcdef0123456789abcdefxyzzy", false) == 48);
+        CHECK(simd_find("abcdefghijklmnopqrstuvwxyz0123456789",
+            "abcdefghijklmnopqrstuvwxyz012345678abcdefghijklmnopqrstuvwxyz0123456789",
+            false) == 35);
+    }
+    SimdSearch::set_kernel(save);
+}
+
+TEST_CASE("simd search nocase", "[simd_search]")
+{
+    SimdSearch::Kernel save = SimdSearch::get_kernel();
+
+    for ( auto k : kernels )
+    {
+        if ( !SimdSearch::set_kernel(k) )
+            continue;
+
+        CHECK(simd_find("A", "bbbba", true) == 4);
+        CHECK(simd_find("AB", "xxaB", true) == 2);
+        CHECK(simd_find("1B", "xx1b", true) == 2);
+        CHECK(simd_find("ABCD", "xAbCd", true) == 1);
+        CHECK(simd_find("ABCD", "xAbCe", true) == -1);
+        CHECK(simd_find("@[`{", "@[`{", true) == 0);
+        CHECK(simd_find("@[`{", "`{@[", true) == -1);
+        CHECK(simd_find("NEEDLE", "a haystack with a NeEdLe in it", true) == 18);
+        CHECK(simd_find("XYZZY",
+            "0123456789abcdef0123456789ABCDEF0123456789abcdefxYzZy", true) == 48);
+    }
+    SimdSearch::set_kernel(save);
+}
+
+TEST_CASE("simd search high bytes", "[simd_search]")
+{
+    SimdSearch::Kernel save = SimdSearch::get_kernel();
+    uint8_t buf[100];
+    const uint8_t pat[] = { 0xe1, 0x80, 0xc1, 0xff };
+
+    for ( unsigned i = 0; i < sizeof(buf); ++i )
+        buf[i] = 0x80 + (i % 64);
+
+    memcpy(buf + 90, pat, sizeof(pat));
+
+    for ( auto k : kernels )
+    {
+        if ( !SimdSearch::set_kernel(k) )
+            continue;
+
+        SimdSearch cs(pat, sizeof(pat), false);
+        CHECK(cs.search(buf, sizeof(buf)) == 90);
+
+        SimdSearch ns(pat, sizeof(pat), true);
+        CHECK(ns.search(buf, sizeof(buf)) == 90);
+        CHECK(ns.search(buf, 93) == -1);
+    }
+    SimdSearch::set_kernel(save);
+}
+
+// small alphabet so partial matches are common
+static std::string random_text(std::mt19937& gen, unsigned len, bool mixed)
+{
+    const char* abc = mixed ? "aAbB" : "ab";
+    std::uniform_int_distribution<unsigned> pick(0, strlen(abc) - 1);
+    std::string s;
+
+    for ( unsigned i = 0; i < len; ++i )
+        s += abc[pick(gen)];
+
+    return s;
+}
+
+TEST_CASE("simd search matches boyer moore", "[simd_search]")
+{
+    SimdSearch::Kernel save = SimdSearch::get_kernel();
+    std::mt19937 gen(1234);
+
+    for ( auto k : kernels )
+    {
+        if ( !SimdSearch::set_kernel(k) )
+            continue;
+
+        for ( unsigned n = 1; n <= 40; ++n )
+        {
+            for ( unsigned r = 0; r < 20; ++r )
+            {
+                std::string buf = random_text(gen, 200, true);
+                std::string pat = random_text(gen, n, false);
+                const uint8_t* b = (const uint8_t*)buf.c_str();
+
+                BoyerMooreSearchCase bmc((const uint8_t*)pat.c_str(), n);
+                SimdSearch ssc((const uint8_t*)pat.c_str(), n, false);
+                CHECK(ssc.search(b, buf.size()) == bmc.search(b, buf.size()));
+
+                std::transform(pat.begin(), pat.end(), pat.begin(), ::toupper);
+                BoyerMooreSearchNoCase bmn((const uint8_t*)pat.c_str(), n);
+                SimdSearch ssn((const uint8_t*)pat.c_str(), n, true);
+                CHECK(ssn.search(b, buf.size()) == bmn.search(b, buf.size()));
+            }
+        }
+    }
+    SimdSearch::set_kernel(save);
+}
+
+//-------------------------------------------------------------------------
+// benchmarks
+//-------------------------------------------------------------------------
+
+#ifdef BENCHMARK_TEST
+
+// the pattern is at the end of a 1500 byte payload of lowercase text that
+// contains a near miss every 100 bytes
+static void bench(unsigned n)
+{
+    std::string pat;
+
+    for ( unsigned i = 0; i < n; ++i )
+        pat += 'a' + (i * 7) % 26;
+
+    std::string near = pat;
+    near.back() = '#';
+
+    std::string buf;
+
+    while ( buf.size() < 1500 - n )
+    {
+        buf += (buf.size() % 100) ? 'x' + buf.size() % 3 : 'q';
+
+        if ( buf.size() % 100 == 50 )
+            buf += near;
+    }
+    buf.resize(1500 - n);
+    buf += pat;
+
+    std::string upat = pat;
+    std::transform(upat.begin(), upat.end(), upat.begin(), ::toupper);
+
+    const uint8_t* p = (const uint8_t*)pat.c_str();
+    const uint8_t* u = (const uint8_t*)upat.c_str();
+    const uint8_t* b = (const uint8_t*)buf.c_str();
+    unsigned len = buf.size();
+
+    BoyerMooreSearchCase bmc(p, n);
+    BoyerMooreSearchNoCase bmn(u, n);
+    SimdSearch ssc(p, n, false);
+    SimdSearch ssn(u, n, true);
+
+    REQUIRE(bmc.search(b, len) == (int)(len - n));
+    REQUIRE(ssc.search(b, len) == (int)(len - n));
+    REQUIRE(ssn.search(b, len) == (int)(len - n));
+
+    std::string suffix = " " + std::to_string(n);
+
+    BENCHMARK("bm case" + suffix)
+    { return bmc.search(b, len); };
+
+    BENCHMARK("bm nocase" + suffix)
+    { return bmn.search(b, len); };
+
+    BENCHMARK("simd case" + suffix)
+    { return ssc.search(b, len); };
+
+    BENCHMARK("simd nocase" + suffix)
+    { return ssn.search(b, len); };
+
+#ifdef HAVE_HYPERSCAN
+    LiteralSearch::Handle* h = HyperSearch::setup();
+    HyperSearch hsc(h, p, n, false);
+    HyperSearch hsn(h, u, n, true);
+    scratcher->setup(snort_conf);
+
+    BENCHMARK("hyper case" + suffix)
+    { return hsc.search(h, b, len); };
+
+    BENCHMARK("hyper nocase" + suffix)
+    { return hsn.search(h, b, len); };
+
+    scratcher->cleanup(snort_conf);
+    HyperSearch::cleanup(h);
+#endif
+}
+
+TEST_CASE("literal search pattern lengths", "[simd_search]")
+{
+    for ( unsigned n : { 2, 4, 8, 16, 32, 64 } )
+        bench(n);
+}
+
+#endif
+
@@ -0,0 +1,112 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// spsc_ring_test.cc - SpscRing unit tests
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <thread>
+
+#include "catch/catch.hpp"
+
+#include "../spsc_ring.h"
+
+TEST_CASE( "spsc ring", "[spsc_ring]" )
+{
+    SpscRing<int> ring(3);
+    int v = 0;
+
+    SECTION( "empty" )
+    {
+        CHECK(ring.empty());
+        CHECK(!ring.get(v));
+    }
+
+    SECTION( "fill" )
+    {
+        // rounded up to 4
+        for ( int i = 0; i < 4; ++i )
+            CHECK(ring.put(i));
+
+        CHECK(!ring.put(4));
+        CHECK(ring.count() == 4);
+
+        for ( int i = 0; i < 4; ++i )
+        {
+            CHECK(ring.get(v));
+            CHECK(v == i);
+        }
+        CHECK(ring.empty());
+    }
+
+    SECTION( "wrap" )
+    {
+        for ( int i = 0; i < 10; ++i )
+        {
+            CHECK(ring.put(i));
+            CHECK(ring.put(-i));
+
+            CHECK(ring.get(v));
+            CHECK(v == i);
+
+            CHECK(ring.get(v));
+            CHECK(v == -i);
+        }
+        CHECK(ring.empty());
+    }
+}
+
+TEST_CASE( "spsc ring threads", "[spsc_ring]" )
+{
+    const unsigned num = 100000;
+    SpscRing<unsigned> ring(64);
+
+    std::thread producer([&ring]()
+    {
+        for ( unsigned i = 1; i <= num; ++i )
+        {
+            while ( !ring.put(i) )
+                std::this_thread::yield();
+        }
+    });
+
+    unsigned expected = 1;
+    bool in_order = true;
+
+    while ( expected <= num )
+    {
+        unsigned v;
+
+        if ( !ring.get(v) )
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        if ( v != expected )
+            in_order = false;
+
+        ++expected;
+    }
+    producer.join();
+
+    CHECK(in_order);
+    CHECK(ring.empty());
+}
+
@@ -88,6 +88,13 @@ public:
         return current_size;
     }
 
+    // for memory attribution
+    size_t get_max_mem_size() const
+    { return max_mem_size; }
+
+    uint64_t get_mem_allocs() const
+    { return mem_allocs; }
+
     void print_config()
     {
         if ( snort::SnortConfig::log_verbose() )
@@ -194,7 +201,15 @@ private:
         {
             assert( current_size >= (size_t) -size);
         }
-        if ( (current_size += size) > max_size )
+
+        size_t now = (current_size += size);
+
+        if ( size > 0 )
+        {
+            ++mem_allocs;
+            raise_max_mem_size(now);
+        }
+        if ( now > max_size )
         {
             // Same idea as in LruCacheShared::remove(), use shared pointers
             // to hold the pruned data until after the cache is unlocked.
@@ -209,7 +224,8 @@ private:
     void increase_size(ValueType* value_ptr=nullptr) override
     {
         UNUSED(value_ptr);
-        current_size += mem_chunk;
+        ++mem_allocs;
+        raise_max_mem_size(current_size += mem_chunk);
     }
 
     void decrease_size(ValueType* value_ptr=nullptr) override
@@ -219,7 +235,15 @@ private:
         current_size -= mem_chunk;
     }
 
+    void raise_max_mem_size(size_t sz)
+    {
+        size_t max = max_mem_size;
+        while ( sz > max and !max_mem_size.compare_exchange_weak(max, sz) );
+    }
+
     std::atomic<size_t> valid_id;
+    std::atomic<size_t> max_mem_size { 0 };
+    std::atomic<uint64_t> mem_allocs { 0 };
 
     std::mutex reload_mutex;
     friend class TEST_host_cache_module_misc_Test; // for unit test
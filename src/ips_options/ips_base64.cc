@@ -34,6 +34,10 @@
 #include "profiler/profiler.h"
 #include "utils/util_unfold.h"
 
+#ifdef HAVE_HYPERSCAN
+#include "detection/regex_prefilter.h"
+#endif
+
 using namespace snort;
 
 static THREAD_LOCAL ProfileStats base64PerfStats;
@@ -118,6 +122,10 @@ IpsOption::EvalStatus Base64DecodeOption::eval(Cursor& c, Packet* p)
     RuleProfile profile(base64PerfStats);
     DataBuffer& base64_decode_buffer = DetectionEngine::get_alt_buffer(p);
     base64_decode_buffer.len = 0;
+#ifdef HAVE_HYPERSCAN
+    // each rule decodes into the same buffer
+    RegexPrefilter::rewritten(p->context);
+#endif
 
     Base64DecodeData* idx = (Base64DecodeData*)&config;
     const uint8_t* start_ptr = nullptr;
@@ -23,9 +23,17 @@
 #include "config.h"
 #endif
 
-#include <pcre.h>
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
 
+#ifdef HAVE_HYPERSCAN
+#include <hs_compile.h>
+#endif
+
+#include <algorithm>
 #include <cassert>
+#include <string>
+#include <vector>
 
 #include "detection/ips_context.h"
 #include "framework/cursor.h"
@@ -33,135 +41,242 @@
 #include "framework/module.h"
 #include "framework/parameter.h"
 #include "hash/hash_key_operations.h"
+#include "helpers/literal_search.h"
 #include "helpers/scratch_allocator.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
+#include "main/thread_config.h"
 #include "managers/ips_manager.h"
 #include "managers/module_manager.h"
 #include "profiler/profiler.h"
+#include "profiler/rule_profiler_defs.h"
 #include "utils/util.h"
 
-using namespace snort;
-
-#ifndef PCRE_STUDY_JIT_COMPILE
-#define PCRE_STUDY_JIT_COMPILE 0
+#ifdef HAVE_HYPERSCAN
+#include "detection/regex_prefilter.h"
 #endif
 
-//#define NO_JIT // uncomment to disable JIT for Xcode
+using namespace snort;
 
-#ifdef NO_JIT
-#define PCRE_STUDY_FLAGS 0
-#define pcre_release(x) pcre_free(x)
-#else
-#define PCRE_STUDY_FLAGS PCRE_STUDY_JIT_COMPILE
-#define pcre_release(x) pcre_free_study(x)
-#endif
+//#define NO_JIT // uncomment to disable JIT for Xcode
 
 #define SNORT_PCRE_RELATIVE         0x00010 // relative to the end of the last match
 #define SNORT_PCRE_INVERT           0x00020 // invert detect
 #define SNORT_PCRE_ANCHORED         0x00040
 #define SNORT_OVERRIDE_MATCH_LIMIT  0x00080 // Override default limits on match & match recursion
+#define SNORT_PCRE_START            0x00100 // literal must be at the start of the buffer
 
 #define s_name "pcre"
 #define mod_regex_name "regex"
 
+// per packet thread
+struct PcreProfile
+{
+    hr_duration elapsed;
+    uint64_t checks;
+    uint64_t matches;
+};
+
 struct PcreData
 {
-    pcre* re;           /* compiled regex */
-    pcre_extra* pe;     /* studied regex foo */
-    bool free_pe;
+    pcre2_code* re;                 // compiled regex
+    pcre2_match_context* mcontext;  // limits and jit stack callback
+    LiteralSearch* searcher;        // unanchored literal
+    uint8_t* literal;               // set if the regex is just a string
+    unsigned literal_len;
     int options;        /* sp_pcre specific options (relative & inverse) */
+    bool jit;
+    bool no_case;
     char* expression;
+    PcreProfile* profile;           // only allocated with rule profiling
+    char* prefilter;                // regex for the batch prefilter
+    unsigned prefilter_flags;
+};
+
+// each packet thread has its own match data and jit stack.  we only care
+// about the end of the full pattern match so the match data only has room
+// for one pair; pcre2_match() returns 0 instead of the number of captures
+// when there are more, which is still a match.
+struct PcreScratch
+{
+    pcre2_match_data* match_data;
+    pcre2_jit_stack* jit_stack;
 };
 
-// we need to specify the vector length for our pcre_exec call.  we only care
-// about the first vector, which if the match is successful will include the
-// offset to the end of the full pattern match.  if we decide to store other
-// matches, make *SURE* that this is a multiple of 3 as pcre requires it.
+#define JIT_STACK_START (32 * 1024)
+#define JIT_STACK_MAX  (512 * 1024)
 
-// this is a temporary value used during parsing and set in snort conf
-// by verify; search uses the value in snort conf
-static int s_ovector_max = -1;
+// set by parse and cleared by scratch setup so that scratch is only
+// allocated for configs with pcre options
+static bool s_scratch_needed = false;
 
 static unsigned scratch_index;
 static ScratchAllocator* scratcher = nullptr;
 
+static LiteralSearch::Handle* search_handle = nullptr;
+
+// the jit stack is shared by all patterns on a packet thread
+static THREAD_LOCAL pcre2_jit_stack* s_jit_stack = nullptr;
+
+// all pcre options for the pcre profile
+static std::vector<const PcreData*> s_patterns;
+
 static THREAD_LOCAL ProfileStats pcrePerfStats;
 
 //-------------------------------------------------------------------------
 // implementation foo
 //-------------------------------------------------------------------------
 
-static void pcre_capture(
-    const void* code, const void* extra)
+static pcre2_jit_stack* get_jit_stack(void*)
+{ return s_jit_stack; }
+
+static void pcre_check_anchored(PcreData* pcre_data)
 {
-    int tmp_ovector_size = 0;
+    uint32_t options = 0;
 
-    pcre_fullinfo((const pcre*)code, (const pcre_extra*)extra,
-        PCRE_INFO_CAPTURECOUNT, &tmp_ovector_size);
+    if ( pcre2_pattern_info(pcre_data->re, PCRE2_INFO_ALLOPTIONS, &options) )
+    {
+        ParseError("pcre2_pattern_info: unable to get pattern options.");
+        return;
+    }
 
-    if (tmp_ovector_size > s_ovector_max)
-        s_ovector_max = tmp_ovector_size;
+    if ((options & PCRE2_ANCHORED) && !(options & PCRE2_MULTILINE))
+    {
+        /* This means that this pcre rule option shouldn't be EvalStatus
+         * even if any of it's relative children should fail to match.
+         * It is anchored to the cursor set by the previous cursor setting
+         * rule option */
+        pcre_data->options |= SNORT_PCRE_ANCHORED;
+    }
 }
 
-static void pcre_check_anchored(PcreData* pcre_data)
+// a regex without metacharacters other than a leading ^ is just a string
+// that can be matched with a literal search.  only simple escapes are
+// supported; anything else is left to pcre.
+static bool pcre_literal(const char* re, uint32_t flags, std::string& lit, bool& start)
 {
-    int rc;
-    unsigned long int options = 0;
+    if ( flags & PCRE2_EXTENDED )
+        return false;
 
-    if ((pcre_data == nullptr) || (pcre_data->re == nullptr) || (pcre_data->pe == nullptr))
-        return;
+    start = (*re == '^');
 
-    rc = pcre_fullinfo(pcre_data->re, pcre_data->pe, PCRE_INFO_OPTIONS, (void*)&options);
-    switch (rc)
+    if ( start )
     {
-    /* pcre_fullinfo fails for the following:
-     * PCRE_ERROR_NULL - the argument code was null
-     *                   the argument where was null
-     * PCRE_ERROR_BADMAGIC - the "magic number" was not found
-     * PCRE_ERROR_BADOPTION - the value of what was invalid
-     * so a failure here means we passed in bad values and we should
-     * probably fatal error */
+        if ( flags & PCRE2_MULTILINE )
+            return false;
+        ++re;
+    }
 
-    case 0:
-        /* This is the success code */
-        break;
+    while ( *re )
+    {
+        char c = *re++;
 
-    case PCRE_ERROR_NULL:
-        ParseError("pcre_fullinfo: code and/or where were null.");
-        return;
+        if ( strchr("^$.[|()?*+{", c) )
+            return false;
 
-    case PCRE_ERROR_BADMAGIC:
-        ParseError("pcre_fullinfo: compiled code didn't have correct magic.");
-        return;
+        if ( c != '\\' )
+        {
+            lit += c;
+            continue;
+        }
+        c = *re++;
 
-    case PCRE_ERROR_BADOPTION:
-        ParseError("pcre_fullinfo: option type is invalid.");
-        return;
+        if ( !c )
+            return false;
 
-    default:
-        ParseError("pcre_fullinfo: Unknown error code.");
-        return;
+        else if ( !isalnum((unsigned char)c) )
+            lit += c;
+
+        else if ( c == 't' )
+            lit += '\t';
+
+        else if ( c == 'n' )
+            lit += '\n';
+
+        else if ( c == 'r' )
+            lit += '\r';
+
+        else if ( c == 'x' and isxdigit((unsigned char)re[0]) and isxdigit((unsigned char)re[1]) )
+        {
+            char hex[3] = { re[0], re[1], '\0' };
+            lit += (char)strtoul(hex, nullptr, 16);
+            re += 2;
+        }
+        else
+            return false;
     }
+    return !lit.empty();
+}
 
-    if ((options & PCRE_ANCHORED) && !(options & PCRE_MULTILINE))
+static void pcre_set_literal(PcreData* pcre_data, const std::string& lit, bool start, uint32_t flags)
+{
+    pcre_data->literal_len = lit.size();
+    pcre_data->literal = (uint8_t*)snort_alloc(lit.size());
+    pcre_data->no_case = (flags & PCRE2_CASELESS) != 0;
+
+    // like content, nocase patterns are upper case for the searchers
+    for ( unsigned i = 0; i < lit.size(); ++i )
     {
-        /* This means that this pcre rule option shouldn't be EvalStatus
-         * even if any of it's relative children should fail to match.
-         * It is anchored to the cursor set by the previous cursor setting
-         * rule option */
-        pcre_data->options |= SNORT_PCRE_ANCHORED;
+        uint8_t c = (uint8_t)lit[i];
+        pcre_data->literal[i] = pcre_data->no_case ? toupper(c) : c;
     }
+
+    if ( start )
+        pcre_data->options |= SNORT_PCRE_START;
+
+    // anchored literals are just compared at the one place they can be
+    else if ( !(flags & PCRE2_ANCHORED) )
+        pcre_data->searcher = LiteralSearch::instantiate(search_handle,
+            pcre_data->literal, pcre_data->literal_len, pcre_data->no_case);
+}
+
+static void pcre_set_limits(const SnortConfig* sc, PcreData* pcre_data)
+{
+    pcre_data->mcontext = pcre2_match_context_create(nullptr);
+
+    if ( !(pcre_data->options & SNORT_OVERRIDE_MATCH_LIMIT) )
+    {
+        if ( sc->get_pcre_match_limit() != 0 )
+            pcre2_set_match_limit(pcre_data->mcontext, sc->get_pcre_match_limit());
+
+        if ( sc->get_pcre_match_limit_recursion() != 0 )
+            pcre2_set_depth_limit(pcre_data->mcontext, sc->get_pcre_match_limit_recursion());
+    }
+
+    pcre2_jit_stack_assign(pcre_data->mcontext, get_jit_stack, nullptr);
+}
+
+#ifdef HAVE_HYPERSCAN
+// relative searches start from the cursor so a scan of the whole buffer
+// doesn't apply.  hyperscan has no equivalent of the extended flag.
+static void pcre_set_prefilter(PcreData* pcre_data, const char* re, uint32_t flags)
+{
+    if ( (pcre_data->options & SNORT_PCRE_RELATIVE) or (flags & PCRE2_EXTENDED) )
+        return;
+
+    pcre_data->prefilter = snort_strdup(re);
+
+    if ( flags & PCRE2_CASELESS )
+        pcre_data->prefilter_flags |= HS_FLAG_CASELESS;
+
+    if ( flags & PCRE2_DOTALL )
+        pcre_data->prefilter_flags |= HS_FLAG_DOTALL;
+
+    if ( flags & PCRE2_MULTILINE )
+        pcre_data->prefilter_flags |= HS_FLAG_MULTILINE;
 }
+#endif
 
 static void pcre_parse(const SnortConfig* sc, const char* data, PcreData* pcre_data)
 {
-    const char* error;
     char* re, * free_me;
     char* opts;
     char delimit = '/';
-    int erroffset;
-    int compile_flags = 0;
+    int errcode;
+    PCRE2_SIZE erroffset;
+    uint32_t compile_flags = 0;
+    std::string lit;
+    bool start;
 
     if (data == nullptr)
     {
@@ -230,17 +345,17 @@ static void pcre_parse(const SnortConfig* sc, const char* data, PcreData* pcre_d
     {
         switch (*opts)
         {
-        case 'i':  compile_flags |= PCRE_CASELESS;            break;
-        case 's':  compile_flags |= PCRE_DOTALL;              break;
-        case 'm':  compile_flags |= PCRE_MULTILINE;           break;
-        case 'x':  compile_flags |= PCRE_EXTENDED;            break;
+        case 'i':  compile_flags |= PCRE2_CASELESS;           break;
+        case 's':  compile_flags |= PCRE2_DOTALL;             break;
+        case 'm':  compile_flags |= PCRE2_MULTILINE;          break;
+        case 'x':  compile_flags |= PCRE2_EXTENDED;           break;
 
         /*
          * these are pcre specific... don't work with perl
          */
-        case 'A':  compile_flags |= PCRE_ANCHORED;            break;
-        case 'E':  compile_flags |= PCRE_DOLLAR_ENDONLY;      break;
-        case 'G':  compile_flags |= PCRE_UNGREEDY;            break;
+        case 'A':  compile_flags |= PCRE2_ANCHORED;           break;
+        case 'E':  compile_flags |= PCRE2_DOLLAR_ENDONLY;     break;
+        case 'G':  compile_flags |= PCRE2_UNGREEDY;           break;
 
         /*
          * these are snort specific don't work with pcre or perl
@@ -253,78 +368,52 @@ static void pcre_parse(const SnortConfig* sc, const char* data, PcreData* pcre_d
 
         default:
             ParseError("unknown/extra pcre option encountered");
+            snort_free(free_me);
             return;
         }
         opts++;
     }
 
-    /* now compile the re */
-    pcre_data->re = pcre_compile(re, compile_flags, &error, &erroffset, nullptr);
+    /* now compile the re; literals are compiled too so errors are the same */
+    pcre_data->re = pcre2_compile((PCRE2_SPTR)re, PCRE2_ZERO_TERMINATED, compile_flags,
+        &errcode, &erroffset, nullptr);
 
     if (pcre_data->re == nullptr)
     {
+        PCRE2_UCHAR error[128];
+        pcre2_get_error_message(errcode, error, sizeof(error));
+
         ParseError(": pcre compile of '%s' failed at offset "
-            "%d : %s", re, erroffset, error);
+            "%zu : %s", re, erroffset, (char*)error);
+        snort_free(free_me);
         return;
     }
 
-    /* now study it... */
-    pcre_data->pe = pcre_study(pcre_data->re, PCRE_STUDY_FLAGS, &error);
+    pcre_check_anchored(pcre_data);
 
-    if (pcre_data->pe)
-    {
-        if ((sc->get_pcre_match_limit() != 0) &&
-            !(pcre_data->options & SNORT_OVERRIDE_MATCH_LIMIT))
-        {
-            if ( !(pcre_data->pe->flags & PCRE_EXTRA_MATCH_LIMIT) )
-                pcre_data->pe->flags |= PCRE_EXTRA_MATCH_LIMIT;
+    if ( sc->get_profiler() and sc->get_profiler()->rule.show )
+        pcre_data->profile = new PcreProfile[ThreadConfig::get_instance_max()]();
 
-            pcre_data->pe->match_limit = sc->get_pcre_match_limit();
-        }
+    s_scratch_needed = true;
 
-        if ((sc->get_pcre_match_limit_recursion() != 0) &&
-            !(pcre_data->options & SNORT_OVERRIDE_MATCH_LIMIT))
-        {
-            if ( !(pcre_data->pe->flags & PCRE_EXTRA_MATCH_LIMIT_RECURSION) )
-                pcre_data->pe->flags |= PCRE_EXTRA_MATCH_LIMIT_RECURSION;
-
-            pcre_data->pe->match_limit_recursion =
-                sc->get_pcre_match_limit_recursion();
-        }
+    if ( pcre_literal(re, compile_flags, lit, start) )
+    {
+        pcre_set_literal(pcre_data, lit, start, compile_flags);
+        pcre2_code_free(pcre_data->re);
+        pcre_data->re = nullptr;
     }
     else
     {
-        if (!(pcre_data->options & SNORT_OVERRIDE_MATCH_LIMIT) &&
-            ((sc->get_pcre_match_limit() != 0) ||
-             (sc->get_pcre_match_limit_recursion() != 0)))
-        {
-            pcre_data->pe = (pcre_extra*)snort_calloc(sizeof(pcre_extra));
-            pcre_data->free_pe = true;
-
-            if (sc->get_pcre_match_limit() != 0)
-            {
-                pcre_data->pe->flags |= PCRE_EXTRA_MATCH_LIMIT;
-                pcre_data->pe->match_limit = sc->get_pcre_match_limit();
-            }
-
-            if (sc->get_pcre_match_limit_recursion() != 0)
-            {
-                pcre_data->pe->flags |= PCRE_EXTRA_MATCH_LIMIT_RECURSION;
-                pcre_data->pe->match_limit_recursion =
-                    sc->get_pcre_match_limit_recursion();
-            }
-        }
-    }
+#ifndef NO_JIT
+        pcre_data->jit = !pcre2_jit_compile(pcre_data->re, PCRE2_JIT_COMPLETE);
+#endif
+        pcre_set_limits(sc, pcre_data);
 
-    if (error != nullptr)
-    {
-        ParseError("pcre study failed : %s", error);
-        return;
+#ifdef HAVE_HYPERSCAN
+        pcre_set_prefilter(pcre_data, re, compile_flags);
+#endif
     }
 
-    pcre_capture(pcre_data->re, pcre_data->pe);
-    pcre_check_anchored(pcre_data);
-
     snort_free(free_me);
     return;
 
@@ -338,78 +427,128 @@ syntax:
     ParseError("unable to parse pcre %s", data);
 }
 
+static bool literal_at(const PcreData* pcre_data, const uint8_t* buf)
+{
+    if ( !pcre_data->no_case )
+        return !memcmp(buf, pcre_data->literal, pcre_data->literal_len);
+
+    for ( unsigned i = 0; i < pcre_data->literal_len; ++i )
+    {
+        if ( toupper(buf[i]) != pcre_data->literal[i] )
+            return false;
+    }
+    return true;
+}
+
+// same results as pcre for a literal regex
+static bool literal_search(
+    const PcreData* pcre_data,
+    const uint8_t* buf,
+    unsigned len,
+    unsigned start_offset,
+    int& found_offset)
+{
+    unsigned at;
+
+    if ( pcre_data->searcher )
+    {
+        int off = pcre_data->searcher->search(
+            search_handle, buf + start_offset, len - start_offset);
+
+        if ( off < 0 )
+            return false;
+
+        at = start_offset + off;
+    }
+    else
+    {
+        // ^ only matches at the start of the subject
+        if ( (pcre_data->options & SNORT_PCRE_START) and start_offset )
+            return false;
+
+        at = start_offset;
+
+        if ( len - at < pcre_data->literal_len or !literal_at(pcre_data, buf + at) )
+            return false;
+    }
+
+    found_offset = at + pcre_data->literal_len;
+    return true;
+}
+
 /*
  * Perform a search of the PCRE data.
  * found_offset will be set to -1 when the find is unsuccessful OR the routine is inverted
  */
 static bool pcre_search(
     Packet* p,
+    const IpsOption* opt,
     const PcreData* pcre_data,
     const uint8_t* buf,
     unsigned len,
     unsigned start_offset,
     int& found_offset)
 {
+#ifndef HAVE_HYPERSCAN
+    UNUSED(opt);
+#endif
     bool matched;
 
     found_offset = -1;
 
-    std::vector<void *> ss = p->context->conf->state[get_instance_id()];
-    assert(ss[scratch_index]);
-
-    int result = pcre_exec(
-        pcre_data->re,  /* result of pcre_compile() */
-        pcre_data->pe,  /* result of pcre_study()   */
-        (const char*)buf, /* the subject string */
-        len,            /* the length of the subject string */
-        start_offset,   /* start at offset 0 in the subject */
-        0,              /* options(handled at compile time */
-        (int*)ss[scratch_index], /* vector for substring information */
-        p->context->conf->pcre_ovector_size); /* number of elements in the vector */
-
-    if (result >= 0)
-    {
-        matched = true;
-
-        /* From the PCRE man page: When a match is successful, information
-         * about captured substrings is returned in pairs of integers,
-         * starting at the beginning of ovector, and continuing up to
-         * two-thirds of its length at the most.  The first element of a
-         * pair is set to the offset of the first character in a substring,
-         * and the second is set to the offset of the first character after
-         * the end of a substring. The first pair, ovector[0] and
-         * ovector[1], identify the portion of the subject string matched
-         * by the entire pattern.  The next pair is used for the first
-         * capturing subpattern, and so on. The value returned by
-         * pcre_exec() is the number of pairs that have been set. If there
-         * are no capturing subpatterns, the return value from a successful
-         * match is 1, indicating that just the first pair of offsets has
-         * been set.
-         *
-         * In Snort's case, the ovector size only allows for the first pair
-         * and a single int for scratch space.
-         */
+    if ( pcre_data->literal )
+        matched = literal_search(pcre_data, buf, len, start_offset, found_offset);
 
-        found_offset = ((int*)ss[scratch_index])[1];
-    }
-    else if (result == PCRE_ERROR_NOMATCH)
-    {
-        matched = false;
-    }
-    else if (result == PCRE_ERROR_MATCHLIMIT)
-    {
-        pc.pcre_match_limit++;
-        matched = false;
-    }
-    else if (result == PCRE_ERROR_RECURSIONLIMIT)
-    {
-        pc.pcre_recursion_limit++;
+#ifdef HAVE_HYPERSCAN
+    // prefilter regexes aren't relative so buf is the whole buffer
+    else if ( pcre_data->prefilter and RegexPrefilter::skip(p, opt, buf, len) )
         matched = false;
-    }
+#endif
+
     else
     {
-        pc.pcre_error++;
-        return false;
+        const std::vector<void *>& ss = p->context->conf->state[get_instance_id()];
+        PcreScratch* scratch = (PcreScratch*)ss[scratch_index];
+        assert(scratch);
+
+        s_jit_stack = scratch->jit_stack;
+
+        int result = pcre2_match(
+            pcre_data->re,          /* result of pcre2_compile() */
+            (PCRE2_SPTR)buf,        /* the subject string */
+            len,                    /* the length of the subject string */
+            start_offset,           /* start at offset 0 in the subject */
+            0,                      /* options are handled at compile time */
+            scratch->match_data,    /* substring information */
+            pcre_data->mcontext);   /* limits and jit stack */
+
+        if (result >= 0)
+        {
+            // the first pair identifies the portion of the subject string
+            // matched by the entire pattern; the second element is the
+            // offset of the first character after the end of the match
+            matched = true;
+            found_offset = (int)pcre2_get_ovector_pointer(scratch->match_data)[1];
+        }
+        else if (result == PCRE2_ERROR_NOMATCH)
+        {
+            matched = false;
+        }
+        else if (result == PCRE2_ERROR_MATCHLIMIT)
+        {
+            pc.pcre_match_limit++;
+            matched = false;
+        }
+        else if (result == PCRE2_ERROR_DEPTHLIMIT or result == PCRE2_ERROR_JIT_STACKLIMIT)
+        {
+            pc.pcre_recursion_limit++;
+            matched = false;
+        }
+        else
+        {
+            pc.pcre_error++;
+            return false;
+        }
     }
 
     /* invert sense of match */
@@ -421,6 +560,43 @@ static bool pcre_search(
     return matched;
 }
 
+//-------------------------------------------------------------------------
+// profile
+//-------------------------------------------------------------------------
+
+static void get_pattern_stats(std::vector<RulePatternStats>& v)
+{
+    for ( const auto* pd : s_patterns )
+    {
+        if ( !pd->profile )
+            continue;
+
+        RulePatternStats ps = { };
+        ps.pattern = pd->expression;
+        ps.engine = pd->literal ? "literal" : (pd->jit ? "jit" : "pcre");
+
+        for ( unsigned i = 0; i < ThreadConfig::get_instance_max(); ++i )
+        {
+            ps.checks += pd->profile[i].checks;
+            ps.matches += pd->profile[i].matches;
+            ps.elapsed += pd->profile[i].elapsed;
+        }
+        v.emplace_back(ps);
+    }
+}
+
+static void reset_pattern_stats()
+{
+    for ( const auto* pd : s_patterns )
+    {
+        if ( !pd->profile )
+            continue;
+
+        for ( unsigned i = 0; i < ThreadConfig::get_instance_max(); ++i )
+            pd->profile[i] = PcreProfile();
+    }
+}
+
 //-------------------------------------------------------------------------
 // class methods
 //-------------------------------------------------------------------------
@@ -430,7 +606,10 @@ class PcreOption : public IpsOption
 public:
     PcreOption(PcreData* c) :
         IpsOption(s_name, RULE_OPTION_TYPE_CONTENT)
-    { config = c; }
+    {
+        config = c;
+        s_patterns.emplace_back(config);
+    }
 
     ~PcreOption() override;
 
@@ -446,6 +625,14 @@ public:
     EvalStatus eval(Cursor&, Packet*) override;
     bool retry(Cursor&, const Cursor&) override;
 
+#ifdef HAVE_HYPERSCAN
+    const char* get_prefilter(unsigned& flags) const override
+    {
+        flags = config->prefilter_flags;
+        return config->prefilter;
+    }
+#endif
+
     PcreData* get_data()
     { return config; }
 
@@ -461,19 +648,28 @@ PcreOption::~PcreOption()
     if ( !config )
         return;
 
+    auto it = std::find(s_patterns.begin(), s_patterns.end(), config);
+
+    if ( it != s_patterns.end() )
+        s_patterns.erase(it);
+
     if ( config->expression )
         snort_free(config->expression);
 
-    if ( config->pe )
-    {
-        if ( config->free_pe )
-            snort_free(config->pe);
-        else
-            pcre_release(config->pe);
-    }
+    if ( config->mcontext )
+        pcre2_match_context_free(config->mcontext);
 
     if ( config->re )
-        free(config->re);  // external allocation
+        pcre2_code_free(config->re);
+
+    if ( config->literal )
+        snort_free(config->literal);
+
+    if ( config->prefilter )
+        snort_free(config->prefilter);
+
+    delete config->searcher;
+    delete[] config->profile;
 
     snort_free(config);
 }
@@ -568,8 +764,26 @@ IpsOption::EvalStatus PcreOption::eval(Cursor& c, Packet* p)
         adj = c.get_pos();
 
     int found_offset = -1; // where is the ending location of the pattern
+    bool matched;
 
-    if ( pcre_search(p, config, c.buffer()+adj, c.size()-adj, pos, found_offset) )
+    if ( rule_profiler_enabled() and config->profile )
+    {
+        Stopwatch<SnortClock> sw;
+        sw.start();
+
+        matched = pcre_search(p, this, config, c.buffer()+adj, c.size()-adj, pos, found_offset);
+
+        PcreProfile& pp = config->profile[get_instance_id()];
+        pp.elapsed += sw.get();
+        pp.checks++;
+
+        if ( matched )
+            pp.matches++;
+    }
+    else
+        matched = pcre_search(p, this, config, c.buffer()+adj, c.size()-adj, pos, found_offset);
+
+    if ( matched )
     {
         if ( found_offset > 0 )
         {
@@ -622,6 +836,8 @@ struct PcreStats
     PegCount pcre_to_hyper;
 #endif
     PegCount pcre_native;
+    PegCount pcre_jit;
+    PegCount pcre_literal;
     PegCount pcre_negated;
 };
 
@@ -632,6 +848,8 @@ const PegInfo pcre_pegs[] =
     { CountType::SUM, "pcre_to_hyper", "total pcre rules by hyperscan engine" },
 #endif
     { CountType::SUM, "pcre_native", "total pcre rules compiled by pcre engine" },
+    { CountType::SUM, "pcre_jit", "total pcre rules compiled with jit" },
+    { CountType::SUM, "pcre_literal", "total pcre rules matched with a literal search" },
     { CountType::SUM, "pcre_negated", "total pcre rules using negation syntax" },
     { CountType::END, nullptr, nullptr }
 };
@@ -649,12 +867,16 @@ public:
         data = nullptr;
         scratcher = new SimpleScratchAllocator(scratch_setup, scratch_cleanup);
         scratch_index = scratcher->get_id();
+        search_handle = LiteralSearch::setup();
+        add_rule_pattern_stats(s_name, get_pattern_stats, reset_pattern_stats);
     }
 
     ~PcreModule() override
     {
+        remove_rule_pattern_stats(s_name);
         delete data;
         delete scratcher;
+        LiteralSearch::cleanup(search_handle);
     }
 
 #ifdef HAVE_HYPERSCAN
@@ -745,22 +967,20 @@ bool PcreModule::end(const char* name, int v, SnortConfig* sc)
 
 bool PcreModule::scratch_setup(SnortConfig* sc)
 {
-    if ( s_ovector_max < 0 )
+    if ( !s_scratch_needed )
         return false;
 
-    // The pcre_fullinfo() function can be used to find out how many
-    // capturing subpatterns there are in a compiled pattern. The
-    // smallest size for ovector that will allow for n captured
-    // substrings, in addition to the offsets of the substring matched
-    // by the whole pattern is 3(n+1).
-
-    sc->pcre_ovector_size = 3 * (s_ovector_max + 1);
-    s_ovector_max = -1;
+    s_scratch_needed = false;
 
     for ( unsigned i = 0; i < sc->num_slots; ++i )
     {
         std::vector<void *>& ss = sc->state[i];
-        ss[scratch_index] = snort_calloc(sc->pcre_ovector_size, sizeof(int));
+        PcreScratch* scratch = (PcreScratch*)snort_calloc(sizeof(PcreScratch));
+
+        scratch->match_data = pcre2_match_data_create(1, nullptr);
+        scratch->jit_stack = pcre2_jit_stack_create(JIT_STACK_START, JIT_STACK_MAX, nullptr);
+
+        ss[scratch_index] = scratch;
     }
     return true;
 }
@@ -770,7 +990,17 @@ void PcreModule::scratch_cleanup(SnortConfig* sc)
     for ( unsigned i = 0; i < sc->num_slots; ++i )
     {
         std::vector<void *>& ss = sc->state[i];
-        snort_free(ss[scratch_index]);
+        PcreScratch* scratch = (PcreScratch*)ss[scratch_index];
+
+        if ( scratch )
+        {
+            pcre2_match_data_free(scratch->match_data);
+
+            if ( scratch->jit_stack )
+                pcre2_jit_stack_free(scratch->jit_stack);
+
+            snort_free(scratch);
+        }
         ss[scratch_index] = nullptr;
     }
 }
@@ -805,6 +1035,13 @@ static IpsOption* pcre_ctor(Module* p, OptTreeNode* otn)
     {
         pcre_stats.pcre_native++;
         PcreData* d = m->get_data();
+
+        if ( d->literal )
+            pcre_stats.pcre_literal++;
+
+        else if ( d->jit )
+            pcre_stats.pcre_jit++;
+
         return new PcreOption(d);
     }
 }
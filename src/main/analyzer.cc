@@ -51,6 +51,7 @@
 #include "managers/ips_manager.h"
 #include "managers/event_manager.h"
 #include "managers/module_manager.h"
+#include "memory/memory_arena.h"
 #include "memory/memory_cap.h"
 #include "packet_io/active.h"
 #include "packet_io/sfdaq.h"
@@ -256,6 +257,11 @@ static DAQ_Verdict distill_verdict(Packet* p)
         PacketManager::encode_update(p);
         verdict = DAQ_VERDICT_REPLACE;
     }
+    else if ( p->packet_flags & PKT_REWRITTEN )
+    {
+        // normalized fields were rewritten and checksums kept up to date
+        verdict = DAQ_VERDICT_REPLACE;
+    }
     else if ( act->session_was_trusted() )
         verdict = DAQ_VERDICT_WHITELIST;
     else if ( (p->packet_flags & PKT_IGNORE) ||
@@ -366,6 +372,7 @@ void Analyzer::post_process_daq_pkt_msg(Packet* p)
             p->daq_instance->finalize_message(p->daq_msg, verdict);
         }
     }
+    memory::MemoryArena::end_packet();
 }
 
 void Analyzer::process_daq_pkt_msg(DAQ_Msg_h msg, bool retry)
@@ -815,6 +822,25 @@ void Analyzer::handle_uncompleted_commands()
     }
 }
 
+// Keep the flows of the next window messages of the batch in flight so
+// that flow lookups overlap with the processing of earlier packets.
+// ahead is the number of pending messages already prefetched.
+void Analyzer::prefetch_flows(unsigned& ahead, unsigned window)
+{
+    while (ahead < window)
+    {
+        DAQ_Msg_h msg = daq_instance->peek_message(ahead);
+        if (!msg)
+            break;
+        if (daq_msg_get_type(msg) == DAQ_MSG_TYPE_PACKET)
+        {
+            Stream::prefetch_flow(daq_msg_get_pkthdr(msg), daq_msg_get_data(msg),
+                daq_msg_get_data_len(msg));
+        }
+        ahead++;
+    }
+}
+
 DAQ_RecvStatus Analyzer::process_messages()
 {
     // Max receive becomes the minimum of the configured batch size, the remaining exit_after
@@ -835,10 +861,23 @@ DAQ_RecvStatus Analyzer::process_messages()
     // This conveniently handles servicing offloads in the no messages received case as well.
     DetectionEngine::onload();
 
+    unsigned prefetch_window = Stream::get_prefetch_window();
+    unsigned prefetched = 0;
+
+    if (prefetch_window)
+        prefetch_flows(prefetched, prefetch_window);
+
     unsigned num_recv = 0;
     DAQ_Msg_h msg;
     while ((msg = daq_instance->next_message()) != nullptr)
     {
+        if (prefetch_window)
+        {
+            if (prefetched)
+                prefetched--;
+            prefetch_flows(prefetched, prefetch_window);
+        }
+
         // Dispose of any messages to be skipped first.
         if (skip_cnt > 0)
         {
@@ -857,6 +896,14 @@ DAQ_RecvStatus Analyzer::process_messages()
         handle_uncompleted_commands();
     }
 
+    // don't hold batched searches while waiting for the next daq batch
+    if (num_recv)
+        DetectionEngine::flush_batch();
+
+    // a short batch means there is time to catch up on deferred cleanup
+    if (num_recv < max_recv)
+        Stream::delete_flow_data(max_recv - num_recv);
+
     if (exit_after_cnt && (exit_after_cnt -= num_recv) == 0)
         stop();
     if (pause_after_cnt && (pause_after_cnt -= num_recv) == 0)
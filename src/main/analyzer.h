@@ -123,6 +123,7 @@ private:
     void process_daq_pkt_msg(DAQ_Msg_h, bool retry);
     void post_process_daq_pkt_msg(snort::Packet*);
     void process_retry_queue();
+    void prefetch_flows(unsigned& ahead, unsigned window);
     void set_state(State);
     void idle();
     bool init_privileged();
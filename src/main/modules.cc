@@ -146,6 +146,9 @@ static const Parameter search_engine_params[] =
     { "bleedover_port_limit", Parameter::PT_INT, "1:max32", "1024",
       "maximum ports in rule before demotion to any-any port group" },
 
+    { "cache_dir", Parameter::PT_STRING, nullptr, nullptr,
+      "directory for compiled search engine databases reused by startup and reload" },
+
     { "bleedover_warnings_enabled", Parameter::PT_BOOL, nullptr, "false",
       "print warning if a rule is demoted to any-any port group" },
 
@@ -167,6 +170,9 @@ static const Parameter search_engine_params[] =
     { "debug_print_rule_groups_compiled", Parameter::PT_BOOL, nullptr, "false",
       "prints compiled rule group information" },
 
+    { "max_compile_threads", Parameter::PT_INT, "0:max32", "0",
+      "maximum threads used to compile search engines (0 means one per core)" },
+
     { "max_pattern_len", Parameter::PT_INT, "0:max32", "0",
       "truncate patterns when compiling into state machine (0 means no maximum)" },
 
@@ -241,6 +247,9 @@ bool SearchEngineModule::set(const char*, Value& v, SnortConfig* sc)
     if ( v.is("bleedover_port_limit") )
         fp->set_bleed_over_port_limit(v.get_uint32());
 
+    else if ( v.is("cache_dir") )
+        fp->set_cache_dir(v.get_string());
+
     else if ( v.is("bleedover_warnings_enabled") )
     {
         if ( v.get_bool() )
@@ -276,6 +285,9 @@ bool SearchEngineModule::set(const char*, Value& v, SnortConfig* sc)
         if ( v.get_bool() )
             fp->set_debug_print_rule_groups_compiled();
     }
+    else if ( v.is("max_compile_threads") )
+        fp->set_max_compile_threads(v.get_uint32());
+
     else if ( v.is("max_pattern_len") )
         fp->set_max_pattern_len(v.get_uint32());
 
@@ -1029,6 +1041,9 @@ static const Parameter network_params[] =
       "all | ip | noip | tcp | notcp | udp | noudp | icmp | noicmp | none", "all",
       "checksums to verify" },
 
+    { "checksum_lazy", Parameter::PT_BOOL, nullptr, "false",
+      "defer tcp and udp checksums until a packet is inspected and skip them otherwise" },
+
     { "id", Parameter::PT_INT, "0:65535", "0",
       "correlate unified2 events with configuration" },
 
@@ -1076,6 +1091,9 @@ bool NetworkModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("checksum_eval") )
         ConfigChecksumMode(v.get_string());
 
+    else if ( v.is("checksum_lazy") )
+        p->checksum_lazy = v.get_bool();
+
     else if ( v.is("id") )
     {
         p->user_policy_id = v.get_uint16();
@@ -2047,6 +2065,7 @@ void module_init()
     ModuleManager::add_module(new CodecModule);
     ModuleManager::add_module(new DetectionModule);
     ModuleManager::add_module(new MemoryModule);
+    ModuleManager::add_module(new MemoryArenaModule);
     ModuleManager::add_module(new PacketTracerModule);
     ModuleManager::add_module(new PacketsModule);
     ModuleManager::add_module(new ProcessModule);
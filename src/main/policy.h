@@ -115,6 +115,7 @@ public:
     uint32_t checksum_eval;
     uint32_t checksum_drop;
     uint32_t normal_mask;
+    bool checksum_lazy;
 };
 
 //-------------------------------------------------------------------------
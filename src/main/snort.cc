@@ -53,7 +53,9 @@
 #include "managers/mpse_manager.h"
 #include "managers/plugin_manager.h"
 #include "managers/script_manager.h"
+#include "memory/memory_arena.h"
 #include "memory/memory_cap.h"
+#include "memory/memory_reclaim.h"
 #include "network_inspectors/network_inspectors.h"
 #include "packet_io/active.h"
 #include "packet_io/sfdaq.h"
@@ -386,6 +388,17 @@ bool Snort::is_reloading()
 bool Snort::has_dropped_privileges()
 { return privileges_dropped; }
 
+// the host cache is shared and has its own memcap so it only reports
+static size_t host_cache_held()
+{ return host_cache.mem_size(); }
+
+static void host_cache_arena(memory::ArenaStats& s)
+{
+    s.bytes = host_cache.mem_size();
+    s.max_bytes = host_cache.get_max_mem_size();
+    s.allocs = host_cache.get_mem_allocs();
+}
+
 void Snort::setup(int argc, char* argv[])
 {
     set_main_thread();
@@ -412,6 +425,11 @@ void Snort::setup(int argc, char* argv[])
     memory::MemoryCap::print();
     host_cache.print_config();
 
+    memory::Reclaimer hc;
+    hc.held = host_cache_held;
+    memory::MemoryReclaim::add(memory::Consumer::HOST_CACHE, hc);
+    memory::MemoryArena::set_source(memory::Arena::HOST_CACHE, host_cache_arena);
+
     TimeStart();
 }
 
@@ -125,6 +125,20 @@ enum TunnelFlags
     TUNNEL_GENEVE = 0x200
 };
 
+enum OffloadWait
+{
+    OFFLOAD_WAIT_BLOCK = 0,  // condition variable per request
+    OFFLOAD_WAIT_SPIN,       // busy poll rings
+    OFFLOAD_WAIT_ADAPTIVE    // poll rings then park when idle
+};
+
+enum OptionProgramMode
+{
+    OPTION_PROGRAM_OFF = 0,  // evaluate option trees
+    OPTION_PROGRAM_ON,       // evaluate flattened trees
+    OPTION_PROGRAM_CHECK     // evaluate trees and compare with flattened trees
+};
+
 enum DumpConfigType
 {
     DUMP_CONFIG_NONE = 0,
@@ -163,6 +177,7 @@ namespace snort
 {
 class GHash;
 class ProtocolReference;
+class RegexPrefilter;
 class ThreadConfig;
 class XHash;
 struct ProfilerConfig;
@@ -245,7 +260,6 @@ public:
     long int pcre_match_limit = 1500;
     long int pcre_match_limit_recursion = 1500;
 
-    int pcre_ovector_size = 0;
     bool pcre_override = true;
 
     int asn1_mem = 0;
@@ -253,9 +267,17 @@ public:
 
     unsigned offload_limit = 99999;  // disabled
     unsigned offload_threads = 0;    // disabled
+    OffloadWait offload_wait = OFFLOAD_WAIT_BLOCK;
+    bool offload_shared = false;
+
+    unsigned batch_size = 0;         // disabled
+    unsigned batch_timeout = 100;    // usecs
+
+    OptionProgramMode option_program = OPTION_PROGRAM_OFF;
 
 #ifdef HAVE_HYPERSCAN
     bool hyperscan_literals = false;
+    bool pcre_prefilter = false;
     bool pcre_to_regex = false;
 #endif
 
@@ -387,6 +409,8 @@ public:
 
     XHash* detection_option_hash_table = nullptr;
     XHash* detection_option_tree_hash_table = nullptr;
+    unsigned option_tree_nodes = 0;
+    RegexPrefilter* regex_prefilter = nullptr;
     XHash* rtn_hash_table = nullptr;
 
     PolicyMap* policy_map = nullptr;
@@ -496,6 +520,10 @@ public:
     bool aux_ip_is_enabled() const
     { return max_aux_ip >= 0; }
 
+    // offloaded and batched searches complete after later packets
+    bool offload_enabled() const
+    { return offload_threads or batch_size > 1; }
+
     // mode related
     bool dump_config_mode() const
     { return dump_config_type > DUMP_CONFIG_NONE; }
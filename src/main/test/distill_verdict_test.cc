@@ -26,6 +26,7 @@
 #include "stubs.h"
 
 #include "main/analyzer.h"
+#include "memory/memory_arena.h"
 #include "memory/memory_cap.h"
 #include "packet_io/sfdaq_instance.h"
 #include "packet_io/sfdaq.h"
@@ -53,6 +54,7 @@ SFDAQInstance* SFDAQ::get_local_instance() { return nullptr; }
 
 void memory::MemoryCap::update_allocations(size_t) { }
 void memory::MemoryCap::update_deallocations(size_t) { }
+void memory::MemoryArena::end_packet() { }
 
 using namespace snort;
 
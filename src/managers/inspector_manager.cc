@@ -39,8 +39,10 @@
 #include "main/snort_debug.h"
 #include "main/snort_module.h"
 #include "main/thread_config.h"
+#include "packet_io/active.h"
 #include "search_engines/search_tool.h"
 #include "protocols/packet.h"
+#include "protocols/packet_manager.h"
 #include "target_based/snort_protocols.h"
 #include "time/clock_defs.h"
 #include "time/stopwatch.h"
@@ -1230,6 +1232,7 @@ void InspectorManager::internal_execute(Packet* p)
         timer.start();
     }
 
+    const SnortConfig* sc = p->context->conf;
     FrameworkPolicy* fp = get_inspection_policy()->framework_policy;
     assert(fp);
 
@@ -1246,13 +1249,25 @@ void InspectorManager::internal_execute(Packet* p)
     if ( p->disable_inspect )
         return;
 
+    // a checksum deferred by decode is evaluated once stream has decided
+    // the packet is inspected and before anything consumes the payload
+    if ( !PacketManager::verify_checksums(p) )
+    {
+        if ( sc->inline_mode() and
+            get_network_policy()->checksum_drops(p->ptrs.decode_flags & DECODE_ERR_CKSUM_ALL) )
+            p->active->drop_packet(p);
+
+        DetectionEngine::disable_all(p);
+        p->disable_inspect = true;
+        return;
+    }
+
     if ( !p->is_cooked() )
         ::execute<T>(p, fp->packet.vec, fp->packet.num);
 
     if ( p->disable_inspect )
         return;
 
-    const SnortConfig* sc = p->context->conf;
     FrameworkPolicy* fp_dft = get_default_inspection_policy(sc)->framework_policy;
 
     if ( !p->flow )
@@ -0,0 +1,150 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// memory_arena.cc - per subsystem memory attribution
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "memory_arena.h"
+
+#include <cassert>
+
+#ifdef UNIT_TEST
+#include <cstring>
+
+#include "catch/snort_catch.h"
+#endif
+
+using namespace memory;
+
+ArenaSource MemoryArena::sources[(unsigned)Arena::MAX];
+
+THREAD_LOCAL ArenaStats MemoryArena::stats[(unsigned)Arena::MAX];
+THREAD_LOCAL unsigned MemoryArena::packet_allocs[(unsigned)Arena::MAX];
+
+static const char* const arena_names[(unsigned)Arena::MAX] =
+{
+    "none",
+    "stream_tcp",
+    "defrag",
+    "http_inspect",
+    "appid",
+    "file_api",
+    "host_cache",
+    "detection",
+};
+
+void MemoryArena::set_source(Arena a, ArenaSource src)
+{
+    assert(a != Arena::NONE and a != Arena::MAX);
+    sources[(unsigned)a] = src;
+}
+
+void MemoryArena::end_packet()
+{
+    for ( unsigned i = 0; i < (unsigned)Arena::MAX; ++i )
+    {
+        if ( packet_allocs[i] > stats[i].peak_allocs )
+            stats[i].peak_allocs = packet_allocs[i];
+
+        packet_allocs[i] = 0;
+    }
+}
+
+void MemoryArena::refresh()
+{
+    for ( unsigned i = 0; i < (unsigned)Arena::MAX; ++i )
+    {
+        if ( sources[i] )
+            sources[i](stats[i]);
+    }
+}
+
+const char* MemoryArena::get_name(Arena a)
+{
+    assert(a < Arena::MAX);
+    return arena_names[(unsigned)a];
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static void shared_source(ArenaStats& s)
+{
+    s.bytes = 100;
+    s.max_bytes = 200;
+}
+
+TEST_CASE("arena charge", "[memory_arena]")
+{
+    ArenaStats* s = MemoryArena::get_stats() - 1;
+    ArenaStats& tcp = s[(unsigned)Arena::STREAM_TCP];
+    tcp = { };
+
+    MemoryArena::charge(Arena::STREAM_TCP, 64);
+    MemoryArena::charge(Arena::STREAM_TCP, 32);
+    MemoryArena::credit(Arena::STREAM_TCP, 64);
+
+    CHECK(tcp.bytes == 32);
+    CHECK(tcp.max_bytes == 96);
+    CHECK(tcp.allocs == 2);
+
+    MemoryArena::credit(Arena::STREAM_TCP, 32);
+    CHECK(tcp.bytes == 0);
+    CHECK(tcp.max_bytes == 96);
+}
+
+TEST_CASE("arena peak allocs", "[memory_arena]")
+{
+    ArenaStats* s = MemoryArena::get_stats() - 1;
+    ArenaStats& det = s[(unsigned)Arena::DETECTION];
+    det = { };
+    MemoryArena::end_packet();
+
+    for ( unsigned i = 0; i < 3; ++i )
+        MemoryArena::charge(Arena::DETECTION, 8);
+
+    MemoryArena::end_packet();
+    CHECK(det.peak_allocs == 3);
+
+    MemoryArena::charge(Arena::DETECTION, 8);
+    MemoryArena::end_packet();
+    CHECK(det.peak_allocs == 3);
+    CHECK(det.allocs == 4);
+}
+
+TEST_CASE("arena source", "[memory_arena]")
+{
+    CHECK(!strcmp(MemoryArena::get_name(Arena::HOST_CACHE), "host_cache"));
+
+    MemoryArena::set_source(Arena::HOST_CACHE, shared_source);
+    MemoryArena::refresh();
+
+    ArenaStats* s = MemoryArena::get_stats() - 1;
+    CHECK(s[(unsigned)Arena::HOST_CACHE].bytes == 100);
+    CHECK(s[(unsigned)Arena::HOST_CACHE].max_bytes == 200);
+    MemoryArena::set_source(Arena::HOST_CACHE, nullptr);
+}
+
+#endif
+
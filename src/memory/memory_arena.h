@@ -0,0 +1,113 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// memory_arena.h - per subsystem memory attribution
+
+#ifndef MEMORY_ARENA_H
+#define MEMORY_ARENA_H
+
+// the major subsystems tag the memory they allocate with an arena so its
+// current and high water bytes and the number of allocations are known per
+// subsystem at all times.  charging is a few thread local adds so it is
+// always on, unlike the memory profiler which must intercept operator new.
+//
+// arenas are charged where the memory is accounted anyway, eg by FlowData,
+// a SlabAllocator, or alongside MemoryCap.  memory must be credited to the
+// arena it was charged to.  the counts are per packet thread so memory
+// freed on another thread only balances in the sum over all threads.
+// caches shared by all threads keep their own books and provide a source
+// instead.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "framework/counts.h"
+#include "main/snort_types.h"
+#include "main/thread.h"
+
+namespace memory
+{
+enum class Arena : uint8_t
+{
+    NONE,  // untagged, not reported
+    STREAM_TCP,
+    DEFRAG,
+    HTTP_INSPECT,
+    APPID,
+    FILE_API,
+    HOST_CACHE,
+    DETECTION,
+    MAX
+};
+
+// the peg layout of each arena, see MemoryArenaModule
+struct ArenaStats
+{
+    PegCount bytes;        // currently charged
+    PegCount max_bytes;    // high water
+    PegCount allocs;       // number of charges
+    PegCount peak_allocs;  // most charges while processing one packet
+};
+
+using ArenaSource = void (*)(ArenaStats&);
+
+class SO_PUBLIC MemoryArena
+{
+public:
+    static void charge(Arena a, size_t n)
+    {
+        ArenaStats& s = stats[(unsigned)a];
+        s.bytes += n;
+
+        if ( s.bytes > s.max_bytes )
+            s.max_bytes = s.bytes;
+
+        ++s.allocs;
+        ++packet_allocs[(unsigned)a];
+    }
+
+    static void credit(Arena a, size_t n)
+    { stats[(unsigned)a].bytes -= n; }
+
+    // for shared arenas; call from the main thread before the packet
+    // threads start
+    static void set_source(Arena, ArenaSource);
+
+    // call after each packet to track the peak allocations per packet
+    static void end_packet();
+
+    // updates the shared arenas from their sources
+    static void refresh();
+
+    // the stats of this thread starting with the first reported arena
+    static ArenaStats* get_stats()
+    { return stats + (unsigned)Arena::NONE + 1; }
+
+    static const char* get_name(Arena);
+
+private:
+    static ArenaSource sources[(unsigned)Arena::MAX];
+
+    static THREAD_LOCAL ArenaStats stats[(unsigned)Arena::MAX];
+    static THREAD_LOCAL unsigned packet_allocs[(unsigned)Arena::MAX];
+};
+
+} // namespace memory
+
+#endif
+
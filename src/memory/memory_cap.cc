@@ -34,7 +34,7 @@
 
 #include "memory_config.h"
 #include "memory_module.h"
-#include "prune_handler.h"
+#include "memory_reclaim.h"
 
 #ifdef UNIT_TEST
 #include "catch/snort_catch.h"
@@ -74,6 +74,9 @@ struct Tracker
 
 static Tracker s_tracker;
 
+// bounds the work done per packet below the cap
+static const unsigned max_steps_per_packet = 16;
+
 // -----------------------------------------------------------------------------
 // helpers
 // -----------------------------------------------------------------------------
@@ -138,7 +141,16 @@ void MemoryCap::free_space(size_t n)
         return;
 
     entered = true;
-    memory::free_space(n, thread_cap, s_tracker, prune_handler);
+    auto before = s_tracker.used();
+
+    auto step = []()
+    { MemoryReclaim::step(true); };
+
+    memory::free_space(n, thread_cap, s_tracker, step);
+
+    if ( s_tracker.used() < before )
+        mem_stats.reclaimed += before - s_tracker.used();
+
     entered = false;
 }
 
@@ -181,6 +193,43 @@ bool MemoryCap::over_threshold()
     return s_tracker.used() >= preemptive_threshold;
 }
 
+// the fraction of the excess freed grows with the excess itself so a
+// thread just over the threshold sheds a little per packet and one at the
+// cap sheds everything over the threshold.  at least one step is taken
+// while over.
+void MemoryCap::reclaim()
+{
+    if ( !preemptive_threshold )
+        return;
+
+    auto used = s_tracker.used();
+
+    if ( used < preemptive_threshold )
+        return;
+
+    size_t over = used - preemptive_threshold;
+    size_t span = thread_cap > preemptive_threshold ? thread_cap - preemptive_threshold : 1;
+    size_t want = over;
+
+    if ( over < span )
+        want = (size_t)((double)over * over / span);
+
+    size_t target = used > want ? used - want : 0;
+    unsigned steps = 0;
+
+    ++mem_stats.reclaim_rounds;
+
+    do
+    {
+        if ( !MemoryReclaim::step(false) )
+            break;
+    }
+    while ( ++steps < max_steps_per_packet and s_tracker.used() > target );
+
+    if ( s_tracker.used() < used )
+        mem_stats.reclaimed += used - s_tracker.used();
+}
+
 // FIXIT-L this should not be called while the packet threads are running.
 // once reload is implemented for the memory manager, the configuration
 // model will need to be updated
@@ -39,6 +39,10 @@ public:
 
     static bool over_threshold();
 
+    // call once per packet to free space in proportion to how far over the
+    // preemptive threshold the thread is
+    static void reclaim();
+
     // call from main thread
     static void calculate();
 
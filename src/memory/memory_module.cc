@@ -26,7 +26,9 @@
 
 #include "main/snort_config.h"
 
+#include "memory_arena.h"
 #include "memory_config.h"
+#include "memory_reclaim.h"
 
 using namespace snort;
 
@@ -63,6 +65,13 @@ const PegInfo mem_pegs[] =
     { CountType::NOW, "reap_failures", "failures to reclaim memory" },
     { CountType::MAX, "max_in_use", "highest allocated - deallocated" },
     { CountType::NOW, "total_fudge", "sum of all adjustments" },
+    { CountType::SUM, "reclaim_rounds", "packets that freed memory over the preemptive threshold" },
+    { CountType::SUM, "reclaimed", "bytes freed by reclaiming from consumers" },
+    { CountType::NOW, "flows_held", "bytes held by flow cache entries" },
+    { CountType::NOW, "flow_data_held", "bytes of flow data waiting for deferred deletion" },
+    { CountType::NOW, "tcp_segments_held", "bytes held in tcp reassembly segments" },
+    { CountType::MAX, "file_cache_held", "bytes held by the shared file cache" },
+    { CountType::MAX, "host_cache_held", "bytes held by the shared host cache" },
     { CountType::END, nullptr, nullptr }
 };
 
@@ -105,3 +114,101 @@ const PegInfo* MemoryModule::get_pegs() const
 PegCount* MemoryModule::get_counts() const
 { return is_active() ? (PegCount*)&mem_stats : (PegCount*)&zero_stats; }
 
+void MemoryModule::prep_counts()
+{
+    using memory::Consumer;
+    using memory::MemoryReclaim;
+
+    if ( !is_active() )
+        return;
+
+    mem_stats.flows_held = MemoryReclaim::get_held(Consumer::FLOWS);
+    mem_stats.flow_data_held = MemoryReclaim::get_held(Consumer::FLOW_DATA);
+    mem_stats.tcp_segments_held = MemoryReclaim::get_held(Consumer::TCP_SEGMENTS);
+    mem_stats.file_cache_held = MemoryReclaim::get_held(Consumer::FILE_CACHE);
+    mem_stats.host_cache_held = MemoryReclaim::get_held(Consumer::HOST_CACHE);
+}
+
+
+// -----------------------------------------------------------------------------
+// memory arena module
+// -----------------------------------------------------------------------------
+
+#define a_name "memory_arena"
+#define a_help \
+    "per subsystem memory attribution"
+
+#define ARENA_PEGS(name, what) \
+    { CountType::NOW, name "_bytes", "memory currently held by " what }, \
+    { CountType::MAX, name "_max_bytes", "most memory held by " what }, \
+    { CountType::SUM, name "_allocs", "allocations by " what }, \
+    { CountType::MAX, name "_peak_allocs", "most allocations by " what " for one packet" }
+
+const PegInfo arena_pegs[] =
+{
+    ARENA_PEGS("stream_tcp", "tcp sessions and reassembly segments"),
+    ARENA_PEGS("defrag", "ip fragments"),
+    ARENA_PEGS("http_inspect", "http_inspect and http2_inspect sessions"),
+    ARENA_PEGS("appid", "appid sessions"),
+    ARENA_PEGS("file_api", "file and mime processing of flows"),
+    ARENA_PEGS("detection", "detection contexts"),
+    { CountType::MAX, "host_cache_bytes", "memory currently held by the host cache" },
+    { CountType::MAX, "host_cache_max_bytes", "most memory held by the host cache" },
+    { CountType::MAX, "host_cache_allocs", "allocations by the host cache" },
+    { CountType::END, nullptr, nullptr }
+};
+
+// the host cache is shared so its counts are the same on every thread and
+// it is not tracked per packet
+struct HostCacheCounts
+{
+    PegCount bytes;
+    PegCount max_bytes;
+    PegCount allocs;
+};
+
+// must match arena_pegs
+struct ArenaCounts
+{
+    memory::ArenaStats stream_tcp;
+    memory::ArenaStats defrag;
+    memory::ArenaStats http_inspect;
+    memory::ArenaStats appid;
+    memory::ArenaStats file_api;
+    memory::ArenaStats detection;
+    HostCacheCounts host_cache;
+};
+
+static_assert(sizeof(ArenaCounts) == (array_size(arena_pegs) - 1) * sizeof(PegCount),
+    "a count for each arena peg");
+
+static THREAD_LOCAL ArenaCounts arena_counts;
+
+static const memory::ArenaStats& get_arena(memory::Arena a)
+{ return memory::MemoryArena::get_stats()[(unsigned)a - 1]; }
+
+MemoryArenaModule::MemoryArenaModule() : Module(a_name, a_help)
+{ }
+
+const PegInfo* MemoryArenaModule::get_pegs() const
+{ return arena_pegs; }
+
+PegCount* MemoryArenaModule::get_counts() const
+{ return (PegCount*)&arena_counts; }
+
+void MemoryArenaModule::prep_counts()
+{
+    using memory::Arena;
+
+    memory::MemoryArena::refresh();
+
+    arena_counts.stream_tcp = get_arena(Arena::STREAM_TCP);
+    arena_counts.defrag = get_arena(Arena::DEFRAG);
+    arena_counts.http_inspect = get_arena(Arena::HTTP_INSPECT);
+    arena_counts.appid = get_arena(Arena::APPID);
+    arena_counts.file_api = get_arena(Arena::FILE_API);
+    arena_counts.detection = get_arena(Arena::DETECTION);
+
+    const memory::ArenaStats& hc = get_arena(Arena::HOST_CACHE);
+    arena_counts.host_cache = { hc.bytes, hc.max_bytes, hc.allocs };
+}
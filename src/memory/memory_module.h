@@ -33,6 +33,13 @@ struct MemoryCounts
     PegCount reap_failures;
     PegCount max_in_use;
     PegCount total_fudge;
+    PegCount reclaim_rounds;
+    PegCount reclaimed;
+    PegCount flows_held;
+    PegCount flow_data_held;
+    PegCount tcp_segments_held;
+    PegCount file_cache_held;
+    PegCount host_cache_held;
 };
 
 extern THREAD_LOCAL MemoryCounts mem_stats;
@@ -44,6 +51,10 @@ public:
 
     const PegInfo* get_pegs() const override;
     PegCount* get_counts() const override;
+    void prep_counts() override;
+
+    bool counts_need_prep() const override
+    { return true; }
 
     bool set(const char*, snort::Value&, snort::SnortConfig*) override;
     bool end(const char*, int, snort::SnortConfig*) override;
@@ -57,5 +68,22 @@ private:
     static bool configured;
 };
 
+// always on, no configuration
+class MemoryArenaModule : public snort::Module
+{
+public:
+    MemoryArenaModule();
+
+    const PegInfo* get_pegs() const override;
+    PegCount* get_counts() const override;
+    void prep_counts() override;
+
+    bool counts_need_prep() const override
+    { return true; }
+
+    Usage get_usage() const override
+    { return GLOBAL; }
+};
+
 #endif
 
@@ -0,0 +1,170 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// memory_reclaim.cc - consumers that can give memory back under pressure
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "memory_reclaim.h"
+
+#include <algorithm>
+#include <cassert>
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace memory;
+
+Reclaimer MemoryReclaim::reclaimers[(unsigned)Consumer::MAX];
+Consumer MemoryReclaim::order[(unsigned)Consumer::MAX];
+unsigned MemoryReclaim::num_steppers = 0;
+
+// adding the same consumer again replaces it so this is safe on reload
+void MemoryReclaim::add(Consumer c, const Reclaimer& r)
+{
+    assert(c != Consumer::NONE and c != Consumer::MAX);
+    assert(r.cost);
+
+    reclaimers[(unsigned)c] = r;
+    sort();
+}
+
+void MemoryReclaim::clear()
+{
+    for ( auto& r : reclaimers )
+        r = Reclaimer();
+
+    num_steppers = 0;
+}
+
+// most bytes per unit of work first
+void MemoryReclaim::sort()
+{
+    num_steppers = 0;
+
+    for ( unsigned i = 0; i < (unsigned)Consumer::MAX; ++i )
+    {
+        if ( reclaimers[i].reclaim )
+            order[num_steppers++] = (Consumer)i;
+    }
+
+    std::stable_sort(order, order + num_steppers, [](Consumer a, Consumer b)
+    {
+        const Reclaimer& ra = reclaimers[(unsigned)a];
+        const Reclaimer& rb = reclaimers[(unsigned)b];
+        return (uint64_t)ra.benefit * rb.cost > (uint64_t)rb.benefit * ra.cost;
+    });
+}
+
+size_t MemoryReclaim::get_held(Consumer c)
+{
+    const Reclaimer& r = reclaimers[(unsigned)c];
+    return r.held ? r.held() : 0;
+}
+
+bool MemoryReclaim::step(bool over_cap)
+{
+    for ( unsigned i = 0; i < num_steppers; ++i )
+    {
+        if ( reclaimers[(unsigned)order[i]].reclaim(over_cap) )
+            return true;
+    }
+    return false;
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+static unsigned s_cheap = 0;
+static unsigned s_dear = 0;
+
+static bool cheap_step(bool)
+{
+    if ( !s_cheap )
+        return false;
+
+    --s_cheap;
+    return true;
+}
+
+static bool dear_step(bool over_cap)
+{
+    if ( !over_cap or !s_dear )
+        return false;
+
+    --s_dear;
+    return true;
+}
+
+static size_t shared_held()
+{ return 12345; }
+
+TEST_CASE("reclaim order", "[memory_reclaim]")
+{
+    Reclaimer dear;
+    dear.reclaim = dear_step;
+    dear.cost = 8;
+    dear.benefit = 16384;
+
+    Reclaimer cheap;
+    cheap.reclaim = cheap_step;
+    cheap.cost = 1;
+    cheap.benefit = 4096;
+
+    MemoryReclaim::add(Consumer::FLOWS, dear);
+    MemoryReclaim::add(Consumer::FLOW_DATA, cheap);
+
+    s_cheap = 2;
+    s_dear = 1;
+
+    // cheap first until it runs dry
+    CHECK(MemoryReclaim::step(false));
+    CHECK(MemoryReclaim::step(false));
+    CHECK(s_cheap == 0);
+    CHECK(s_dear == 1);
+
+    CHECK_FALSE(MemoryReclaim::step(false));
+    CHECK(MemoryReclaim::step(true));
+    CHECK(s_dear == 0);
+    CHECK_FALSE(MemoryReclaim::step(true));
+
+    MemoryReclaim::clear();
+    s_cheap = 1;
+    CHECK_FALSE(MemoryReclaim::step(true));
+}
+
+TEST_CASE("reclaim held", "[memory_reclaim]")
+{
+    Reclaimer host;
+    host.held = shared_held;
+    MemoryReclaim::add(Consumer::HOST_CACHE, host);
+
+    CHECK(MemoryReclaim::get_held(Consumer::HOST_CACHE) == 12345);
+    CHECK(MemoryReclaim::get_held(Consumer::FILE_CACHE) == 0);
+
+    MemoryReclaim::clear();
+}
+
+#endif
+
@@ -0,0 +1,88 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// memory_reclaim.h - consumers that can give memory back under pressure
+
+#ifndef MEMORY_RECLAIM_H
+#define MEMORY_RECLAIM_H
+
+// the large consumers of packet thread memory register here so MemoryCap
+// can see what each holds and ask them for space when needed.  each one
+// that can free memory provides a step function that does a bounded unit
+// of work, eg prune one flow.  steps are taken from the consumer with the
+// best benefit for the cost first, moving on when one has nothing left.
+//
+// each also reports the bytes it holds with a callback.  shared caches
+// report the same total on every thread.
+
+#include <cstddef>
+#include <cstdint>
+
+#include "main/snort_types.h"
+
+namespace memory
+{
+enum class Consumer : uint8_t
+{
+    NONE,
+    FLOWS,
+    FLOW_DATA,
+    TCP_SEGMENTS,
+    FILE_CACHE,
+    HOST_CACHE,
+    MAX
+};
+
+struct Reclaimer
+{
+    // do one step of work; over_cap is true if the thread is at its cap and
+    // must have space now.  returns false if there was nothing to free.
+    bool (*reclaim)(bool over_cap) = nullptr;
+
+    // bytes currently held
+    size_t (*held)() = nullptr;
+
+    unsigned cost = 1;   // relative work per step
+    size_t benefit = 0;  // expected bytes freed per step
+};
+
+class SO_PUBLIC MemoryReclaim
+{
+public:
+    // call from the main thread before the packet threads start
+    static void add(Consumer, const Reclaimer&);
+    static void clear();
+
+    static size_t get_held(Consumer);
+
+    // take one step from the best consumer that can give something;
+    // returns false if none could
+    static bool step(bool over_cap);
+
+private:
+    static void sort();
+
+    static Reclaimer reclaimers[(unsigned)Consumer::MAX];
+    static Consumer order[(unsigned)Consumer::MAX];
+    static unsigned num_steppers;
+};
+
+} // namespace memory
+
+#endif
+
@@ -0,0 +1,423 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// slab_allocator.cc - per thread size class allocator for packet buffers
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "slab_allocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "utils/util.h"
+
+#include "memory_cap.h"
+
+#ifdef UNIT_TEST
+#include "catch/snort_catch.h"
+#endif
+
+using namespace memory;
+
+// each block starts with a header so it can be freed without knowing its
+// allocator.  free blocks reuse the slab pointer for the free list.
+struct BlockHeader
+{
+    union
+    {
+        Slab* slab;        // nullptr if from the heap
+        BlockHeader* next;
+    };
+    uint32_t len;          // requested
+    Arena arena;           // for heap blocks
+};
+
+namespace memory
+{
+struct Slab
+{
+    SlabAllocator* owner;  // nullptr once orphaned
+    Slab* prev;            // slabs of the class with blocks to give
+    Slab* next;
+    Slab* all_prev;        // all slabs of the allocator
+    Slab* all_next;
+
+    BlockHeader* free_list;
+    size_t size;           // block size
+    size_t bytes;          // total allocation
+    unsigned cls;
+    unsigned used;
+    unsigned carved;       // blocks are carved on demand
+    Arena arena;
+    bool linked;
+
+    uint8_t* block(unsigned i)
+    { return (uint8_t*)this + header_size() + i * size; }
+
+    static constexpr size_t header_size()
+    { return (sizeof(Slab) + 15) & ~(size_t)15; }
+};
+}
+
+static constexpr size_t slab_target = 64 * 1024;
+static constexpr unsigned min_blocks = 8;
+
+static_assert(sizeof(BlockHeader) % 16 == 0, "blocks must stay 16 byte aligned");
+
+//-------------------------------------------------------------------------
+// allocator
+//-------------------------------------------------------------------------
+
+SlabAllocator::SlabAllocator(const std::vector<size_t>& sizes, SlabStats& ss, Arena a) :
+    stats(ss), arena(a)
+{
+    for ( auto n : sizes )
+    {
+        SizeClass c;
+        c.size = (n + sizeof(BlockHeader) + 15) & ~(size_t)15;
+        c.per_slab = std::max(min_blocks, (unsigned)(slab_target / c.size));
+        c.empty = 0;
+        c.avail = nullptr;
+
+        assert(classes.empty() or c.size > classes.back().size);
+        classes.emplace_back(c);
+    }
+}
+
+SlabAllocator::~SlabAllocator()
+{
+    while ( slabs )
+    {
+        Slab* s = slabs;
+        slabs = s->all_next;
+
+        if ( s->used )
+            s->owner = nullptr;
+        else
+            snort_free(s);
+    }
+    stats.bytes = 0;
+    stats.fragmentation = 0;
+}
+
+size_t SlabAllocator::get_max_size() const
+{
+    return classes.empty() ? 0 : classes.back().size - sizeof(BlockHeader);
+}
+
+void SlabAllocator::link(Slab* s)
+{
+    SizeClass& c = classes[s->cls];
+    s->prev = nullptr;
+    s->next = c.avail;
+
+    if ( c.avail )
+        c.avail->prev = s;
+
+    c.avail = s;
+    s->linked = true;
+}
+
+void SlabAllocator::unlink(Slab* s)
+{
+    SizeClass& c = classes[s->cls];
+
+    if ( s->prev )
+        s->prev->next = s->next;
+    else
+        c.avail = s->next;
+
+    if ( s->next )
+        s->next->prev = s->prev;
+
+    s->linked = false;
+}
+
+Slab* SlabAllocator::new_slab(unsigned cls)
+{
+    SizeClass& c = classes[cls];
+    size_t bytes = Slab::header_size() + c.per_slab * c.size;
+    Slab* s = (Slab*)snort_alloc(bytes);
+
+    s->owner = this;
+    s->free_list = nullptr;
+    s->size = c.size;
+    s->bytes = bytes;
+    s->cls = cls;
+    s->used = 0;
+    s->carved = 0;
+    s->arena = arena;
+
+    s->all_prev = nullptr;
+    s->all_next = slabs;
+
+    if ( slabs )
+        slabs->all_prev = s;
+
+    slabs = s;
+
+    link(s);
+    c.empty++;
+
+    stats.bytes += bytes;
+    stats.fragmentation += bytes;
+    return s;
+}
+
+void SlabAllocator::free_slab(Slab* s)
+{
+    if ( s->linked )
+        unlink(s);
+
+    if ( s->all_prev )
+        s->all_prev->all_next = s->all_next;
+    else
+        slabs = s->all_next;
+
+    if ( s->all_next )
+        s->all_next->all_prev = s->all_prev;
+
+    stats.bytes -= s->bytes;
+    stats.fragmentation -= s->bytes;
+    snort_free(s);
+}
+
+void* SlabAllocator::allocate(size_t n)
+{
+    size_t need = n + sizeof(BlockHeader);
+    unsigned cls = 0;
+
+    while ( cls < classes.size() and classes[cls].size < need )
+        ++cls;
+
+    if ( cls == classes.size() )
+    {
+        MemoryCap::update_allocations(need);
+        MemoryArena::charge(arena, need);
+        stats.misses++;
+
+        BlockHeader* b = (BlockHeader*)snort_alloc(need);
+        b->slab = nullptr;
+        b->len = n;
+        b->arena = arena;
+        return b + 1;
+    }
+
+    SizeClass& c = classes[cls];
+
+    // charge first since pruning may free blocks back to this class
+    MemoryCap::update_allocations(c.size);
+    MemoryArena::charge(arena, c.size);
+
+    Slab* s = c.avail;
+
+    if ( s )
+        stats.hits++;
+    else
+    {
+        s = new_slab(cls);
+        stats.misses++;
+    }
+
+    BlockHeader* b;
+
+    if ( s->free_list )
+    {
+        b = s->free_list;
+        s->free_list = b->next;
+    }
+    else
+        b = (BlockHeader*)s->block(s->carved++);
+
+    if ( !s->used++ )
+        c.empty--;
+
+    if ( !s->free_list and s->carved == c.per_slab )
+        unlink(s);
+
+    b->slab = s;
+    b->len = n;
+
+    stats.fragmentation -= n;
+    return b + 1;
+}
+
+void SlabAllocator::release(Slab* s, void* p, size_t len)
+{
+    SizeClass& c = classes[s->cls];
+    BlockHeader* b = (BlockHeader*)p;
+
+    b->next = s->free_list;
+    s->free_list = b;
+    stats.fragmentation += len;
+
+    if ( !s->linked )
+        link(s);
+
+    if ( --s->used )
+        return;
+
+    // keep one empty slab per class to absorb bursts
+    if ( c.empty )
+        free_slab(s);
+    else
+        c.empty++;
+}
+
+void SlabAllocator::deallocate(void* p)
+{
+    if ( !p )
+        return;
+
+    BlockHeader* b = (BlockHeader*)p - 1;
+    Slab* s = b->slab;
+
+    if ( !s )
+    {
+        MemoryCap::update_deallocations(b->len + sizeof(*b));
+        MemoryArena::credit(b->arena, b->len + sizeof(*b));
+        snort_free(b);
+        return;
+    }
+
+    MemoryCap::update_deallocations(s->size);
+    MemoryArena::credit(s->arena, s->size);
+
+    if ( s->owner )
+        s->owner->release(s, b, b->len);
+
+    else if ( !--s->used )
+        snort_free(s);
+}
+
+//-------------------------------------------------------------------------
+// unit tests
+//-------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+TEST_CASE("slab reuse", "[slab_allocator]")
+{
+    SlabStats stats = { };
+    SlabAllocator sa({ 64, 1500 }, stats);
+
+    void* a = sa.allocate(10);
+    CHECK(stats.misses == 1);
+    CHECK(stats.hits == 0);
+
+    void* b = sa.allocate(64);
+    CHECK(stats.hits == 1);
+    CHECK(a != b);
+    CHECK(((uintptr_t)a & 15) == 0);
+    CHECK(((uintptr_t)b & 15) == 0);
+
+    memset(a, 0xa5, 10);
+    memset(b, 0x5a, 64);
+
+    SlabAllocator::deallocate(a);
+    void* c = sa.allocate(20);
+    CHECK(c == a);
+    CHECK(stats.hits == 2);
+
+    // a different class needs its own slab
+    void* d = sa.allocate(1000);
+    CHECK(stats.misses == 2);
+
+    SlabAllocator::deallocate(b);
+    SlabAllocator::deallocate(c);
+    SlabAllocator::deallocate(d);
+
+    // one empty slab per class is kept
+    CHECK(stats.bytes > 0);
+    CHECK(stats.fragmentation == stats.bytes);
+}
+
+TEST_CASE("slab oversize", "[slab_allocator]")
+{
+    SlabStats stats = { };
+    SlabAllocator sa({ 128 }, stats);
+
+    CHECK(sa.get_max_size() >= 128);
+
+    void* p = sa.allocate(4096);
+    CHECK(stats.misses == 1);
+    CHECK(stats.bytes == 0);
+
+    memset(p, 0, 4096);
+    SlabAllocator::deallocate(p);
+}
+
+TEST_CASE("slab release", "[slab_allocator]")
+{
+    SlabStats stats = { };
+    SlabAllocator sa({ 256 }, stats);
+    std::vector<void*> v;
+
+    // several slabs worth
+    for ( unsigned i = 0; i < 2000; ++i )
+        v.emplace_back(sa.allocate(200));
+
+    PegCount peak = stats.bytes;
+    CHECK(stats.fragmentation < peak);
+
+    for ( auto p : v )
+        SlabAllocator::deallocate(p);
+
+    CHECK(stats.bytes < peak);
+    CHECK(stats.bytes > 0);
+    CHECK(stats.fragmentation == stats.bytes);
+}
+
+TEST_CASE("slab arena", "[slab_allocator]")
+{
+    SlabStats stats = { };
+    SlabAllocator sa({ 64 }, stats, Arena::DEFRAG);
+    ArenaStats& as = MemoryArena::get_stats()[(unsigned)Arena::DEFRAG - 1];
+    as = { };
+
+    void* a = sa.allocate(8);
+    void* b = sa.allocate(1000);
+    CHECK(as.allocs == 2);
+    CHECK(as.bytes > 1000);
+
+    SlabAllocator::deallocate(a);
+    SlabAllocator::deallocate(b);
+    CHECK(as.bytes == 0);
+    CHECK(as.max_bytes > 1000);
+}
+
+TEST_CASE("slab orphans", "[slab_allocator]")
+{
+    SlabStats stats = { };
+    auto sa = new SlabAllocator({ 64 }, stats);
+
+    void* a = sa->allocate(8);
+    void* b = sa->allocate(8);
+    delete sa;
+
+    // still usable and freed with the last block
+    memset(a, 0, 8);
+    SlabAllocator::deallocate(a);
+    SlabAllocator::deallocate(b);
+}
+
+#endif
+
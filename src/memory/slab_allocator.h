@@ -0,0 +1,106 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// slab_allocator.h - per thread size class allocator for packet buffers
+
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+// SlabAllocator serves the many short lived, variable size buffers used
+// for reassembly.  requests are rounded up to one of a few size classes
+// and carved from slabs holding many blocks of the same class.  freed
+// blocks go back on their slab's free list so the heap is only touched
+// when a class runs out of blocks.  requests larger than the largest class
+// go straight to the heap.
+//
+// each block is charged to MemoryCap and the allocator's arena at its class
+// size so pruning works as before.  a slab goes back to the heap when all
+// of its blocks are free unless it is the only empty slab of its class.
+//
+// blocks must be freed on the thread that allocated them.  slabs that are
+// still in use when the allocator is deleted are released with their last
+// block.
+
+#include <cstddef>
+#include <vector>
+
+#include "framework/counts.h"
+#include "main/snort_types.h"
+#include "memory/memory_arena.h"
+
+namespace memory
+{
+struct SlabStats
+{
+    PegCount hits;           // allocations from a free block
+    PegCount misses;         // allocations that needed a new slab or the heap
+    PegCount bytes;          // held in slabs
+    PegCount fragmentation;  // bytes held in slabs not requested by live blocks
+};
+
+// add to the peg list where SlabStats is in the stats struct
+#define SLAB_PEGS(module) \
+    { CountType::SUM, "slab_hits", module " buffers allocated from a slab free list" }, \
+    { CountType::SUM, "slab_misses", module " buffers that needed a new slab or the heap" }, \
+    { CountType::NOW, "slab_bytes", module " memory currently held in slabs" }, \
+    { CountType::NOW, "slab_fragmentation", module " slab memory not used by live buffers" }
+
+struct Slab;
+
+class SO_PUBLIC SlabAllocator
+{
+public:
+    // block sizes must be ascending
+    SlabAllocator(const std::vector<size_t>& sizes, SlabStats&, Arena = Arena::NONE);
+    ~SlabAllocator();
+
+    SlabAllocator(const SlabAllocator&) = delete;
+    SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+    void* allocate(size_t);
+    static void deallocate(void*);
+
+    // largest request that fits in a slab block
+    size_t get_max_size() const;
+
+private:
+    struct SizeClass
+    {
+        size_t size;          // block size including the header
+        unsigned per_slab;
+        unsigned empty;       // slabs on the avail list with no live blocks
+        Slab* avail;          // slabs with blocks to give
+    };
+
+    Slab* new_slab(unsigned cls);
+    void free_slab(Slab*);
+    void release(Slab*, void*, size_t);
+
+    void unlink(Slab*);
+    void link(Slab*);
+
+private:
+    std::vector<SizeClass> classes;
+    Slab* slabs = nullptr;  // all of them for cleanup
+    SlabStats& stats;
+    Arena arena;
+};
+}
+
+#endif
+
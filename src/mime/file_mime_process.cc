@@ -30,6 +30,7 @@
 #include "file_api/file_flows.h"
 #include "hash/hash_key_operations.h"
 #include "log/messages.h"
+#include "memory/memory_arena.h"
 #include "memory/memory_cap.h"
 #include "search_engines/search_tool.h"
 #include "utils/util_cstring.h"
@@ -816,11 +817,13 @@ MimeSession::MimeSession(Packet* p, DecodeConfig* dconf, MailLogConfig* lconf, u
     p->flow->stash->store(STASH_EXTRADATA_MIME, log_state);
     reset_mime_paf_state(&mime_boundary);
     memory::MemoryCap::update_allocations(sizeof(*this));
+    memory::MemoryArena::charge(memory::Arena::FILE_API, sizeof(*this));
 }
 
 MimeSession::~MimeSession()
 {
     memory::MemoryCap::update_deallocations(sizeof(*this));
+    memory::MemoryArena::credit(memory::Arena::FILE_API, sizeof(*this));
     if ( decode_state )
         delete(decode_state);
 }
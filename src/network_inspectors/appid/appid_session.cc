@@ -132,6 +132,7 @@ AppIdSession::AppIdSession(IpProtocol proto, const SfIp* ip, uint16_t port,
         odp_ctxt_version(odp_ctxt.get_version()),
         tp_appid_ctxt(pkt_thread_tp_appid_ctxt)
 {
+    set_arena(memory::Arena::APPID);
     appid_stats.total_sessions++;
 }
 
@@ -224,7 +225,8 @@ AppIdSession* AppIdSession::create_future_session(const Packet* ctrlPkt, const S
     char src_ip[INET6_ADDRSTRLEN];
     char dst_ip[INET6_ADDRSTRLEN];
 
-    AppIdInspector* inspector = (AppIdInspector*)ctrlPkt->flow->flow_data->get_handler();
+    FlowData* fd = ctrlPkt->flow->get_flow_data(AppIdSession::inspector_id);
+    AppIdInspector* inspector = fd ? (AppIdInspector*)fd->get_handler() : nullptr;
     if ((inspector == nullptr) || strcmp(inspector->get_name(), MOD_NAME))
         inspector = (AppIdInspector*)InspectorManager::get_inspector(MOD_NAME, true);
 
@@ -25,7 +25,8 @@
 
 #include "lua_detector_api.h"
 #include <lua.hpp>
-#include <pcre.h>
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
 #include <unordered_map>
 
 #include "log/messages.h"
@@ -56,7 +57,7 @@
 using namespace snort;
 using namespace std;
 
-#define OVECCOUNT 30    /* should be a multiple of 3 */
+#define OVECCOUNT 10    /* number of offset pairs */
 
 enum LuaLogLevels
 {
@@ -660,51 +661,58 @@ static int detector_get_pcre_groups(lua_State* L)
     // Verify detector user data and that we are in packet context
     LuaStateDescriptor* lsd = ud->validate_lua_state(true);
 
-    int ovector[OVECCOUNT];
-    const char* error;
-    int erroffset;
+    int errcode;
+    PCRE2_SIZE erroffset;
 
     const char* pattern = lua_tostring(L, 2);
     unsigned int offset = lua_tonumber(L, 3);     /*offset can be zero, no check necessary. */
 
     /*compile the regular expression pattern, and handle errors */
-    pcre* re = pcre_compile(pattern,  // the pattern
-        PCRE_DOTALL,                  // default options - dot matches all inc \n
-        &error,                       // for error message
+    pcre2_code* re = pcre2_compile((PCRE2_SPTR)pattern, // the pattern
+        PCRE2_ZERO_TERMINATED,        // pattern is nul terminated
+        PCRE2_DOTALL,                 // default options - dot matches all inc \n
+        &errcode,                     // for error code
         &erroffset,                   // for error offset
-        nullptr);                     // use default character tables
+        nullptr);                     // use default compile context
 
     if (re == nullptr)
     {
-        ErrorMessage("PCRE compilation failed at offset %d: %s\n", erroffset, error);
+        PCRE2_UCHAR error[128];
+        pcre2_get_error_message(errcode, error, sizeof(error));
+        ErrorMessage("PCRE compilation failed at offset %zu: %s\n", erroffset, (char*)error);
         return 0;
     }
 
+    pcre2_match_data* md = pcre2_match_data_create(OVECCOUNT, nullptr);
+
     /*pattern match against the subject string. */
-    int rc = pcre_exec(re,            // compiled pattern
-        nullptr,                      // no extra data
-        (const char*)lsd->ldp.data,   // subject string
+    int rc = pcre2_match(re,          // compiled pattern
+        (PCRE2_SPTR)lsd->ldp.data,    // subject string
         lsd->ldp.size,                // length of the subject
         offset,                       // offset 0
         0,                            // default options
-        ovector,                      // output vector for substring information
-        OVECCOUNT);                   // number of elements in the output vector
+        md,                           // match data for substring information
+        nullptr);                     // default match context
 
     if (rc >= 0)
     {
         if (rc == 0)
         {
             /*overflow of matches */
-            rc = OVECCOUNT / 3;
+            rc = OVECCOUNT;
             WarningMessage("ovector only has room for %d captured substrings\n", rc - 1);
         }
 
         if (!lua_checkstack(L, rc))
         {
             WarningMessage("Cannot grow Lua stack by %d slots to hold PCRE matches\n", rc);
+            pcre2_match_data_free(md);
+            pcre2_code_free(re);
             return 0;
         }
 
+        PCRE2_SIZE* ovector = pcre2_get_ovector_pointer(md);
+
         for (int i = 0; i < rc; i++)
         {
             lua_pushlstring(L, (const char*)lsd->ldp.data + ovector[2*i], ovector[2*i+1] -
@@ -714,12 +722,13 @@ static int detector_get_pcre_groups(lua_State* L)
     else
     {
         // log errors except no matches
-        if (rc != PCRE_ERROR_NOMATCH)
+        if (rc != PCRE2_ERROR_NOMATCH)
             WarningMessage("PCRE regular expression group match failed. rc: %d\n", rc);
         rc = 0;
     }
 
-    pcre_free(re);
+    pcre2_match_data_free(md);
+    pcre2_code_free(re);
     return rc;
 }
 
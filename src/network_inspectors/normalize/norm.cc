@@ -23,6 +23,7 @@
 
 #include "norm.h"
 
+#include "codecs/ip/checksum.h"
 #include "detection/ips_context.h"
 #include "main/snort_config.h"
 #include "packet_io/sfdaq.h"
@@ -125,7 +126,7 @@ int Norm_Packet(NormalizerConfig* c, Packet* p)
         p->packet_flags |= PKT_MODIFIED;
         return 1;
     }
-    if ( p->packet_flags & (PKT_RESIZED|PKT_MODIFIED) )
+    if ( p->packet_flags & (PKT_RESIZED|PKT_MODIFIED|PKT_REWRITTEN) )
     {
         return 1;
     }
@@ -140,7 +141,9 @@ int Norm_Packet(NormalizerConfig* c, Packet* p)
 //
 // also note that checksums are not calculated here.  they are only
 // calculated once after all normalizations are done (here, stream)
-// and any replacements are made.
+// and any replacements are made.  the exception is header fields that
+// are rewritten in place; those update the checksum incrementally so
+// that a packet with only such rewrites needs no update when encoded.
 //-----------------------------------------------------------------------
 
 #if 0
@@ -161,6 +164,55 @@ static int Norm_Eth(Packet* p, uint8_t layer, int changes)
 // ether header + min payload (excludes FCS, which makes it 64 total)
 #define ETH_MIN_LEN 60
 
+// a rewrite can only be done in place if the layer is not carried in
+// another layer that is checksummed over its payload
+static inline bool in_place(const Packet* p, uint8_t layer)
+{
+    for ( uint8_t i = 0; i < layer; ++i )
+    {
+        switch ( p->layers[i].prot_id )
+        {
+        case ProtocolId::ICMPV4:
+        case ProtocolId::ICMPV6:
+        case ProtocolId::GRE:
+        case ProtocolId::TCP:
+        case ProtocolId::UDP:
+            return false;
+
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+// returns the change count; rewrites are not changes
+static inline int rewritten(Packet* p, uint8_t layer)
+{
+    if ( !in_place(p, layer) )
+        return 1;
+
+    p->packet_flags |= PKT_REWRITTEN;
+    return 0;
+}
+
+static inline int rewritten(
+    Packet* p, uint8_t layer, uint16_t& csum, uint16_t old_word, uint16_t new_word)
+{
+    if ( rewritten(p, layer) )
+        return 1;
+
+    csum = checksum::cksum_update(csum, old_word, new_word);
+    return 0;
+}
+
+static inline uint16_t get_word(const void* h, unsigned off)
+{
+    uint16_t w;
+    memcpy(&w, (const uint8_t*)h + off, sizeof(w));
+    return w;
+}
+
 static inline NormMode get_norm_mode(const Packet * const p)
 {
     NormMode mode = NORM_MODE_ON;
@@ -206,8 +258,9 @@ static int Norm_IP4(
         {
             if ( mode == NORM_MODE_ON )
             {
+                uint16_t old_word = get_word(h, 0);
                 h->ip_tos = 0;
-                changes++;
+                changes += rewritten(p, layer, h->ip_csum, old_word, get_word(h, 0));
             }
             normStats[PC_IP4_TOS][mode]++;
         }
@@ -223,10 +276,8 @@ static int Norm_IP4(
         if ( fragbits & IP4_FLAG_DF )
         {
             if ( mode == NORM_MODE_ON )
-            {
                 fragbits &= ~IP4_FLAG_DF;
-                changes++;
-            }
+
             normStats[PC_IP4_DF][mode]++;
         }
     }
@@ -235,16 +286,16 @@ static int Norm_IP4(
         if ( fragbits & IP4_FLAG_RF )
         {
             if ( mode == NORM_MODE_ON )
-            {
                 fragbits &= ~IP4_FLAG_RF;
-                changes++;
-            }
+
             normStats[PC_IP4_RF][mode]++;
         }
     }
     if ( fragbits != origbits )
     {
+        uint16_t old_word = h->ip_off;
         h->ip_off = htons(fragbits);
+        changes += rewritten(p, layer, h->ip_csum, old_word, h->ip_off);
     }
     if ( Norm_IsEnabled(c, NORM_IP4_TTL) )
     {
@@ -252,9 +303,10 @@ static int Norm_IP4(
         {
             if ( mode == NORM_MODE_ON )
             {
+                uint16_t old_word = get_word(h, 8);
                 h->ip_ttl = p->context->conf->new_ttl();
                 p->ptrs.decode_flags &= ~DECODE_ERR_BAD_TTL;
-                changes++;
+                changes += rewritten(p, layer, h->ip_csum, old_word, get_word(h, 8));
             }
             normStats[PC_IP4_TTL][mode]++;
         }
@@ -287,8 +339,9 @@ static int Norm_ICMP4(
     {
         if ( mode == NORM_MODE_ON )
         {
+            uint16_t old_word = get_word(h, 0);
             h->code = icmp::IcmpCode::ECHO_CODE;
-            changes++;
+            changes += rewritten(p, layer, h->csum, old_word, get_word(h, 0));
         }
         normStats[PC_ICMP4_ECHO][mode]++;
     }
@@ -309,11 +362,12 @@ static int Norm_IP6(
         {
             const NormMode mode = get_norm_mode(p);
 
+            // the hop limit is not in any checksum
             if ( mode == NORM_MODE_ON )
             {
                 h->ip6_hoplim = p->context->conf->new_ttl();
                 p->ptrs.decode_flags &= ~DECODE_ERR_BAD_TTL;
-                changes++;
+                changes += rewritten(p, layer);
             }
             normStats[PC_IP6_TTL][mode]++;
         }
@@ -336,8 +390,9 @@ static int Norm_ICMP6(
 
         if ( mode == NORM_MODE_ON )
         {
+            uint16_t old_word = get_word(h, 0);
             h->code = static_cast<icmp::IcmpCode>(0);
-            changes++;
+            changes += rewritten(p, layer, h->csum, old_word, get_word(h, 0));
         }
         normStats[PC_ICMP6_ECHO][mode]++;
     }
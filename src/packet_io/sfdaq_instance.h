@@ -56,6 +56,13 @@ public:
             return daq_msgs[curr_batch_idx++];
         return nullptr;
     }
+    // look ahead at the nth message that next_message() has yet to return
+    DAQ_Msg_h peek_message(unsigned n) const
+    {
+        if (curr_batch_idx + n < curr_batch_size)
+            return daq_msgs[curr_batch_idx + n];
+        return nullptr;
+    }
     int finalize_message(DAQ_Msg_h msg, DAQ_Verdict verdict);
     const char* get_error();
 
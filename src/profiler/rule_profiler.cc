@@ -25,6 +25,7 @@
 #include "rule_profiler.h"
 
 #include <algorithm>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <sstream>
@@ -295,6 +296,125 @@ static void print_entries(std::vector<View>& entries, ProfilerSorter<View>& sort
 
 }
 
+//-------------------------------------------------------------------------
+// pattern stats
+//-------------------------------------------------------------------------
+
+namespace pattern_stats
+{
+
+struct Source
+{
+    const char* name;
+    RulePatternGetter get;
+    RulePatternReset reset;
+};
+
+static std::vector<Source> sources;
+
+static const StatsTable::Field fields[] =
+{
+    { "#", 5, '\0', 0, std::ios_base::left },
+    { "checks", 10, '\0', 0, std::ios_base::fmtflags() },
+    { "matches", 8, '\0', 0, std::ios_base::fmtflags() },
+    { "time (us)", 10, '\0', 0, std::ios_base::fmtflags() },
+    { "avg/check", 10, '\0', 1, std::ios_base::fmtflags() },
+    { "engine", 8, '\0', 0, std::ios_base::fmtflags() },
+    { "", 2, '\0', 0, std::ios_base::fmtflags() },
+    { "pattern", 0, '\0', 0, std::ios_base::left },
+    { nullptr, 0, '\0', 0, std::ios_base::fmtflags() }
+};
+
+static void print_single_entry(const RulePatternStats& ps, unsigned n)
+{
+    hr_duration avg = ps.checks ? hr_duration(ps.elapsed / ps.checks) : CLOCK_ZERO;
+    std::ostringstream ss;
+
+    {
+        StatsTable table(fields, ss);
+
+        table << StatsTable::ROW;
+
+        table << n;
+        table << ps.checks;
+        table << ps.matches;
+        table << clock_usecs(TO_USECS(ps.elapsed));
+        table << clock_usecs(TO_USECS(avg));
+        table << ps.engine;
+        table << "";
+        table << ps.pattern;
+    }
+
+    LogMessage("%s", ss.str().c_str());
+}
+
+// always sorted by total time since that is what points to a bad pattern
+static void print_entries(const Source& src, unsigned count)
+{
+    std::vector<RulePatternStats> entries;
+    src.get(entries);
+
+    auto unused = [](const RulePatternStats& ps) { return !ps.checks; };
+    entries.erase(std::remove_if(entries.begin(), entries.end(), unused), entries.end());
+
+    if ( entries.empty() )
+        return;
+
+    std::ostringstream ss;
+
+    {
+        StatsTable table(fields, ss);
+
+        table << StatsTable::SEP;
+
+        table << src.name << " profile";
+
+        if ( count )
+            table << " (worst " << count;
+        else
+            table << " (all";
+
+        table << ", sorted by total_time)\n";
+
+        table << StatsTable::HEADER;
+    }
+
+    LogMessage("%s", ss.str().c_str());
+
+    if ( !count || count > entries.size() )
+        count = entries.size();
+
+    auto sort = [](const RulePatternStats& lhs, const RulePatternStats& rhs)
+    { return TO_TICKS(lhs.elapsed) > TO_TICKS(rhs.elapsed); };
+
+    std::partial_sort(entries.begin(), entries.begin() + count, entries.end(), sort);
+
+    for ( unsigned i = 0; i < count; ++i )
+        print_single_entry(entries[i], i + 1);
+}
+
+}
+
+void snort::add_rule_pattern_stats(const char* name, RulePatternGetter get, RulePatternReset reset)
+{
+    remove_rule_pattern_stats(name);
+    pattern_stats::sources.push_back({ name, get, reset });
+}
+
+void snort::remove_rule_pattern_stats(const char* name)
+{
+    auto& v = pattern_stats::sources;
+    auto same = [name](const pattern_stats::Source& src) { return !strcmp(src.name, name); };
+    v.erase(std::remove_if(v.begin(), v.end(), same), v.end());
+}
+
+bool snort::rule_profiler_enabled()
+{ return RuleContext::is_enabled(); }
+
+//-------------------------------------------------------------------------
+// api
+//-------------------------------------------------------------------------
+
 void show_rule_profiler_stats(const RuleProfilerConfig& config)
 {
     if ( !config.show )
@@ -310,10 +430,16 @@ void show_rule_profiler_stats(const RuleProfilerConfig& config)
 
     // FIXIT-L do we eventually want to be able print rule totals, too?
     print_entries(entries, sort, config.count);
+
+    for ( const auto& src : pattern_stats::sources )
+        pattern_stats::print_entries(src, config.count);
 }
 
 void reset_rule_profiler_stats()
 {
+    for ( const auto& src : pattern_stats::sources )
+        src.reset();
+
     const SnortConfig* sc = SnortConfig::get_conf();
     assert(sc);
 
@@ -21,6 +21,9 @@
 #ifndef RULE_PROFILER_DEFS_H
 #define RULE_PROFILER_DEFS_H
 
+#include <vector>
+
+#include "main/snort_types.h"
 #include "time/clock_defs.h"
 #include "time/stopwatch.h"
 
@@ -68,6 +71,9 @@ public:
     static void set_enabled(bool b)
     { enabled = b; }
 
+    static bool is_enabled()
+    { return enabled; }
+
 private:
     dot_node_state_t& stats;
     Stopwatch<SnortClock> sw;
@@ -89,4 +95,27 @@ private:
     RuleContext& ctx;
 };
 
+// options with patterns of their own, like pcre, can add per pattern stats
+// to the rule profile.  the getter appends the totals across all packet
+// threads.  stats should only be gathered when rule profiling is enabled.
+struct RulePatternStats
+{
+    const char* pattern;
+    const char* engine;
+    uint64_t checks;
+    uint64_t matches;
+    hr_duration elapsed;
+};
+
+namespace snort
+{
+using RulePatternGetter = void (*)(std::vector<RulePatternStats>&);
+using RulePatternReset = void (*)();
+
+SO_PUBLIC void add_rule_pattern_stats(const char* name, RulePatternGetter, RulePatternReset);
+SO_PUBLIC void remove_rule_pattern_stats(const char* name);
+
+SO_PUBLIC bool rule_profiler_enabled();
+}
+
 #endif
@@ -87,6 +87,7 @@ void Packet::reset()
 
     release_helpers();
     ptrs.reset();
+    deferred_cksum.reset();
 
     iplist_id = 0;
     user_inspection_policy_id = 0;
@@ -83,7 +83,8 @@ class SFDAQInstance;
 #define PKT_HAS_PARENT       0x08000000  /* derived pseudo packet from current wire packet */
 
 #define PKT_WAS_SET          0x10000000  /* derived pseudo packet (PDU) from current wire packet */
-#define PKT_UNUSED_FLAGS     0xE0000000
+#define PKT_REWRITTEN        0x20000000  /* fields rewritten in place with checksums updated */
+#define PKT_UNUSED_FLAGS     0xC0000000
 
 #define PKT_TS_OFFLOADED        0x01
 
@@ -153,6 +154,7 @@ struct SO_PUBLIC Packet
     uint16_t dsize;             /* packet payload size */
 
     DecodeData ptrs; // convenience pointers used throughout Snort++
+    DeferredChecksum deferred_cksum;  // pending until PacketManager::verify_checksums()
     Layer* layers;    /* decoded encapsulations */
 
     PseudoPacketType pseudo_type;    // valid only when PKT_PSEUDO is set
@@ -30,6 +30,7 @@
 #include "codecs/ip/checksum.h"
 #include "detection/detection_engine.h"
 #include "log/text_log.h"
+#include "main/policy.h"
 #include "main/snort_config.h"
 #include "main/snort_debug.h"
 #include "packet_io/active.h"
@@ -56,6 +57,28 @@ CodecManager::s_protocols.size()> PacketManager::s_stats {
 //PacketManager::s_stats{{0}};
 std::array<PegCount, PacketManager::s_stats.size()> PacketManager::g_stats;
 
+// checksum counts; these aren't a percentage of packets so they are kept
+// out of s_stats
+struct ChecksumStats
+{
+    PegCount eval_bytes;
+    PegCount deferred;
+    PegCount skipped;
+    PegCount deferred_bad;
+};
+
+static const PegInfo checksum_pegs[] =
+{
+    { CountType::SUM, "checksum_eval", "bytes checksummed" },
+    { CountType::SUM, "checksum_deferred", "tcp and udp checksums deferred until inspection" },
+    { CountType::SUM, "checksum_skipped", "deferred checksums never verified" },
+    { CountType::SUM, "checksum_deferred_bad", "deferred checksums found bad when verified" },
+    { CountType::END, nullptr, nullptr }
+};
+
+static THREAD_LOCAL ChecksumStats s_checksum_stats;
+static ChecksumStats g_checksum_stats;
+
 // names which will be printed for the first three statistics
 // in s_stats/g_stats
 const std::array<const char*, PacketManager::stat_offset> PacketManager::stat_names =
@@ -227,6 +250,8 @@ void PacketManager::decode(
     if (cooked)
         codec_data.codec_flags |= CODEC_STREAM_REBUILT;
 
+    codec_data.lazy_checksums = get_network_policy()->checksum_lazy;
+
     // initialize all Packet information
     p->reset();
     p->pkth = pkthdr;
@@ -377,6 +402,35 @@ void PacketManager::decode(
 
     if (!p->proto_bits)
         p->proto_bits = PROTO_BIT__OTHER;
+
+    if (codec_data.deferred_cksum.pending())
+    {
+        p->deferred_cksum = codec_data.deferred_cksum;
+        s_checksum_stats.deferred++;
+        // until verified; the packet is done before stats are accumulated
+        s_checksum_stats.skipped++;
+    }
+}
+
+bool PacketManager::verify_checksums(Packet* p)
+{
+    DeferredChecksum& dc = p->deferred_cksum;
+
+    if (dc.pending())
+    {
+        s_checksum_stats.skipped--;
+
+        if (checksum::l4_cksum((const uint16_t*)dc.data, dc.len, dc.pseudo_sum) == 0)
+            dc.err_flag = 0;
+        else
+        {
+            p->ptrs.decode_flags |= dc.err_flag;
+            s_checksum_stats.deferred_bad++;
+        }
+        // keep err_flag as the result for later calls
+        dc.data = nullptr;
+    }
+    return !dc.err_flag;
 }
 
 //-------------------------------------------------------------------------
@@ -910,12 +964,18 @@ void PacketManager::dump_stats()
 
     show_percent_stats((PegCount*)&g_stats, &pkt_names[0],
         (unsigned int)pkt_names.size(), "codec");
+
+    show_stats((PegCount*)&g_checksum_stats, checksum_pegs,
+        array_size(checksum_pegs) - 1);
 }
 
 void PacketManager::reset_stats()
 {
     std::fill(std::begin(g_stats), std::end(g_stats), 0);
     std::fill(std::begin(s_stats), std::end(s_stats), 0);
+    checksum::take_eval_bytes();
+    g_checksum_stats = { };
+    s_checksum_stats = { };
 }
 
 void PacketManager::accumulate()
@@ -924,6 +984,9 @@ void PacketManager::accumulate()
 
     std::lock_guard<std::mutex> lock(stats_mutex);
     sum_stats(&g_stats[0], &s_stats[0], s_stats.size());
+    s_checksum_stats.eval_bytes += checksum::take_eval_bytes();
+    sum_stats((PegCount*)&g_checksum_stats, (PegCount*)&s_checksum_stats,
+        array_size(checksum_pegs) - 1);
 
     // mutex is automatically unlocked
 }
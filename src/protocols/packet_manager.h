@@ -64,6 +64,10 @@ public:
     static void decode(Packet*, const struct _daq_pkt_hdr*, const uint8_t* pkt,
         uint32_t pktlen, bool cooked = false, bool retry = false);
 
+    // evaluate the checksum deferred by decode, if any.  returns false if
+    // it is bad, in which case its decode error flag is now set.
+    static bool verify_checksums(Packet*);
+
     // update the packet's checksums and length variables. Call this function
     // after Snort has changed any data in this packet
     static void encode_update(Packet*);
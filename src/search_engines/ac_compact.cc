@@ -0,0 +1,129 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ac_compact.cc - mpse wrapper for the compact aho-corasick dfa
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "framework/mpse.h"
+
+#include "acsm_compact.h"
+
+using namespace snort;
+
+//-------------------------------------------------------------------------
+// "ac_compact"
+//-------------------------------------------------------------------------
+
+class AccMpse : public Mpse
+{
+private:
+    AcsmCompact obj;
+
+public:
+    AccMpse(const MpseAgent* agent) : Mpse("ac_compact"), obj(agent)
+    { }
+
+    int add_pattern(
+        const uint8_t* P, unsigned m, const PatternDescriptor& desc, void* user) override
+    {
+        return obj.add_pattern(P, m, desc.no_case, desc.negated, user);
+    }
+
+    int prep_patterns(SnortConfig* sc) override
+    { return obj.compile(sc); }
+
+    int _search(
+        const uint8_t* T, int n, MpseMatch match,
+        void* context, int* current_state) override
+    {
+        return obj.search(T, n, match, context, current_state);
+    }
+
+    int print_info() override
+    {
+        obj.print_info();
+        return 0;
+    }
+
+    int get_pattern_count() const override
+    { return obj.get_pattern_count(); }
+};
+
+//-------------------------------------------------------------------------
+// api
+//-------------------------------------------------------------------------
+
+static Mpse* acc_ctor(
+    const SnortConfig*, class Module*, const MpseAgent* agent)
+{
+    return new AccMpse(agent);
+}
+
+static void acc_dtor(Mpse* p)
+{
+    delete p;
+}
+
+static void acc_init()
+{
+    AcsmCompact::init_summary();
+}
+
+static void acc_print()
+{
+    AcsmCompact::print_summary();
+}
+
+static const MpseApi acc_api =
+{
+    {
+        PT_SEARCH_ENGINE,
+        sizeof(MpseApi),
+        SEAPI_VERSION,
+        0,
+        API_RESERVED,
+        API_OPTIONS,
+        "ac_compact",
+        "Aho-Corasick Compact (low memory DFA for large rule sets) MPSE",
+        nullptr,
+        nullptr
+    },
+    MPSE_BASE | MPSE_MTBLD,
+    nullptr,
+    nullptr,
+    nullptr,
+    nullptr,
+    acc_ctor,
+    acc_dtor,
+    acc_init,
+    acc_print,
+    nullptr,
+};
+
+#ifdef BUILDING_SO
+SO_PUBLIC const BaseApi* snort_plugins[] =
+#else
+const BaseApi* se_ac_compact[] =
+#endif
+{
+    &acc_api.base,
+    nullptr
+};
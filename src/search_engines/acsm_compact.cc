@@ -0,0 +1,678 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// acsm_compact.cc - alphabet compressed aho-corasick dfa with sparse rows
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "acsm_compact.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <utility>
+
+#include "helpers/mpse_cache.h"
+#include "log/messages.h"
+#include "utils/stats.h"
+
+using namespace snort;
+
+// row layout:
+// word 0 = header: low 32 bits = index of first transition,
+//                  high 32 bits = match list index + 1 or 0 if none
+// words 1 .. n = bitmap of classes with a transition in this row
+
+#define AC_HDR_MATCH(h) ((uint32_t)((h) >> 32))
+#define AC_HDR_BASE(h)  ((uint32_t)(h))
+
+typedef std::vector<std::pair<unsigned, uint32_t>> TransList;
+
+struct AcsmCompactDfa
+{
+    uint8_t xlat[256];       // byte -> class
+    uint8_t root_skip[256];  // byte doesn't leave the root
+
+    unsigned num_classes = 0;
+    unsigned row_words = 0;  // bitmap words + header per state
+    unsigned num_states = 0;
+    unsigned max_row = 0;
+
+    std::vector<uint32_t> root;      // full root row by class
+    std::vector<uint64_t> rows;      // per state: header, bitmap words
+    std::vector<uint16_t> next16;    // sparse transitions, one of these
+    std::vector<uint32_t> next32;
+    std::vector<std::vector<uint32_t>> match_pats;  // pattern indices by match
+
+    void save(MpseCacheWriter&) const;
+    bool restore(const std::vector<uint8_t>&, size_t num_patterns);
+    bool valid() const;
+
+    size_t row_memory() const
+    { return rows.size() * sizeof(uint64_t); }
+
+    size_t next_memory() const
+    { return next16.size() * sizeof(uint16_t) + next32.size() * sizeof(uint32_t); }
+
+    size_t root_memory() const
+    { return root.size() * sizeof(uint32_t) + sizeof(xlat) + sizeof(root_skip); }
+
+    size_t match_memory() const
+    {
+        size_t n = 0;
+        for ( const auto& m : match_pats )
+            n += sizeof(m) + m.size() * sizeof(m[0]);
+        return n;
+    }
+};
+
+struct AcsmCompactSummary
+{
+    unsigned num_instances;
+    unsigned num_shared_instances;
+    unsigned num_patterns;
+    unsigned num_characters;
+    unsigned num_states;
+    unsigned num_match_states;
+    unsigned num_transitions;
+    unsigned num_16bit_instances;
+    unsigned max_classes;
+    unsigned max_row;
+    size_t row_memory;
+    size_t next_memory;
+    size_t root_memory;
+    size_t match_memory;
+};
+
+static AcsmCompactSummary summary;
+static std::mutex summary_mutex;  // instances may be compiled in parallel
+
+static inline unsigned popcount(uint64_t w)
+{ return __builtin_popcountll(w); }
+
+//-------------------------------------------------------------------------
+// build
+//-------------------------------------------------------------------------
+
+AcsmCompact::AcsmCompact(const MpseAgent* a) : agent(a)
+{ }
+
+AcsmCompact::~AcsmCompact()
+{
+    if ( !agent )
+        return;
+
+    for ( auto& m : matches )
+    {
+        if ( m.tree )
+            agent->tree_free(&m.tree);
+
+        if ( m.neg_list )
+            agent->list_free(&m.neg_list);
+    }
+
+    for ( auto& p : patterns )
+    {
+        if ( p.user )
+            agent->user_free(p.user);
+    }
+}
+
+int AcsmCompact::add_pattern(
+    const uint8_t* pat, unsigned len, bool no_case, bool negated, void* user)
+{
+    Pattern p;
+    p.pat.resize(len);
+
+    for ( unsigned i = 0; i < len; ++i )
+        p.pat[i] = (uint8_t)toupper(pat[i]);
+
+    p.no_case = no_case;
+    p.negated = negated;
+    p.user = user;
+
+    patterns.emplace_back(std::move(p));
+    return 0;
+}
+
+static uint32_t get_goto(const TransList& t, unsigned c)
+{
+    for ( const auto& e : t )
+        if ( e.first == c )
+            return e.second;
+
+    return 0;
+}
+
+std::shared_ptr<const AcsmCompactDfa> AcsmCompact::build() const
+{
+    std::shared_ptr<AcsmCompactDfa> sp = std::make_shared<AcsmCompactDfa>();
+    AcsmCompactDfa& d = *sp;
+
+    // map folded bytes that occur in patterns to classes 1..n, all others to 0
+    uint8_t cls[256] = { };
+    d.num_classes = 1;
+
+    for ( const auto& p : patterns )
+        for ( auto b : p.pat )
+            if ( !cls[b] )
+                cls[b] = 1;
+
+    for ( unsigned b = 0; b < 256; ++b )
+        if ( cls[b] )
+            cls[b] = d.num_classes++;
+
+    for ( unsigned b = 0; b < 256; ++b )
+        d.xlat[b] = cls[toupper(b)];
+
+    // trie
+    std::vector<TransList> go(1);
+    std::vector<std::vector<uint32_t>> out(1);
+
+    for ( uint32_t i = 0; i < patterns.size(); ++i )
+    {
+        uint32_t s = 0;
+
+        for ( auto b : patterns[i].pat )
+        {
+            unsigned c = cls[b];
+            uint32_t t = get_goto(go[s], c);
+
+            if ( !t )
+            {
+                t = go.size();
+                go[s].emplace_back(c, t);
+                go.emplace_back();
+                out.emplace_back();
+            }
+            s = t;
+        }
+        out[s].emplace_back(i);
+    }
+    d.num_states = go.size();
+
+    d.root.assign(d.num_classes, 0);
+
+    for ( const auto& e : go[0] )
+        d.root[e.first] = e.second;
+
+    for ( unsigned b = 0; b < 256; ++b )
+        d.root_skip[b] = !d.root[d.xlat[b]];
+
+    // rows hold only the transitions that differ from the root row:
+    // row(s) = goto(s) + row(fail(s)) and depth 1 states fail to the root
+    std::vector<TransList> row(d.num_states);
+    std::vector<uint32_t> fail(d.num_states, 0);
+    std::list<uint32_t> queue;
+
+    for ( const auto& e : go[0] )
+    {
+        row[e.second] = go[e.second];
+        queue.emplace_back(e.second);
+    }
+
+    while ( !queue.empty() )
+    {
+        uint32_t r = queue.front();
+        queue.pop_front();
+
+        for ( const auto& e : go[r] )
+        {
+            uint32_t s = e.second;
+            uint32_t f = fail[r];
+
+            while ( f and !get_goto(go[f], e.first) )
+                f = fail[f];
+
+            f = get_goto(go[f], e.first);
+            fail[s] = f;
+
+            row[s] = go[s];
+
+            for ( const auto& t : row[f] )
+                if ( !get_goto(go[s], t.first) )
+                    row[s].emplace_back(t);
+
+            out[s].insert(out[s].end(), out[f].begin(), out[f].end());
+            queue.emplace_back(s);
+        }
+    }
+
+    // flatten
+    unsigned bitmap_words = (d.num_classes + 63) / 64;
+    d.row_words = bitmap_words + 1;
+    d.rows.assign((size_t)d.num_states * d.row_words, 0);
+
+    bool small = d.num_states <= 0x10000;
+    uint32_t base = 0;
+
+    for ( uint32_t s = 0; s < d.num_states; ++s )
+    {
+        uint64_t* p = &d.rows[(size_t)s * d.row_words];
+        TransList& t = row[s];
+
+        if ( s and !out[s].empty() )
+        {
+            d.match_pats.emplace_back(std::move(out[s]));
+            p[0] = (uint64_t)d.match_pats.size() << 32;
+        }
+
+        if ( !s )
+            continue;  // root transitions are in root
+
+        std::sort(t.begin(), t.end());
+        p[0] |= base;
+
+        for ( const auto& e : t )
+        {
+            p[1 + e.first / 64] |= (uint64_t)1 << (e.first % 64);
+
+            if ( small )
+                d.next16.emplace_back(e.second);
+            else
+                d.next32.emplace_back(e.second);
+        }
+        base += t.size();
+
+        if ( t.size() > d.max_row )
+            d.max_row = t.size();
+
+        TransList().swap(t);
+    }
+    return sp;
+}
+
+int AcsmCompact::compile(SnortConfig* sc)
+{
+    // the dfa only depends on the folded patterns and their order
+    MpseCache cache(sc, "ac_compact", 1);
+
+    for ( const auto& p : patterns )
+    {
+        cache.update((uint32_t)p.pat.size());
+        cache.update(p.pat.data(), p.pat.size());
+    }
+
+    dfa = cache.find_shared<AcsmCompactDfa>();
+    bool shared = (bool)dfa;
+
+    if ( !dfa )
+    {
+        std::vector<uint8_t> buf;
+
+        if ( cache.load(buf) )
+        {
+            std::shared_ptr<AcsmCompactDfa> sp = std::make_shared<AcsmCompactDfa>();
+
+            if ( sp->restore(buf, patterns.size()) )
+                dfa = sp;
+            else
+                cache.reject();
+        }
+    }
+
+    if ( !dfa )
+    {
+        dfa = build();
+
+        if ( cache.enabled() )
+        {
+            MpseCacheWriter w;
+            dfa->save(w);
+            cache.store(w.get());
+        }
+    }
+
+    if ( !shared )
+        cache.share(dfa);
+
+    matches.assign(dfa->match_pats.size(), { nullptr, nullptr, nullptr });
+
+    for ( unsigned i = 0; i < matches.size(); ++i )
+        matches[i].user = patterns[dfa->match_pats[i][0]].user;
+
+    if ( agent )
+        build_match_trees(sc);
+
+    add_summary(shared);
+    return 0;
+}
+
+void AcsmCompact::build_match_trees(SnortConfig* sc)
+{
+    for ( unsigned i = 0; i < matches.size(); ++i )
+    {
+        MatchList& m = matches[i];
+
+        for ( auto j : dfa->match_pats[i] )
+        {
+            const Pattern& p = patterns[j];
+
+            if ( !p.user )
+                continue;
+
+            if ( p.negated )
+                agent->negate_list(p.user, &m.neg_list);
+            else
+                agent->build_tree(sc, p.user, &m.tree);
+        }
+        // last call to finalize the tree
+        agent->build_tree(sc, nullptr, &m.tree);
+    }
+}
+
+//-------------------------------------------------------------------------
+// cache
+//-------------------------------------------------------------------------
+
+void AcsmCompactDfa::save(MpseCacheWriter& w) const
+{
+    w.write(num_classes);
+    w.write(row_words);
+    w.write(num_states);
+    w.write(max_row);
+    w.write(xlat);
+    w.write(root_skip);
+    w.write(root);
+    w.write(rows);
+    w.write(next16);
+    w.write(next32);
+    w.write((uint64_t)match_pats.size());
+
+    for ( const auto& m : match_pats )
+        w.write(m);
+}
+
+bool AcsmCompactDfa::restore(const std::vector<uint8_t>& buf, size_t num_patterns)
+{
+    MpseCacheReader r(buf);
+    uint64_t num_matches;
+
+    if ( !r.read(num_classes) or !r.read(row_words) or !r.read(num_states) or
+        !r.read(max_row) or !r.read(xlat) or !r.read(root_skip) or !r.read(root) or
+        !r.read(rows) or !r.read(next16) or !r.read(next32) or !r.read(num_matches) or
+        num_matches > num_states )
+        return false;
+
+    match_pats.resize(num_matches);
+
+    for ( auto& m : match_pats )
+    {
+        if ( !r.read(m) or m.empty() )
+            return false;
+
+        for ( auto j : m )
+            if ( j >= num_patterns )
+                return false;
+    }
+
+    return r.done() and valid();
+}
+
+// make sure a damaged or stale entry can't send the search out of bounds
+bool AcsmCompactDfa::valid() const
+{
+    if ( !num_states or num_classes < 1 or num_classes > 256 or
+        row_words != (num_classes + 63) / 64 + 1 or root.size() != num_classes or
+        rows.size() != (size_t)num_states * row_words or
+        (!next16.empty() and !next32.empty()) or (num_states > 0x10000 and !next16.empty()) )
+        return false;
+
+    for ( auto c : xlat )
+        if ( c >= num_classes )
+            return false;
+
+    for ( auto s : root )
+        if ( s >= num_states )
+            return false;
+
+    for ( auto s : next16 )
+        if ( s >= num_states )
+            return false;
+
+    for ( auto s : next32 )
+        if ( s >= num_states )
+            return false;
+
+    size_t num_next = next16.size() + next32.size();
+
+    for ( uint32_t s = 0; s < num_states; ++s )
+    {
+        const uint64_t* row = &rows[(size_t)s * row_words];
+        size_t n = AC_HDR_BASE(row[0]);
+
+        for ( unsigned i = 1; i < row_words; ++i )
+            n += popcount(row[i]);
+
+        if ( n > num_next or AC_HDR_MATCH(row[0]) > match_pats.size() )
+            return false;
+    }
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// search
+//-------------------------------------------------------------------------
+
+template<typename State>
+static inline uint32_t next_state(
+    const uint64_t* row, const State* next, const uint32_t* root, unsigned c)
+{
+    unsigned w = c / 64;
+    uint64_t bits = row[1 + w];
+    uint64_t bit = (uint64_t)1 << (c % 64);
+
+    if ( !(bits & bit) )
+        return root[c];
+
+    uint32_t idx = AC_HDR_BASE(row[0]) + popcount(bits & (bit - 1));
+
+    for ( unsigned i = 0; i < w; ++i )
+        idx += popcount(row[1 + i]);
+
+    return next[idx];
+}
+
+template<typename State>
+int AcsmCompact::search(
+    const AcsmCompactDfa& d, const State* next, const uint8_t* Tx, int n,
+    MpseMatch match, void* context, int* current_state)
+{
+    const uint8_t* T = Tx;
+    const uint8_t* Tend = Tx + n;
+    const uint32_t* rt = d.root.data();
+    const uint64_t* rows = d.rows.data();
+    const unsigned row_words = d.row_words;
+    uint32_t state = *current_state;
+    int nfound = 0;
+
+    while ( true )
+    {
+        if ( !state )
+        {
+            // the root never matches
+            while ( T < Tend and d.root_skip[*T] )
+                ++T;
+
+            if ( T == Tend )
+                break;
+
+            state = rt[d.xlat[*T++]];
+            continue;
+        }
+
+        const uint64_t* row = &rows[(size_t)state * row_words];
+
+        if ( uint32_t m = AC_HDR_MATCH(row[0]) )
+        {
+            MatchList& ml = matches[m - 1];
+            nfound++;
+
+            if ( match(ml.user, ml.tree, T - Tx, context, ml.neg_list) > 0 )
+                break;
+        }
+
+        if ( T == Tend )
+            break;
+
+        state = next_state(row, next, rt, d.xlat[*T++]);
+    }
+
+    *current_state = state;
+    return nfound;
+}
+
+int AcsmCompact::search(
+    const uint8_t* T, int n, MpseMatch match, void* context, int* current_state)
+{
+    if ( !current_state or !dfa )
+        return 0;
+
+    const AcsmCompactDfa& d = *dfa;
+
+    if ( (unsigned)*current_state >= d.num_states )
+        *current_state = 0;
+
+    if ( !d.next32.empty() )
+        return search(d, d.next32.data(), T, n, match, context, current_state);
+
+    return search(d, d.next16.data(), T, n, match, context, current_state);
+}
+
+//-------------------------------------------------------------------------
+// stats
+//-------------------------------------------------------------------------
+
+void AcsmCompact::add_summary(bool shared) const
+{
+    std::lock_guard<std::mutex> lock(summary_mutex);
+    summary.num_instances++;
+    summary.num_patterns += patterns.size();
+
+    for ( const auto& p : patterns )
+        summary.num_characters += p.pat.size();
+
+    // shared dfas are counted by the instance that built them
+    if ( shared )
+    {
+        summary.num_shared_instances++;
+        return;
+    }
+
+    const AcsmCompactDfa& d = *dfa;
+    summary.num_states += d.num_states;
+    summary.num_match_states += d.match_pats.size();
+    summary.num_transitions += d.next16.size() + d.next32.size();
+
+    if ( d.next32.empty() )
+        summary.num_16bit_instances++;
+
+    if ( d.num_classes > summary.max_classes )
+        summary.max_classes = d.num_classes;
+
+    if ( d.max_row > summary.max_row )
+        summary.max_row = d.max_row;
+
+    summary.row_memory += d.row_memory();
+    summary.next_memory += d.next_memory();
+    summary.root_memory += d.root_memory();
+    summary.match_memory += d.match_memory();
+}
+
+static void print_memory(size_t rows, size_t next, size_t root, size_t match)
+{
+    size_t total = rows + next + root + match;
+    double scale;
+
+    if ( total < 1024 * 1024 )
+    {
+        scale = 1024;
+        LogValue("memory scale", "KB");
+    }
+    else
+    {
+        scale = 1024 * 1024;
+        LogValue("memory scale", "MB");
+    }
+    LogStat("total memory", total / scale);
+    LogStat("row memory", rows / scale);
+    LogStat("transition memory", next / scale);
+    LogStat("root memory", root / scale);
+    LogStat("match list memory", match / scale);
+}
+
+void AcsmCompact::print_info() const
+{
+    if ( !dfa )
+        return;
+
+    const AcsmCompactDfa& d = *dfa;
+    unsigned trans = d.next16.size() + d.next32.size();
+
+    LogCount("patterns", patterns.size());
+    LogCount("states", d.num_states);
+    LogCount("match states", d.match_pats.size());
+    LogCount("alphabet classes", d.num_classes);
+    LogCount("state size", d.next32.empty() ? 2 : 4);
+    LogCount("bitmap words", d.row_words - 1);
+    LogCount("transitions", trans);
+    LogStat("transitions / state", (double)trans / d.num_states);
+    LogCount("max row", d.max_row);
+    LogCount("dfa users", dfa.use_count());
+
+    print_memory(d.row_memory(), d.next_memory(), d.root_memory(),
+        d.match_memory() + matches.size() * sizeof(MatchList));
+}
+
+void AcsmCompact::init_summary()
+{
+    summary = { };
+}
+
+void AcsmCompact::print_summary()
+{
+    if ( !summary.num_instances )
+        return;
+
+    LogValue("storage format", "compact");
+    LogValue("finite automaton", "DFA");
+
+    LogCount("instances", summary.num_instances);
+    LogCount("shared instances", summary.num_shared_instances);
+    LogCount("16 bit instances", summary.num_16bit_instances);
+    LogCount("patterns", summary.num_patterns);
+    LogCount("pattern chars", summary.num_characters);
+
+    if ( !summary.num_states )
+        return;
+
+    LogCount("states", summary.num_states);
+    LogCount("transitions", summary.num_transitions);
+    LogCount("match states", summary.num_match_states);
+    LogStat("transitions / state", (double)summary.num_transitions / summary.num_states);
+    LogCount("max alphabet classes", summary.max_classes);
+    LogCount("max row", summary.max_row);
+
+    print_memory(summary.row_memory, summary.next_memory, summary.root_memory,
+        summary.match_memory);
+}
@@ -0,0 +1,101 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// acsm_compact.h - alphabet compressed aho-corasick dfa with sparse rows
+
+#ifndef ACSM_COMPACT_H
+#define ACSM_COMPACT_H
+
+// a dfa that stays cache resident for large pattern sets:
+//
+// * input bytes are case folded and mapped to equivalence classes so rows
+//   only span the bytes that actually occur in patterns
+// * states are 16 bits unless there are more than 64K states
+// * the root row is stored in full and a byte skip table lets the search
+//   run through bytes that can't leave the root without touching rows
+// * other rows only store transitions that differ from the root row,
+//   indexed by a bitmap over the classes and the popcount below the bit
+//
+// the dfa is immutable once built and only refers to patterns by index so
+// instances with the same patterns share it, eg across a reload.  match
+// trees and user data are kept per instance.
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "search_common.h"
+
+namespace snort
+{
+struct SnortConfig;
+}
+
+struct AcsmCompactDfa;
+
+class AcsmCompact
+{
+public:
+    AcsmCompact(const MpseAgent*);
+    ~AcsmCompact();
+
+    int add_pattern(const uint8_t* pat, unsigned len, bool no_case, bool negated, void* user);
+    int compile(snort::SnortConfig*);
+
+    int search(const uint8_t* T, int n, MpseMatch, void* context, int* current_state);
+
+    int get_pattern_count() const
+    { return patterns.size(); }
+
+    void print_info() const;
+
+    static void init_summary();
+    static void print_summary();
+
+private:
+    struct Pattern
+    {
+        std::vector<uint8_t> pat;  // case folded
+        bool no_case;
+        bool negated;
+        void* user;
+    };
+
+    struct MatchList
+    {
+        void* user;
+        void* tree;
+        void* neg_list;
+    };
+
+    template<typename State>
+    int search(const AcsmCompactDfa&, const State*, const uint8_t* T, int n,
+        MpseMatch, void*, int*);
+
+    std::shared_ptr<const AcsmCompactDfa> build() const;
+    void build_match_trees(snort::SnortConfig*);
+    void add_summary(bool shared) const;
+
+private:
+    const MpseAgent* agent;
+    std::vector<Pattern> patterns;
+    std::shared_ptr<const AcsmCompactDfa> dfa;
+    std::vector<MatchList> matches;  // match index - 1 from the row header
+};
+
+#endif
@@ -120,6 +120,11 @@
 #include <cassert>
 #include <list>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ACSM_X86_SIMD
+#endif
+
 #include "log/messages.h"
 #include "utils/stats.h"
 #include "utils/util.h"
@@ -181,6 +186,9 @@ static uint8_t xlatcase[256];
 /*
 *
 */
+static AcsmKernel acsm_kernel = AcsmKernel::BYTE;
+static void (*acsm_fold_case)(uint8_t*, const uint8_t*, int) = nullptr;
+
 void acsmx2_init_xlatcase()
 {
     int i;
@@ -188,6 +196,119 @@ void acsmx2_init_xlatcase()
     {
         xlatcase[i] = (uint8_t)toupper(i);
     }
+
+    if ( !acsmx2_set_kernel(AcsmKernel::STRIDED_AVX2) and
+        !acsmx2_set_kernel(AcsmKernel::STRIDED_SSE2) )
+    {
+        acsmx2_set_kernel(AcsmKernel::STRIDED);
+    }
+}
+
+/*
+*    Block case folding for the strided kernels
+*/
+static void fold_case_table(uint8_t* d, const uint8_t* s, int n)
+{
+    for ( int i = 0; i < n; i++ )
+        d[i] = xlatcase[ s[i] ];
+}
+
+#ifdef ACSM_X86_SIMD
+// 'a' - 'z' => 'A' - 'Z'; bytes >= 0x80 are negative and never in range
+static void fold_case_sse2(uint8_t* d, const uint8_t* s, int n)
+{
+    const __m128i lo = _mm_set1_epi8('a' - 1);
+    const __m128i hi = _mm_set1_epi8('z' + 1);
+    const __m128i diff = _mm_set1_epi8('a' - 'A');
+    int i = 0;
+
+    for ( ; i + 16 <= n; i += 16 )
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i m = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+        _mm_storeu_si128((__m128i*)(d + i), _mm_sub_epi8(v, _mm_and_si128(m, diff)));
+    }
+    fold_case_table(d + i, s + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void fold_case_avx2(uint8_t* d, const uint8_t* s, int n)
+{
+    const __m256i lo = _mm256_set1_epi8('a' - 1);
+    const __m256i hi = _mm256_set1_epi8('z' + 1);
+    const __m256i diff = _mm256_set1_epi8('a' - 'A');
+    int i = 0;
+
+    for ( ; i + 32 <= n; i += 32 )
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i m = _mm256_and_si256(_mm256_cmpgt_epi8(v, lo), _mm256_cmpgt_epi8(hi, v));
+        _mm256_storeu_si256((__m256i*)(d + i), _mm256_sub_epi8(v, _mm256_and_si256(m, diff)));
+    }
+    fold_case_sse2(d + i, s + i, n - i);
+}
+#endif
+
+// the simd folds are only equivalent if the table is plain ascii
+static bool xlatcase_is_ascii()
+{
+    for ( int i = 0; i < 256; i++ )
+    {
+        int c = (i >= 'a' and i <= 'z') ? i - ('a' - 'A') : i;
+
+        if ( xlatcase[i] != c )
+            return false;
+    }
+    return true;
+}
+
+bool acsmx2_set_kernel(AcsmKernel k)
+{
+    switch ( k )
+    {
+    case AcsmKernel::BYTE:
+        acsm_fold_case = nullptr;
+        break;
+
+    case AcsmKernel::STRIDED:
+        acsm_fold_case = fold_case_table;
+        break;
+
+#ifdef ACSM_X86_SIMD
+    case AcsmKernel::STRIDED_SSE2:
+        if ( !__builtin_cpu_supports("sse2") or !xlatcase_is_ascii() )
+            return false;
+        acsm_fold_case = fold_case_sse2;
+        break;
+
+    case AcsmKernel::STRIDED_AVX2:
+        if ( !__builtin_cpu_supports("avx2") or !xlatcase_is_ascii() )
+            return false;
+        acsm_fold_case = fold_case_avx2;
+        break;
+#endif
+
+    default:
+        return false;
+    }
+
+    acsm_kernel = k;
+    return true;
+}
+
+AcsmKernel acsmx2_get_kernel()
+{ return acsm_kernel; }
+
+const char* acsmx2_get_kernel_name(AcsmKernel k)
+{
+    switch ( k )
+    {
+    case AcsmKernel::BYTE:         return "byte";
+    case AcsmKernel::STRIDED:      return "strided";
+    case AcsmKernel::STRIDED_SSE2: return "strided sse2";
+    case AcsmKernel::STRIDED_AVX2: return "strided avx2";
+    }
+    return "unknown";
 }
 
 /*
@@ -1140,6 +1261,10 @@ int acsmAddPattern2(
     memcpy(plist->casepatrn, pat, n);
 
     plist->n = n;
+
+    if ( (int)n > p->maxPatternLen )
+        p->maxPatternLen = n;
+
     plist->nocase = nocase;
     plist->negative = negative;
     plist->udata = user;
@@ -1615,6 +1740,237 @@ void acsmx2_print_qinfo()
 {
 }
 
+/*
+*   Strided full format DFA search
+*
+*   Large buffers are split into AC_STRIDES segments that are walked
+*   together so the row loads of each segment overlap in the memory
+*   system instead of waiting on each other as in the byte walk.  The
+*   DFA state after reading maxPatternLen bytes from the root is the same
+*   as the state reached from the start of the buffer, so each segment
+*   starts maxPatternLen bytes early and only records matches after that.
+*   Input is case folded a block at a time, with SIMD when available.
+*
+*   Matches are buffered per segment and reported in segment order so the
+*   callback sees exactly what the byte walk would report, including the
+*   early exit state.  A segment that fills its buffer stops there and is
+*   finished by the byte walk when its turn to report comes.
+*/
+#define AC_STRIDES 4
+#define AC_STRIDE_MATCHES 32
+#define AC_FOLD_BLOCK 64
+#define AC_STRIDE_MIN 512
+
+struct AcStrideMatch
+{
+    int index;
+    acstate_t state;
+};
+
+struct AcStride
+{
+    int start;
+    int pos;
+    int end;
+    int report;
+    acstate_t state;
+    int num;
+    bool stopped;
+    AcStrideMatch match[AC_STRIDE_MATCHES];
+};
+
+static inline bool use_strided(const ACSM_STRUCT2* acsm, int n)
+{
+    return acsm_fold_case and n >= AC_STRIDE_MIN and
+        n >= AC_STRIDES * 4 * acsm->maxPatternLen;
+}
+
+static void stride_init(AcStride* sv, int n, int ov, acstate_t state)
+{
+    int len = (n + (AC_STRIDES - 1) * ov + AC_STRIDES - 1) / AC_STRIDES;
+
+    for ( int k = 0; k < AC_STRIDES; k++ )
+    {
+        AcStride& st = sv[k];
+        st.start = st.pos = k * (len - ov);
+        st.end = (k == AC_STRIDES - 1) ? n : st.start + len;
+        st.report = k ? st.start + ov : 0;
+        st.state = k ? 0 : state;
+        st.num = 0;
+        st.stopped = false;
+    }
+}
+
+// returns false if the match buffer is full; the byte is not consumed
+template<typename S>
+static inline bool stride_step(S** NextState, AcStride& st, int pos, uint8_t c)
+{
+    S* ps = NextState[st.state];
+
+    if ( ps[1] and pos >= st.report )
+    {
+        if ( st.num == AC_STRIDE_MATCHES )
+        {
+            st.pos = pos;
+            st.stopped = true;
+            return false;
+        }
+        st.match[st.num].index = pos;
+        st.match[st.num++].state = st.state;
+    }
+    st.state = ps[2u + c];
+    return true;
+}
+
+template<typename S>
+static void stride_scan(S** NextState, const uint8_t* Tx, AcStride* sv)
+{
+    // the last stride is the shortest
+    const int len = sv[AC_STRIDES - 1].end - sv[AC_STRIDES - 1].start;
+    uint8_t buf[AC_STRIDES][AC_FOLD_BLOCK];
+    int j = 0;
+    bool full = false;
+
+    while ( j < len and !full )
+    {
+        int blk = len - j < AC_FOLD_BLOCK ? len - j : AC_FOLD_BLOCK;
+
+        for ( int k = 0; k < AC_STRIDES; k++ )
+            acsm_fold_case(buf[k], Tx + sv[k].start + j, blk);
+
+        for ( int i = 0; i < blk; i++, j++ )
+        {
+            for ( int k = 0; k < AC_STRIDES; k++ )
+            {
+                if ( !stride_step(NextState, sv[k], sv[k].start + j, buf[k][i]) )
+                    full = true;
+            }
+            if ( full )
+                break;
+        }
+    }
+
+    // a full stride stopped at j, the others consumed byte j
+    if ( full )
+        j++;
+
+    for ( int k = 0; k < AC_STRIDES; k++ )
+    {
+        AcStride& st = sv[k];
+
+        if ( st.stopped )
+            continue;
+
+        for ( st.pos = st.start + j; st.pos < st.end; st.pos++ )
+        {
+            if ( !stride_step(NextState, st, st.pos, xlatcase[Tx[st.pos]]) )
+                break;
+        }
+    }
+}
+
+// byte walk of a stopped stride
+template<bool all, typename S>
+static int stride_finish(
+    ACSM_STRUCT2* acsm, S** NextState, const uint8_t* Tx, AcStride& st,
+    MpseMatch match, void* context, int* current_state, int& nfound)
+{
+    ACSM_PATTERN2** MatchList = acsm->acsmMatchList;
+    acstate_t state = st.state;
+
+    for ( int index = st.pos; index < st.end; index++ )
+    {
+        S* ps = NextState[state];
+
+        if ( ps[1] )
+        {
+            for ( ACSM_PATTERN2* mlist = MatchList[state]; mlist; mlist = mlist->next )
+            {
+                if ( !all or mlist->nocase or
+                    !memcmp(mlist->casepatrn, Tx + index - mlist->n, mlist->n) )
+                {
+                    nfound++;
+                    if ( match(mlist->udata, mlist->rule_option_tree, index, context,
+                        mlist->neg_list) > 0 )
+                    {
+                        *current_state = state;
+                        return 1;
+                    }
+                }
+                if ( !all )
+                    break;
+            }
+        }
+        state = ps[2u + xlatcase[Tx[index]]];
+    }
+    st.state = state;
+    return 0;
+}
+
+template<bool all, typename S>
+static int acsm_search_strided(
+    ACSM_STRUCT2* acsm, S** NextState, const uint8_t* Tx, int n, MpseMatch match,
+    void* context, int* current_state)
+{
+    ACSM_PATTERN2** MatchList = acsm->acsmMatchList;
+    AcStride sv[AC_STRIDES];
+    int nfound = 0;
+
+    stride_init(sv, n, acsm->maxPatternLen, *current_state);
+    stride_scan(NextState, Tx, sv);
+
+    for ( int k = 0; k < AC_STRIDES; k++ )
+    {
+        AcStride& st = sv[k];
+
+        for ( int m = 0; m < st.num; m++ )
+        {
+            acstate_t state = st.match[m].state;
+            int index = st.match[m].index;
+
+            for ( ACSM_PATTERN2* mlist = MatchList[state]; mlist; mlist = mlist->next )
+            {
+                if ( !all or mlist->nocase or
+                    !memcmp(mlist->casepatrn, Tx + index - mlist->n, mlist->n) )
+                {
+                    nfound++;
+                    if ( match(mlist->udata, mlist->rule_option_tree, index, context,
+                        mlist->neg_list) > 0 )
+                    {
+                        *current_state = state;
+                        return nfound;
+                    }
+                }
+                if ( !all )
+                    break;
+            }
+        }
+        if ( st.stopped and stride_finish<all>(
+            acsm, NextState, Tx, st, match, context, current_state, nfound) )
+            return nfound;
+    }
+
+    // the last stride ends in the same state as the byte walk
+    acstate_t state = sv[AC_STRIDES - 1].state;
+
+    for ( ACSM_PATTERN2* mlist = MatchList[state]; mlist; mlist = mlist->next )
+    {
+        if ( !all or mlist->nocase or
+            !memcmp(mlist->casepatrn, Tx + n - mlist->n, mlist->n) )
+        {
+            nfound++;
+            if ( match(mlist->udata, mlist->rule_option_tree, n, context,
+                mlist->neg_list) > 0 )
+                break;
+        }
+        if ( !all )
+            break;
+    }
+
+    *current_state = state;
+    return nfound;
+}
+
 /*
 *   Full format DFA search
 *   Do not change anything here without testing, caching and prefetching
@@ -1668,6 +2024,22 @@ int acsm_search_dfa_full(
     if (current_state == nullptr)
         return 0;
 
+    if ( use_strided(acsm, n) )
+    {
+        switch (acsm->sizeofstate)
+        {
+        case 1:
+            return acsm_search_strided<false>(
+                acsm, (uint8_t**)acsm->acsmNextState, Tx, n, match, context, current_state);
+        case 2:
+            return acsm_search_strided<false>(
+                acsm, (uint16_t**)acsm->acsmNextState, Tx, n, match, context, current_state);
+        default:
+            return acsm_search_strided<false>(
+                acsm, acsm->acsmNextState, Tx, n, match, context, current_state);
+        }
+    }
+
     state = *current_state;
 
     switch (acsm->sizeofstate)
@@ -1768,6 +2140,22 @@ int acsm_search_dfa_full_all(
     if (current_state == nullptr)
         return 0;
 
+    if ( use_strided(acsm, n) )
+    {
+        switch (acsm->sizeofstate)
+        {
+        case 1:
+            return acsm_search_strided<true>(
+                acsm, (uint8_t**)acsm->acsmNextState, Tx, n, match, context, current_state);
+        case 2:
+            return acsm_search_strided<true>(
+                acsm, (uint16_t**)acsm->acsmNextState, Tx, n, match, context, current_state);
+        default:
+            return acsm_search_strided<true>(
+                acsm, acsm->acsmNextState, Tx, n, match, context, current_state);
+        }
+    }
+
     state = *current_state;
 
     switch (acsm->sizeofstate)
@@ -2121,6 +2509,10 @@ int acsmPrintSummaryInfo2()
 
     LogValue("storage format", sf[p->acsmFormat]);
     LogValue("finite automaton", p->dfa ? "DFA" : "NFA");
+
+    if ( p->dfa and p->acsmFormat == ACF_FULL )
+        LogValue("search kernel", acsmx2_get_kernel_name(acsm_kernel));
+
     LogCount("alphabet size", p->acsmAlphabetSize);
 
     LogCount("instances", summary.num_instances);
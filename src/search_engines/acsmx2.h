@@ -122,6 +122,7 @@ struct ACSM_STRUCT2
     int acsmNumTrans;
     int acsmAlphabetSize;
     int numPatterns;
+    int maxPatternLen;
 
     int sizeofstate;
     int compress_states;
@@ -135,11 +136,29 @@ struct ACSM_STRUCT2
     { return dfa; }
 };
 
+/*
+*   Full format DFA search kernels; byte walks one byte at a time and the
+*   strided kernels walk segments of large buffers together, optionally
+*   case folding with SIMD.  The best kernel supported by the cpu is
+*   selected by acsmx2_init_xlatcase().
+*/
+enum class AcsmKernel
+{
+    BYTE,
+    STRIDED,
+    STRIDED_SSE2,
+    STRIDED_AVX2,
+};
+
 /*
 *   Prototypes
 */
 void acsmx2_init_xlatcase();
 
+bool acsmx2_set_kernel(AcsmKernel);  // false if not supported
+AcsmKernel acsmx2_get_kernel();
+const char* acsmx2_get_kernel_name(AcsmKernel);
+
 ACSM_STRUCT2* acsmNew2(const MpseAgent*, int format);
 
 int acsmAddPattern2(
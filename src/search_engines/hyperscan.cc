@@ -25,12 +25,17 @@
 #include <hs_compile.h>
 #include <hs_runtime.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <memory>
 
 #include "framework/module.h"
 #include "framework/mpse.h"
+#include "framework/mpse_batch.h"
+#include "helpers/mpse_cache.h"
 #include "helpers/scratch_allocator.h"
+#include "detection/fp_config.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
 #include "main/thread.h"
@@ -135,9 +140,6 @@ public:
 
     ~HyperscanMpse() override
     {
-        if ( hs_db )
-            hs_free_database(hs_db);
-
         if ( agent )
             user_dtor();
     }
@@ -155,6 +157,7 @@ public:
     void reuse_search() override;
 
     int _search(const uint8_t*, int, MpseMatch, void*, int*) override;
+    void _search(MpseBatch**, unsigned, MpseType) override;
 
     int get_pattern_count() const override
     { return pvector.size(); }
@@ -169,10 +172,15 @@ private:
     void user_ctor(SnortConfig*);
     void user_dtor();
 
+    void set_key(MpseCache&);
+    bool load_db(MpseCache&);
+    void store_db(MpseCache&);
+
     const MpseAgent* agent;
     PatternVector pvector;
 
-    hs_database_t* hs_db = nullptr;
+    // instances with the same patterns share the database
+    std::shared_ptr<const hs_database_t> hs_db;
 
 public:
     static uint64_t instances;
@@ -218,6 +226,54 @@ void HyperscanMpse::user_dtor()
     }
 }
 
+// the cache key covers the library version, the platform the database is
+// tuned for, and each expression with its flags in id order
+void HyperscanMpse::set_key(MpseCache& cache)
+{
+    hs_platform_info_t plat;
+    hs_populate_platform(&plat);
+
+    cache.update(std::string(hs_version()));
+    cache.update(plat.tune);
+    cache.update(plat.cpu_features);
+
+    for ( auto& p : pvector )
+    {
+        cache.update(p.pat);
+        cache.update(p.flags);
+    }
+}
+
+bool HyperscanMpse::load_db(MpseCache& cache)
+{
+    std::vector<uint8_t> buf;
+
+    if ( !cache.load(buf) )
+        return false;
+
+    hs_database_t* db = nullptr;
+
+    if ( hs_deserialize_database((const char*)buf.data(), buf.size(), &db) != HS_SUCCESS )
+    {
+        cache.reject();
+        return false;
+    }
+    hs_db.reset(db, hs_free_database);
+    return true;
+}
+
+void HyperscanMpse::store_db(MpseCache& cache)
+{
+    char* buf;
+    size_t len;
+
+    if ( cache.enabled() and hs_serialize_database(hs_db.get(), &buf, &len) == HS_SUCCESS )
+    {
+        cache.store(buf, len);
+        free(buf);
+    }
+}
+
 int HyperscanMpse::prep_patterns(SnortConfig* sc)
 {
     if ( pvector.empty() )
@@ -243,17 +299,33 @@ int HyperscanMpse::prep_patterns(SnortConfig* sc)
         ids.emplace_back(id++);
     }
 
-    if ( hs_compile_multi(&pats[0], &flags[0], &ids[0], pvector.size(), HS_MODE_BLOCK,
-            nullptr, &hs_db, &errptr) or !hs_db )
+    MpseCache cache(sc, s_name, 1);
+    set_key(cache);
+
+    hs_db = cache.find_shared<hs_database_t>();
+    bool shared = (bool)hs_db;
+
+    if ( !shared and !load_db(cache) )
     {
-        ParseError("can't compile hyperscan pattern database: %s (%d) - '%s'",
-            errptr->message, errptr->expression,
-            errptr->expression >= 0 ? pats[errptr->expression] : "");
-        hs_free_compile_error(errptr);
-        return -2;
+        hs_database_t* db = nullptr;
+
+        if ( hs_compile_multi(&pats[0], &flags[0], &ids[0], pvector.size(), HS_MODE_BLOCK,
+                nullptr, &db, &errptr) or !db )
+        {
+            ParseError("can't compile hyperscan pattern database: %s (%d) - '%s'",
+                errptr->message, errptr->expression,
+                errptr->expression >= 0 ? pats[errptr->expression] : "");
+            hs_free_compile_error(errptr);
+            return -2;
+        }
+        hs_db.reset(db, hs_free_database);
+        store_db(cache);
     }
 
-    if ( hs_error_t err = hs_alloc_scratch(hs_db, &s_scratch[get_instance_id()]) )
+    if ( !shared )
+        cache.share(hs_db);
+
+    if ( hs_error_t err = hs_alloc_scratch(hs_db.get(), &s_scratch[get_instance_id()]) )
     {
         ParseError("can't allocate search scratch space (%d)", err);
         return -3;
@@ -270,7 +342,7 @@ void HyperscanMpse::reuse_search()
     if ( pvector.empty() )
         return;
 
-    if ( hs_error_t err = hs_alloc_scratch(hs_db, &s_scratch[get_instance_id()]) )
+    if ( hs_error_t err = hs_alloc_scratch(hs_db.get(), &s_scratch[get_instance_id()]) )
         ErrorMessage("can't allocate search scratch space (%d)", err);
 }
 
@@ -302,11 +374,87 @@ int HyperscanMpse::_search(
     // scratch is null for the degenerate case w/o patterns
     assert(!hs_db or ss);
 
-    hs_scan(hs_db, (const char*)buf, n, 0, ss, HyperscanMpse::match, &scan);
+    hs_scan(hs_db.get(), (const char*)buf, n, 0, ss, HyperscanMpse::match, &scan);
 
     return scan.nfound;
 }
 
+// each database scans the buffers of all the packets back to back so it stays
+// in cache, and the scratch is looked up once for the whole batch.  groups
+// from another search engine are searched through the usual interface.
+void HyperscanMpse::_search(MpseBatch** batches, unsigned n, MpseType type)
+{
+    hs_scratch_t* ss =
+        (hs_scratch_t*)SnortConfig::get_conf()->state[get_instance_id()][scratch_index];
+
+    std::vector<MpseGroup*> groups;
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        for ( auto& item : batches[i]->items )
+        {
+            if ( item.second.done )
+                continue;
+
+            item.second.error = false;
+            item.second.matches = 0;
+
+            for ( auto* so : item.second.so )
+            {
+                if ( std::find(groups.begin(), groups.end(), so) == groups.end() )
+                    groups.emplace_back(so);
+            }
+        }
+    }
+
+    for ( auto* so : groups )
+    {
+        Mpse* mpse = (type == MPSE_TYPE_OFFLOAD) ? so->get_offload_mpse() : so->get_normal_mpse();
+        HyperscanMpse* hs = (mpse->get_api() == get_api()) ? (HyperscanMpse*)mpse : nullptr;
+
+        // no patterns, no matches
+        if ( hs and !hs->hs_db )
+            continue;
+
+        for ( unsigned i = 0; i < n; ++i )
+        {
+            MpseBatch* b = batches[i];
+
+            for ( auto& item : b->items )
+            {
+                if ( item.second.done )
+                    continue;
+
+                const uint8_t* buf = item.first.buf;
+                unsigned len = item.first.len;
+
+                for ( auto* s : item.second.so )
+                {
+                    if ( s != so )
+                        continue;
+
+                    if ( !hs )
+                    {
+                        int start_state = 0;
+                        item.second.matches += mpse->search(buf, len, b->mf, b->context, &start_state);
+                        continue;
+                    }
+                    assert(ss);
+                    ScanContext scan(hs, b->mf, b->context);
+                    hs_scan(hs->hs_db.get(), (const char*)buf, len, 0, ss, HyperscanMpse::match, &scan);
+                    item.second.matches += scan.nfound;
+                }
+            }
+        }
+    }
+
+    for ( unsigned i = 0; i < n; ++i )
+    {
+        for ( auto& item : batches[i]->items )
+            item.second.done = true;
+    }
+}
+
 static bool scratch_setup(SnortConfig* sc)
 {
     // find the largest scratch and clone for all slots
@@ -315,7 +463,7 @@ static bool scratch_setup(SnortConfig* sc)
     if ( !s_scratch.size() )
         return false;
 
-    for ( unsigned i = 0; i < sc->num_slots; ++i )
+    for ( unsigned i = 0; i < s_scratch.size(); ++i )
     {
         if ( !s_scratch[i] )
             continue;
@@ -389,8 +537,14 @@ static void mod_dtor(Module* p)
 static Mpse* hs_ctor(
     const SnortConfig* sc, class Module*, const MpseAgent* a)
 {
-    if ( s_scratch.empty() )
-        s_scratch.resize(sc->num_slots, nullptr);
+    // compile threads allocate into their own instance's slot
+    unsigned n = sc->num_slots;
+
+    if ( sc->fast_pattern_config )
+        n = std::max(n, sc->fast_pattern_config->get_compile_threads());
+
+    if ( s_scratch.size() < n )
+        s_scratch.resize(n, nullptr);
 
     return new HyperscanMpse(a);
 }
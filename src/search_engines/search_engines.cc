@@ -29,6 +29,7 @@ using namespace snort;
 extern const BaseApi* se_ac_bnfa[];
 
 #ifdef STATIC_SEARCH_ENGINES
+extern const BaseApi* se_ac_compact[];
 extern const BaseApi* se_ac_std[];
 extern const BaseApi* se_acsmx2[];
 #ifdef HAVE_HYPERSCAN
@@ -41,6 +42,7 @@ void load_search_engines()
     PluginManager::load_plugins(se_ac_bnfa);
 
 #ifdef STATIC_SEARCH_ENGINES
+    PluginManager::load_plugins(se_ac_compact);
     PluginManager::load_plugins(se_ac_std);
     PluginManager::load_plugins(se_acsmx2);
 #ifdef HAVE_HYPERSCAN
@@ -0,0 +1,462 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// ac_compact_test.cc - compact dfa checks against the full matrix dfa
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/catch.hpp"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "detection/fp_config.h"
+#include "hash/hashes.h"
+#include "helpers/directory.h"
+#include "helpers/mpse_cache.h"
+#include "main/snort_config.h"
+#include "search_engines/acsm_compact.h"
+#include "search_engines/acsmx2.h"
+
+//-------------------------------------------------------------------------
+// stubs
+//-------------------------------------------------------------------------
+
+FastPatternConfig::FastPatternConfig() = default;
+
+namespace snort
+{
+SnortConfig::SnortConfig(const SnortConfig* const)
+{ fast_pattern_config = new FastPatternConfig; }
+
+SnortConfig::~SnortConfig()
+{ delete fast_pattern_config; }
+
+void LogValue(const char*, const char*, FILE*) { }
+void LogMessage(const char*, ...) { }
+void LogCount(char const*, uint64_t, FILE*) { }
+void LogStat(const char*, double, FILE*) { }
+void WarningMessage(const char*, ...) { }
+const char* get_error(int) { return ""; }
+
+// not a real digest but good enough to key the test cache
+void sha256(const unsigned char* data, size_t size, unsigned char* digest)
+{
+    uint64_t h = 14695981039346656037ull;
+    memset(digest, 0, SHA256_HASH_SIZE);
+
+    for ( size_t i = 0; i < size; ++i )
+    {
+        h = (h ^ data[i]) * 1099511628211ull;
+        digest[i % SHA256_HASH_SIZE] ^= (uint8_t)(h >> 32);
+    }
+}
+}
+
+static unsigned s_trees = 0;
+static unsigned s_users = 0;
+
+static MpseAgent s_agent =
+{
+    [](snort::SnortConfig*, void* id, void** ppt)
+    {
+        if ( id and !*ppt )
+        {
+            *ppt = id;
+            s_trees++;
+        }
+        return 0;
+    },
+    [](void*, void**) { return 0; },
+
+    [](void*) { s_users++; },
+    [](void** ppt) { if ( *ppt ) s_trees--; },
+    [](void**) { }
+};
+
+//-------------------------------------------------------------------------
+// helpers
+//-------------------------------------------------------------------------
+
+struct Hits
+{
+    std::vector<int> index;
+    unsigned stop_at = 0;
+};
+
+static int match(void*, void*, int index, void* context, void*)
+{
+    Hits* h = (Hits*)context;
+    h->index.push_back(index);
+    return (h->stop_at and h->index.size() == h->stop_at) ? 1 : 0;
+}
+
+static std::string make_text(std::mt19937& rng, const char* alpha, unsigned n)
+{
+    unsigned len = strlen(alpha);
+    std::string s(n, ' ');
+
+    for ( auto& c : s )
+        c = alpha[rng() % len];
+
+    return s;
+}
+
+struct Engines
+{
+    ACSM_STRUCT2* full;
+    AcsmCompact compact;
+
+    Engines() : compact(&s_agent)
+    {
+        full = acsmNew2(&s_agent, ACF_FULL);
+        acsmCompressStates(full, 0);
+        full->enable_dfa();
+    }
+
+    ~Engines()
+    { acsmFree2(full); }
+
+    void add(const std::string& p, bool no_case, uintptr_t id)
+    {
+        acsmAddPattern2(full, (const uint8_t*)p.c_str(), p.size(), no_case, false, (void*)id);
+        compact.add_pattern((const uint8_t*)p.c_str(), p.size(), no_case, false, (void*)id);
+    }
+
+    void compile()
+    {
+        acsmCompile2(nullptr, full);
+        compact.compile(nullptr);
+    }
+
+    void check(const std::string& s, unsigned stop_at, int start = 0)
+    {
+        Hits ref, h;
+        ref.stop_at = h.stop_at = stop_at;
+        int ref_state = start, state = start;
+
+        const uint8_t* T = (const uint8_t*)s.c_str();
+        acsmx2_set_kernel(AcsmKernel::BYTE);
+        int ref_found = acsm_search_dfa_full(full, T, s.size(), match, &ref, &ref_state);
+        int found = compact.search(T, s.size(), match, &h, &state);
+
+        CHECK(found == ref_found);
+        CHECK((h.index == ref.index));
+
+        // state numbering differs but the match status must agree
+        Hits a, b;
+        acsm_search_dfa_full(full, T, 0, match, &a, &ref_state);
+        compact.search(T, 0, match, &b, &state);
+        CHECK(a.index.size() == b.index.size());
+    }
+};
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+TEST_CASE("compact basic", "[ac_compact]")
+{
+    acsmx2_init_xlatcase();
+    {
+        Engines e;
+        e.add("abc", true, 1);
+        e.add("BCD", false, 2);
+        e.add("c", true, 3);
+        e.add(std::string("\x00\xff", 2), true, 4);
+        e.compile();
+
+        CHECK(e.compact.get_pattern_count() == 4);
+
+        std::string s("xxABCDxabcd\x00\xff\x00", 14);
+        e.check(s, 0);
+        e.check(s, 2);
+        e.check("", 0);
+    }
+    CHECK(s_trees == 0);
+    CHECK(s_users == 8);
+}
+
+TEST_CASE("compact matches full dfa", "[ac_compact]")
+{
+    acsmx2_init_xlatcase();
+    std::mt19937 rng(777);
+
+    const char* alphas[] =
+    {
+        "abAB",
+        "abcdeABCDE!",
+        "etaoinshrdlu ETAOIN\xe9\xc9\x80\x01\xff",
+    };
+
+    for ( auto alpha : alphas )
+    {
+        for ( unsigned num : { 1, 25, 500 } )
+        {
+            Engines e;
+
+            for ( unsigned i = 0; i < num; ++i )
+                e.add(make_text(rng, alpha, 1 + rng() % 12), rng() & 1, i + 1);
+
+            e.compile();
+
+            for ( unsigned len : { 1, 50, 1500 } )
+            {
+                std::string s = make_text(rng, alpha, len);
+                e.check(s, 0);
+                e.check(s, 3);
+            }
+        }
+    }
+}
+
+TEST_CASE("compact wide states", "[ac_compact]")
+{
+    // more than 64K states needs 32 bit transitions
+    acsmx2_init_xlatcase();
+    std::mt19937 rng(31337);
+    Engines e;
+
+    for ( unsigned i = 0; i < 8000; ++i )
+        e.add(make_text(rng, "abcdefghijklmnopqrstuvwxyz0123456789", 8 + rng() % 12), true, i + 1);
+
+    e.compile();
+
+    for ( unsigned i = 0; i < 4; ++i )
+    {
+        std::string s = make_text(rng, "abcdefghijklmnopqrstuvwxyz0123456789", 4096);
+        e.check(s, 0);
+    }
+}
+
+TEST_CASE("compact cache", "[ac_compact]")
+{
+    acsmx2_init_xlatcase();
+    std::mt19937 rng(2021);
+
+    char dir[] = "/tmp/ac_compact_test.XXXXXX";
+    REQUIRE(mkdtemp(dir));
+
+    snort::SnortConfig sc;
+    sc.fast_pattern_config->set_cache_dir(dir);
+
+    std::vector<std::string> pats;
+    std::vector<bool> no_case;
+
+    for ( unsigned i = 0; i < 300; ++i )
+    {
+        pats.emplace_back(make_text(rng, "abcdeABCDE!", 1 + rng() % 12));
+        no_case.push_back(rng() & 1);
+    }
+
+    std::string s = make_text(rng, "abcdeABCDE!", 2000);
+    const uint8_t* T = (const uint8_t*)s.c_str();
+    snort::MpseCache::reset_stats();
+
+    auto compile = [&](AcsmCompact& acc)
+    {
+        for ( unsigned i = 0; i < pats.size(); ++i )
+            acc.add_pattern((const uint8_t*)pats[i].c_str(), pats[i].size(), no_case[i],
+                false, (void*)(uintptr_t)(i + 1));
+        acc.compile(&sc);
+    };
+
+    auto scan = [&](AcsmCompact& acc)
+    {
+        Hits h;
+        int state = 0;
+        acc.search(T, s.size(), match, &h, &state);
+        return h.index;
+    };
+
+    const auto& stats = snort::MpseCache::get_stats();
+    std::vector<int> ref;
+
+    {
+        AcsmCompact a(&s_agent);
+        compile(a);
+        ref = scan(a);
+
+        CHECK(stats.misses == 1);
+        CHECK(stats.stores == 1);
+    }
+
+    // nothing left to share so this comes from the file
+    AcsmCompact b(&s_agent);
+    compile(b);
+
+    CHECK(stats.hits == 1);
+    CHECK(stats.shared == 0);
+    CHECK((scan(b) == ref));
+
+    // a different pattern set is a different entry
+    pats.pop_back();
+    std::vector<int> ref_c;
+
+    {
+        AcsmCompact c(&s_agent);
+        compile(c);
+        ref_c = scan(c);
+
+        CHECK(stats.misses == 2);
+        CHECK(stats.stores == 2);
+    }
+
+    // damaged entries are rebuilt
+    Directory d(dir);
+    while ( const char* f = d.next() )
+    {
+        std::fstream file(f, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(100);
+        file.write("\xff\xff\xff\xff\xff\xff\xff\xff", 8);
+    }
+
+    AcsmCompact e(&s_agent);
+    compile(e);
+    CHECK(stats.hits == 1);
+    CHECK((scan(e) == ref_c));
+
+    Directory r(dir);
+    while ( const char* f = r.next() )
+        unlink(f);
+    rmdir(dir);
+}
+
+static int user_match(void* user, void*, int index, void* context, void*)
+{
+    auto v = (std::vector<std::pair<uintptr_t, int>>*)context;
+    v->emplace_back((uintptr_t)user, index);
+    return 0;
+}
+
+TEST_CASE("compact shared dfa", "[ac_compact]")
+{
+    std::mt19937 rng(1624);
+    snort::SnortConfig sc;
+    snort::MpseCache::reset_stats();
+
+    std::vector<std::string> pats;
+
+    for ( unsigned i = 0; i < 200; ++i )
+        pats.emplace_back(make_text(rng, "abcdefgh", 2 + rng() % 8));
+
+    std::string s = make_text(rng, "abcdefgh", 4000);
+    const uint8_t* T = (const uint8_t*)s.c_str();
+
+    auto compile = [&](AcsmCompact& acc, uintptr_t base)
+    {
+        for ( unsigned i = 0; i < pats.size(); ++i )
+            acc.add_pattern((const uint8_t*)pats[i].c_str(), pats[i].size(), true,
+                false, (void*)(base + i));
+        acc.compile(&sc);
+    };
+
+    auto scan = [&](AcsmCompact& acc)
+    {
+        std::vector<std::pair<uintptr_t, int>> hits;
+        int state = 0;
+        acc.search(T, s.size(), user_match, &hits, &state);
+        return hits;
+    };
+
+    const auto& stats = snort::MpseCache::get_stats();
+
+    // the old config is still alive when the new one is compiled
+    auto* old_conf = new AcsmCompact(&s_agent);
+    compile(*old_conf, 1000);
+    CHECK(stats.shared == 0);
+
+    AcsmCompact new_conf(&s_agent);
+    compile(new_conf, 5000);
+    CHECK(stats.shared == 1);
+
+    auto a = scan(*old_conf);
+    auto b = scan(new_conf);
+    REQUIRE(a.size() == b.size());
+    REQUIRE(!a.empty());
+
+    // same matches but each instance reports its own user data
+    for ( unsigned i = 0; i < a.size(); ++i )
+    {
+        CHECK(a[i].first - 1000 == b[i].first - 5000);
+        CHECK(a[i].second == b[i].second);
+    }
+
+    // the new instance keeps working after the old one is released
+    delete old_conf;
+    CHECK((scan(new_conf) == b));
+
+    // a changed pattern set is compiled
+    pats.back() = "zzzz";
+    AcsmCompact changed(&s_agent);
+    compile(changed, 9000);
+    CHECK(stats.shared == 1);
+}
+
+//-------------------------------------------------------------------------
+// benchmarks
+//-------------------------------------------------------------------------
+
+#ifdef BENCHMARK_TEST
+
+static int count_match(void*, void*, int, void* context, void*)
+{
+    ++*(unsigned*)context;
+    return 0;
+}
+
+TEST_CASE("compact vs full", "[ac_compact]")
+{
+    acsmx2_init_xlatcase();
+    acsmx2_set_kernel(AcsmKernel::BYTE);
+    std::mt19937 rng(4321);
+    Engines e;
+
+    const char* alpha = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789/.=&?";
+
+    for ( unsigned i = 0; i < 40000; ++i )
+        e.add(make_text(rng, alpha, 4 + rng() % 13), true, i + 1);
+
+    e.compile();
+
+    std::string s = make_text(rng, "etaoinshrdlucmfwyp ETAOINSHRDLU/.=\r\n", 1460);
+    const uint8_t* T = (const uint8_t*)s.c_str();
+    unsigned hits = 0;
+
+    BENCHMARK("ac_full 40K patterns")
+    {
+        int state = 0;
+        return acsm_search_dfa_full(e.full, T, s.size(), count_match, &hits, &state);
+    };
+
+    BENCHMARK("ac_compact 40K patterns")
+    {
+        int state = 0;
+        return e.compact.search(T, s.size(), count_match, &hits, &state);
+    };
+}
+
+#endif
@@ -0,0 +1,312 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2021-2021 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// acsmx2_test.cc - strided full matrix dfa search checks and benchmarks
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "catch/catch.hpp"
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "search_engines/acsmx2.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+//-------------------------------------------------------------------------
+// stubs
+//-------------------------------------------------------------------------
+
+namespace snort
+{
+void LogValue(const char*, const char*, FILE*) { }
+void LogMessage(const char*, ...) { }
+void LogCount(char const*, uint64_t, FILE*) { }
+void LogStat(const char*, double, FILE*) { }
+}
+
+static MpseAgent s_agent =
+{
+    [](snort::SnortConfig*, void* id, void** ppt)
+    {
+        if ( id )
+            *ppt = id;
+        return 0;
+    },
+    [](void*, void**) { return 0; },
+
+    [](void*) { },
+    [](void**) { },
+    [](void**) { }
+};
+
+//-------------------------------------------------------------------------
+// helpers
+//-------------------------------------------------------------------------
+
+struct Hit
+{
+    uintptr_t id;
+    int index;
+
+    bool operator==(const Hit& h) const
+    { return id == h.id and index == h.index; }
+};
+
+struct Hits
+{
+    std::vector<Hit> hits;
+    unsigned stop_at = 0;  // return 1 on this hit if non-zero
+};
+
+static int match(void* id, void*, int index, void* context, void*)
+{
+    Hits* h = (Hits*)context;
+    h->hits.push_back({ (uintptr_t)id, index });
+    return (h->stop_at and h->hits.size() == h->stop_at) ? 1 : 0;
+}
+
+static std::string make_text(std::mt19937& rng, const char* alpha, unsigned n)
+{
+    unsigned len = strlen(alpha);
+    std::string s(n, ' ');
+
+    for ( auto& c : s )
+        c = alpha[rng() % len];
+
+    return s;
+}
+
+static ACSM_STRUCT2* make_acsm(
+    std::mt19937& rng, const char* alpha, unsigned num, unsigned max_len, bool compress,
+    unsigned min_len = 1)
+{
+    ACSM_STRUCT2* acsm = acsmNew2(&s_agent, ACF_FULL);
+    acsmCompressStates(acsm, compress);
+    acsm->enable_dfa();
+
+    for ( unsigned i = 0; i < num; ++i )
+    {
+        std::string p = make_text(rng, alpha, min_len + rng() % (max_len - min_len + 1));
+        acsmAddPattern2(acsm, (const uint8_t*)p.c_str(), p.size(), rng() & 1, false,
+            (void*)(uintptr_t)(i + 1));
+    }
+    acsmCompile2(nullptr, acsm);
+    return acsm;
+}
+
+typedef int (*SearchFunc)(
+    ACSM_STRUCT2*, const uint8_t*, int, MpseMatch, void*, int*);
+
+static int search(
+    AcsmKernel k, SearchFunc f, ACSM_STRUCT2* acsm, const std::string& s,
+    Hits& h, int& state)
+{
+    acsmx2_set_kernel(k);
+    return f(acsm, (const uint8_t*)s.c_str(), s.size(), match, &h, &state);
+}
+
+static void check_kernels(ACSM_STRUCT2* acsm, const std::string& s, unsigned stop_at)
+{
+    const AcsmKernel kernels[] =
+    { AcsmKernel::STRIDED, AcsmKernel::STRIDED_SSE2, AcsmKernel::STRIDED_AVX2 };
+    const SearchFunc funcs[] = { acsm_search_dfa_full, acsm_search_dfa_full_all };
+
+    for ( auto f : funcs )
+    {
+        for ( int start : { 0, 1 } )
+        {
+            Hits ref;
+            ref.stop_at = stop_at;
+            int ref_state = start;
+            int ref_found = search(AcsmKernel::BYTE, f, acsm, s, ref, ref_state);
+
+            for ( auto k : kernels )
+            {
+                if ( !acsmx2_set_kernel(k) )
+                    continue;
+
+                Hits h;
+                h.stop_at = stop_at;
+                int state = start;
+                int found = search(k, f, acsm, s, h, state);
+
+                CHECK(found == ref_found);
+                CHECK(state == ref_state);
+                CHECK((h.hits == ref.hits));
+            }
+        }
+    }
+}
+
+//-------------------------------------------------------------------------
+// tests
+//-------------------------------------------------------------------------
+
+TEST_CASE("strided matches byte walk", "[acsmx2]")
+{
+    acsmx2_init_xlatcase();
+    std::mt19937 rng(1234);
+
+    // small alphabets give dense matches and overflow the stride buffers
+    const char* alphas[] = { "abAB", "abcdeABCDE!", "etaoinshrdlu ETAOIN\xe9\xc9\x80" };
+
+    for ( auto alpha : alphas )
+    {
+        for ( bool compress : { true, false } )
+        {
+            for ( unsigned num : { 1, 10, 300 } )
+            {
+                ACSM_STRUCT2* acsm = make_acsm(rng, alpha, num, 12, compress);
+
+                for ( unsigned len : { 100, 511, 512, 777, 4096, 9000 } )
+                {
+                    std::string s = make_text(rng, alpha, len);
+                    check_kernels(acsm, s, 0);
+                    check_kernels(acsm, s, 1);
+                    check_kernels(acsm, s, 37);
+                    check_kernels(acsm, s, 200);
+                }
+                acsmFree2(acsm);
+            }
+        }
+    }
+    acsmx2_init_xlatcase();
+}
+
+TEST_CASE("strided long patterns", "[acsmx2]")
+{
+    acsmx2_init_xlatcase();
+    std::mt19937 rng(99);
+
+    ACSM_STRUCT2* acsm = make_acsm(rng, "xyXY", 20, 100, true);
+
+    // too short for the strided walk, which falls back to the byte walk
+    std::string s = make_text(rng, "xyXY", 1000);
+    check_kernels(acsm, s, 0);
+
+    s = make_text(rng, "xyXY", 20000);
+    check_kernels(acsm, s, 0);
+    check_kernels(acsm, s, 500);
+
+    acsmFree2(acsm);
+    acsmx2_init_xlatcase();
+}
+
+TEST_CASE("kernel selection", "[acsmx2]")
+{
+    acsmx2_init_xlatcase();
+    CHECK(acsmx2_get_kernel() != AcsmKernel::BYTE);
+
+    CHECK(acsmx2_set_kernel(AcsmKernel::BYTE));
+    CHECK(acsmx2_get_kernel() == AcsmKernel::BYTE);
+    CHECK(!strcmp(acsmx2_get_kernel_name(AcsmKernel::BYTE), "byte"));
+
+    CHECK(acsmx2_set_kernel(AcsmKernel::STRIDED));
+    CHECK(acsmx2_get_kernel() == AcsmKernel::STRIDED);
+
+    acsmx2_init_xlatcase();
+}
+
+//-------------------------------------------------------------------------
+// benchmarks
+//-------------------------------------------------------------------------
+
+#ifdef BENCHMARK_TEST
+
+static int count_match(void*, void*, int, void* context, void*)
+{
+    ++*(unsigned*)context;
+    return 0;
+}
+
+static void bytes_per_cycle(ACSM_STRUCT2* acsm, const std::string& s)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    const AcsmKernel kernels[] =
+    {
+        AcsmKernel::BYTE, AcsmKernel::STRIDED,
+        AcsmKernel::STRIDED_SSE2, AcsmKernel::STRIDED_AVX2
+    };
+    const unsigned loops = 200;
+
+    for ( auto k : kernels )
+    {
+        if ( !acsmx2_set_kernel(k) )
+            continue;
+
+        unsigned hits = 0;
+        uint64_t start = __rdtsc();
+
+        for ( unsigned i = 0; i < loops; ++i )
+        {
+            int state = 0;
+            acsm_search_dfa_full(
+                acsm, (const uint8_t*)s.c_str(), s.size(), count_match, &hits, &state);
+        }
+        uint64_t cycles = __rdtsc() - start;
+
+        printf("%-14s %6.3f bytes/cycle\n", acsmx2_get_kernel_name(k),
+            (double)s.size() * loops / cycles);
+    }
+#else
+    (void)acsm; (void)s;
+#endif
+}
+
+TEST_CASE("acsmx2 full matrix search", "[acsmx2]")
+{
+    acsmx2_init_xlatcase();
+    std::mt19937 rng(4321);
+
+    // roughly a port group worth of content over mostly clean traffic
+    ACSM_STRUCT2* acsm = make_acsm(
+        rng, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789/.=&?", 5000, 16, true, 4);
+
+    std::string s = make_text(rng, "etaoinshrdlucmfwyp ETAOINSHRDLU/.=\r\n", 64 * 1024);
+    unsigned hits = 0;
+
+    bytes_per_cycle(acsm, s);
+
+    acsmx2_set_kernel(AcsmKernel::BYTE);
+    BENCHMARK("byte 64K")
+    {
+        int state = 0;
+        return acsm_search_dfa_full(
+            acsm, (const uint8_t*)s.c_str(), s.size(), count_match, &hits, &state);
+    };
+
+    acsmx2_init_xlatcase();
+    BENCHMARK("strided 64K")
+    {
+        int state = 0;
+        return acsm_search_dfa_full(
+            acsm, (const uint8_t*)s.c_str(), s.size(), count_match, &hits, &state);
+    };
+
+    acsmFree2(acsm);
+}
+
+#endif
@@ -28,6 +28,7 @@
 #include "framework/counts.h"
 #include "framework/mpse.h"
 #include "framework/mpse_batch.h"
+#include "helpers/mpse_cache.h"
 #include "main/snort_config.h"
 #include "utils/stats.h"
 
@@ -43,7 +44,7 @@ using namespace snort;
 
 namespace snort
 {
-Mpse::Mpse(const char*) { }
+Mpse::Mpse(const char*) : api(nullptr) { }
 
 int Mpse::search(
     const unsigned char* T, int n, MpseMatch match,
@@ -95,6 +96,28 @@ void Mpse::_search(MpseBatch& batch, MpseType mpse_type)
     }
 }
 
+void Mpse::search(MpseBatch** batches, unsigned n, MpseType mpse_type)
+{
+    _search(batches, n, mpse_type);
+}
+
+void Mpse::_search(MpseBatch** batches, unsigned n, MpseType mpse_type)
+{
+    for ( unsigned i = 0; i < n; ++i )
+        _search(*batches[i], mpse_type);
+}
+
+MpseGroup::~MpseGroup() = default;
+
+MpseCacheStats MpseCache::stats;
+MpseCache::MpseCache(const SnortConfig*, const char*, unsigned) { }
+void MpseCache::update(const void*, size_t) { }
+bool MpseCache::load(std::vector<uint8_t>&) { return false; }
+void MpseCache::reject() { }
+bool MpseCache::store(const void*, size_t) { return false; }
+std::shared_ptr<const void> MpseCache::find_shared_state() { return nullptr; }
+void MpseCache::share(const std::shared_ptr<const void>&) { }
+
 SnortConfig s_conf;
 THREAD_LOCAL SnortConfig* snort_conf = &s_conf;
 
@@ -425,6 +448,47 @@ TEST(mpse_hs_multi, single)
     CHECK(hits == 1);
 }
 
+// packets searched together match as they do one at a time
+TEST(mpse_hs_multi, batches)
+{
+    Mpse::PatternDescriptor desc;
+
+    CHECK(hs1->add_pattern((const uint8_t*)"uba", 3, desc, s_user) == 0);
+    CHECK(hs2->add_pattern((const uint8_t*)"tuba", 4, desc, s_user) == 0);
+
+    CHECK(hs1->prep_patterns(snort_conf) == 0);
+    CHECK(hs2->prep_patterns(snort_conf) == 0);
+
+    do_cleanup = scratcher->setup(snort_conf);
+
+    MpseGroup g1(hs1);
+    MpseGroup g2(hs2);
+
+    const char* text[] = { "fubar", "tuba", "snafu" };
+    MpseBatch batches[3];
+    MpseBatch* pb[3];
+
+    for ( unsigned i = 0; i < 3; ++i )
+    {
+        batches[i].mf = match;
+        batches[i].context = nullptr;
+
+        MpseBatchKey<> key((const uint8_t*)text[i], strlen(text[i]));
+        auto& item = batches[i].items[key];
+        item.so.push_back(&g1);
+        item.so.push_back(&g2);
+        pb[i] = &batches[i];
+    }
+
+    hs1->search(pb, 3, Mpse::MPSE_TYPE_NORMAL);
+    CHECK(hits == 3);
+
+    CHECK(batches[0].items.begin()->second.matches == 1);
+    CHECK(batches[1].items.begin()->second.matches == 2);
+    CHECK(batches[2].items.begin()->second.matches == 0);
+    CHECK(batches[2].items.begin()->second.done);
+}
+
 //-------------------------------------------------------------------------
 // main
 //-------------------------------------------------------------------------
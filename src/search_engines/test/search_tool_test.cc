@@ -149,6 +149,12 @@ void Mpse::_search(MpseBatch& batch, MpseType mpse_type)
     }
 }
 
+void Mpse::_search(MpseBatch** batches, unsigned n, MpseType mpse_type)
+{
+    for ( unsigned i = 0; i < n; ++i )
+        _search(*batches[i], mpse_type);
+}
+
 }
 
 const char* FastPatternConfig::get_search_method()
@@ -39,6 +39,9 @@ public:
     bool is_paf() override
     { return true; }
 
+    bool plain_reassembly() override
+    { return false; }
+
     bool cutover_inspector()
     { return cutover; }
 
@@ -86,6 +86,9 @@ public:
 
     size_t size_of() override;
 
+    bool can_defer_delete() const override
+    { return true; }
+
     Http2Stream* find_current_stream(const HttpCommon::SourceId source_id) const;
     uint32_t get_current_stream_id(const HttpCommon::SourceId source_id) const;
     Http2Stream* get_processing_stream(const HttpCommon::SourceId source_id, uint32_t concurrent_streams_limit);
@@ -52,6 +52,8 @@ uint64_t HttpFlowData::instance_count = 0;
 
 HttpFlowData::HttpFlowData(Flow* flow) : FlowData(inspector_id)
 {
+    set_arena(memory::Arena::HTTP_INSPECT);
+
 #ifdef REG_TEST
     if (HttpTestManager::use_test_output(HttpTestManager::IN_HTTP))
     {
@@ -54,6 +54,9 @@ public:
     static void init() { inspector_id = snort::FlowData::create_flow_data_id(); }
     size_t size_of() override;
 
+    bool can_defer_delete() const override
+    { return true; }
+
     friend class HttpBodyCutter;
     friend class HttpInspect;
     friend class HttpJsNorm;
@@ -45,6 +45,7 @@ public:
     bool finish(snort::Flow* flow) override;
     bool prep_partial_flush(snort::Flow* flow, uint32_t num_flush);
     bool is_paf() override { return true; }
+    bool plain_reassembly() override { return false; }
     static StreamSplitter::Status status_value(StreamSplitter::Status ret_val, bool http2 = false);
 
     // FIXIT-M should return actual packet buffer size
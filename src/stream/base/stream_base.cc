@@ -25,16 +25,19 @@
 #include "detection/ips_context.h"
 #include "flow/expect_cache.h"
 #include "flow/flow_control.h"
+#include "flow/flow_data_queue.h"
 #include "flow/prune_stats.h"
 #include "framework/data_bus.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
 #include "main/snort_types.h"
 #include "managers/inspector_manager.h"
+#include "memory/memory_reclaim.h"
 #include "profiler/profiler_defs.h"
 #include "protocols/packet.h"
 #include "protocols/tcp.h"
 #include "stream/flush_bucket.h"
+#include "stream/stream.h"
 #include "stream/tcp/tcp_stream_tracker.h"
 
 #include "stream_ha.h"
@@ -57,13 +60,25 @@ const PegInfo base_pegs[] =
 {
     { CountType::SUM, "flows", "total sessions" },
     { CountType::SUM, "total_prunes", "total sessions pruned" },
-    { CountType::SUM, "idle_prunes", " sessions pruned due to timeout" },
+    { CountType::SUM, "idle_prunes", "idle sessions pruned to make room for new ones" },
     { CountType::SUM, "excess_prunes", "sessions pruned due to excess" },
     { CountType::SUM, "uni_prunes", "uni sessions pruned" },
     { CountType::SUM, "preemptive_prunes", "sessions pruned during preemptive pruning" },
     { CountType::SUM, "memcap_prunes", "sessions pruned due to memcap" },
     { CountType::SUM, "ha_prunes", "sessions pruned by high availability sync" },
     { CountType::SUM, "stale_prunes", "sessions pruned due to stale connection" },
+    { CountType::SUM, "timeouts", "sessions retired at their idle or hard timeout" },
+    { CountType::SUM, "timeout_rearms", "timeouts rescheduled because the session was active" },
+    { CountType::SUM, "ip_prunes", "ip sessions pruned before timing out" },
+    { CountType::SUM, "tcp_prunes", "tcp sessions pruned before timing out" },
+    { CountType::SUM, "udp_prunes", "udp sessions pruned before timing out" },
+    { CountType::SUM, "icmp_prunes", "icmp sessions pruned before timing out" },
+    { CountType::SUM, "user_prunes", "user sessions pruned before timing out" },
+    { CountType::SUM, "file_prunes", "file sessions pruned before timing out" },
+    { CountType::SUM, "flow_data_deferred", "flow data of released sessions queued for deletion" },
+    { CountType::SUM, "flow_data_deleted", "queued flow data deleted" },
+    { CountType::NOW, "flow_data_queued", "flow data waiting for deletion" },
+    { CountType::MAX, "flow_data_queue_max", "maximum flow data waiting for deletion" },
     { CountType::SUM, "expected_flows", "total expected flows created within snort" },
     { CountType::SUM, "expected_realized", "number of expected flows realized" },
     { CountType::SUM, "expected_pruned", "number of expected flows pruned" },
@@ -94,6 +109,20 @@ void base_prep()
     stream_base_stats.memcap_prunes = flow_con->get_prunes(PruneReason::MEMCAP);
     stream_base_stats.ha_prunes = flow_con->get_prunes(PruneReason::HA);
     stream_base_stats.stale_prunes = flow_con->get_prunes(PruneReason::STALE);
+    stream_base_stats.timeouts = flow_con->get_prunes(PruneReason::TIMEOUT);
+    stream_base_stats.timeout_rearms = flow_con->get_timer_rearms();
+    stream_base_stats.ip_prunes = flow_con->get_type_prunes(PktType::IP);
+    stream_base_stats.tcp_prunes = flow_con->get_type_prunes(PktType::TCP);
+    stream_base_stats.udp_prunes = flow_con->get_type_prunes(PktType::UDP);
+    stream_base_stats.icmp_prunes = flow_con->get_type_prunes(PktType::ICMP);
+    stream_base_stats.user_prunes = flow_con->get_type_prunes(PktType::PDU);
+    stream_base_stats.file_prunes = flow_con->get_type_prunes(PktType::FILE);
+
+    const FlowDataQueueStats& fdq = flow_con->get_flow_data_stats();
+    stream_base_stats.flow_data_deferred = fdq.deferred;
+    stream_base_stats.flow_data_deleted = fdq.deleted;
+    stream_base_stats.flow_data_queued = flow_con->get_flow_data_queued();
+    stream_base_stats.flow_data_queue_max = fdq.max_depth;
     stream_base_stats.reload_freelist_flow_deletes = flow_con->get_deletes(FlowDeleteState::FREELIST);
     stream_base_stats.reload_allowed_flow_deletes = flow_con->get_deletes(FlowDeleteState::ALLOWED);
     stream_base_stats.reload_offloaded_flow_deletes= flow_con->get_deletes(FlowDeleteState::OFFLOADED);
@@ -326,6 +355,42 @@ static void base_dtor(Inspector* p)
     delete p;
 }
 
+//-------------------------------------------------------------------------
+// memory reclaim
+//-------------------------------------------------------------------------
+
+// deleting queued flow data is cheap and frees the most per step
+static const unsigned flow_data_per_step = 8;
+
+static bool reclaim_flow_data(bool)
+{ return flow_con and flow_con->delete_flow_data(flow_data_per_step) > 0; }
+
+static size_t flow_data_held()
+{ return flow_con ? flow_con->get_flow_data_bytes() : 0; }
+
+static bool reclaim_flows(bool over_cap)
+{ return Stream::prune_flow(over_cap); }
+
+static size_t flows_held()
+{ return flow_con ? flow_con->get_memory_held() : 0; }
+
+static void base_pinit()
+{
+    memory::Reclaimer flow_data;
+    flow_data.reclaim = reclaim_flow_data;
+    flow_data.held = flow_data_held;
+    flow_data.cost = 1;
+    flow_data.benefit = flow_data_per_step * 4096;
+    memory::MemoryReclaim::add(memory::Consumer::FLOW_DATA, flow_data);
+
+    memory::Reclaimer flows;
+    flows.reclaim = reclaim_flows;
+    flows.held = flows_held;
+    flows.cost = 8;
+    flows.benefit = 16384;
+    memory::MemoryReclaim::add(memory::Consumer::FLOWS, flows);
+}
+
 static void base_tinit()
 {
     TcpStreamTracker::thread_init();
@@ -356,7 +421,7 @@ static const InspectApi base_api =
     PROTO_BIT__ANY_SSN,
     nullptr, // buffers
     nullptr, // service
-    nullptr, // init
+    base_pinit,
     nullptr, // term
     base_tinit,
     base_tterm,
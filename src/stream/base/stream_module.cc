@@ -51,6 +51,9 @@ static const Parameter name[] = \
  \
     { "cap_weight", Parameter::PT_INT, "0:65535", weight, \
       "additional bytes to track per flow for better estimation against cap" }, \
+ \
+    { "share", Parameter::PT_INT, "0:100", "0", \
+      "percent of max_flows kept for this type when pruning; 0 for none" }, \
  \
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr } \
 }
@@ -82,6 +85,19 @@ static const Parameter s_params[] =
     { "pruning_timeout", Parameter::PT_INT, "1:max32", "30",
       "minimum inactive time before being eligible for pruning" },
 
+    { "flow_table", Parameter::PT_ENUM, "chained | open", "chained",
+      "hash table used to store flows; open addressing trades memory for fewer cache misses" },
+
+    { "prefetch_window", Parameter::PT_INT, "0:max32", "0",
+      "number of packets in each DAQ batch whose flows are prefetched ahead of processing" },
+
+#ifdef REG_TEST
+    { "release_budget", Parameter::PT_INT, "0:max32", "0",
+#else
+    { "release_budget", Parameter::PT_INT, "0:max32", "16",
+#endif
+      "flow data of released flows deleted per packet; 0 to delete with the flow" },
+
     { "held_packet_timeout", Parameter::PT_INT, "1:max32", "1000",
       "timeout in milliseconds for held packets" },
 
@@ -178,6 +194,21 @@ bool StreamModule::set(const char* fqn, Value& v, SnortConfig* c)
         config.flow_cache_cfg.pruning_timeout = v.get_uint32();
         return true;
     }
+    else if ( v.is("flow_table") )
+    {
+        config.flow_cache_cfg.table_type = (FlowTableType)v.get_uint8();
+        return true;
+    }
+    else if ( v.is("prefetch_window") )
+    {
+        config.flow_cache_cfg.prefetch_window = v.get_uint32();
+        return true;
+    }
+    else if ( v.is("release_budget") )
+    {
+        config.flow_cache_cfg.release_budget = v.get_uint32();
+        return true;
+    }
     else if ( v.is("held_packet_timeout") )
     {
         config.held_packet_timeout = v.get_uint32();
@@ -202,12 +233,29 @@ bool StreamModule::set(const char* fqn, Value& v, SnortConfig* c)
         config.flow_cache_cfg.proto[to_utype(type)].nominal_timeout = v.get_uint32();
     else if ( v.is("cap_weight") )
         config.flow_cache_cfg.proto[to_utype(type)].cap_weight = v.get_uint16();
+    else if ( v.is("share") )
+        config.flow_cache_cfg.proto[to_utype(type)].share = v.get_uint8();
 
     return true;
 }
 
 bool StreamModule::end(const char* fqn, int, SnortConfig* sc)
 {
+    if ( !strcmp(fqn, MOD_NAME) )
+    {
+        unsigned shares = 0;
+
+        for ( const auto& p : config.flow_cache_cfg.proto )
+            shares += p.share;
+
+        if ( shares > 100 )
+        {
+            ParseError("%s: cache shares add up to %u%%; must not exceed 100%%",
+                MOD_NAME, shares);
+            return false;
+        }
+    }
+
     if ( Snort::is_reloading() && strcmp(fqn, MOD_NAME) == 0 )
     {
         StreamReloadResourceManager* reload_resource_manager = new StreamReloadResourceManager;
@@ -340,12 +388,17 @@ void StreamModuleConfig::show() const
     ConfigLogger::log_value("max_flows", flow_cache_cfg.max_flows);
     ConfigLogger::log_value("max_aux_ip", SnortConfig::get_conf()->max_aux_ip);
     ConfigLogger::log_value("pruning_timeout", flow_cache_cfg.pruning_timeout);
+    ConfigLogger::log_value("flow_table",
+        flow_cache_cfg.table_type == FlowTableType::OPEN ? "open" : "chained");
+    ConfigLogger::log_value("prefetch_window", flow_cache_cfg.prefetch_window);
+    ConfigLogger::log_value("release_budget", flow_cache_cfg.release_budget);
 
     for (int i = to_utype(PktType::IP); i < to_utype(PktType::MAX); ++i)
     {
         std::string tmp;
         tmp += "{ idle_timeout = " + std::to_string(flow_cache_cfg.proto[i].nominal_timeout);
         tmp += ", cap_weight = " + std::to_string(flow_cache_cfg.proto[i].cap_weight);
+        tmp += ", share = " + std::to_string(flow_cache_cfg.proto[i].share);
         tmp += " }";
 
         ConfigLogger::log_value(flow_type_names[i], tmp.c_str());
@@ -55,6 +55,18 @@ struct BaseStats
      PegCount memcap_prunes;
      PegCount ha_prunes;
      PegCount stale_prunes;
+     PegCount timeouts;
+     PegCount timeout_rearms;
+     PegCount ip_prunes;
+     PegCount tcp_prunes;
+     PegCount udp_prunes;
+     PegCount icmp_prunes;
+     PegCount user_prunes;
+     PegCount file_prunes;
+     PegCount flow_data_deferred;
+     PegCount flow_data_deleted;
+     PegCount flow_data_queued;
+     PegCount flow_data_queue_max;
      PegCount expected_flows;
      PegCount expected_realized;
      PegCount expected_pruned;
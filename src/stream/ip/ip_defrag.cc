@@ -70,13 +70,15 @@
 
 #include "ip_defrag.h"
 
+#include <vector>
+
 #include "detection/detect.h"
 #include "detection/detection_engine.h"
 #include "log/messages.h"
 #include "main/analyzer.h"
 #include "main/snort_config.h"
 #include "main/snort_debug.h"
-#include "memory/memory_cap.h"
+#include "memory/slab_allocator.h"
 #include "packet_io/active.h"
 #include "packet_io/sfdaq_config.h"
 #include "profiler/profiler_defs.h"
@@ -119,6 +121,10 @@ using namespace snort;
 /*  D A T A   S T R U C T U R E S  **********************************/
 
 
+// fragments and their data are carved from per thread slabs, which also
+// charge MemoryCap.  the classes cover the usual mtu sizes.
+static THREAD_LOCAL memory::SlabAllocator* frag_slabs = nullptr;
+
 struct Fragment
 {
     Fragment(uint16_t flen, const uint8_t* fptr, int ord)
@@ -135,11 +141,19 @@ struct Fragment
 
     ~Fragment()
     {
-        delete[] fptr;
+        memory::SlabAllocator::deallocate(fptr);
         ip_stats.nodes_released++;
-        memory::MemoryCap::update_deallocations(sizeof(*this) + flen);
     }
 
+    static void* operator new(size_t n)
+    {
+        assert(frag_slabs);
+        return frag_slabs->allocate(n);
+    }
+
+    static void operator delete(void* p)
+    { memory::SlabAllocator::deallocate(p); }
+
     uint8_t* data = nullptr;    /* ptr to adjusted start position */
     uint16_t size = 0;          /* adjusted frag size */
     uint16_t offset = 0;        /* adjusted offset position */
@@ -157,10 +171,9 @@ private:
     inline void init(uint16_t flen, const uint8_t* fptr, int ord)
     {
         assert(flen > 0);
-        memory::MemoryCap::update_allocations(sizeof(*this) + flen);
 
         this->flen = flen;
-        this->fptr = new uint8_t[flen];
+        this->fptr = (uint8_t*)frag_slabs->allocate(flen);
         this->ord = ord;
 
         memcpy(this->fptr, fptr, flen);
@@ -831,6 +844,19 @@ static void release_tracker(FragTracker* ft)
 
 Defrag::Defrag(FragEngine& e) : engine(e), layers(DEFAULT_LAYERMAX) { }
 
+void Defrag::thread_init()
+{
+    // header sized blocks hold the Fragment nodes
+    const std::vector<size_t> sizes = { sizeof(Fragment), 256, 576, 1500, 9000 };
+    frag_slabs = new memory::SlabAllocator(sizes, ip_stats.slab, memory::Arena::DEFRAG);
+}
+
+void Defrag::thread_term()
+{
+    delete frag_slabs;
+    frag_slabs = nullptr;
+}
+
 bool Defrag::configure(SnortConfig* sc)
 {
     // FIXIT-L kinda squiffy ... set for each instance (but to same value) ... move to tinit() ?
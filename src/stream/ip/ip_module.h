@@ -23,6 +23,7 @@
 
 #include "flow/session.h"
 #include "framework/module.h"
+#include "memory/slab_allocator.h"
 
 namespace snort
 {
@@ -81,6 +82,7 @@ struct IpStats
     PegCount nodes_released;
     PegCount reassembled_bytes; // total_ipreassembled_bytes
     PegCount fragmented_bytes;  // total_ipfragmented_bytes
+    memory::SlabStats slab;
 };
 
 extern const PegInfo ip_pegs[];
@@ -60,6 +60,7 @@ const PegInfo ip_pegs[] =
     { CountType::SUM, "nodes_deleted", "fragments deleted from tracker" },
     { CountType::SUM, "reassembled_bytes", "total reassembled bytes" },
     { CountType::SUM, "fragmented_bytes", "total fragmented bytes" },
+    SLAB_PEGS("ip fragment"),
     { CountType::END, nullptr, nullptr }
 };
 
@@ -137,10 +137,12 @@ static void mod_dtor(Module* m)
 static void ip_tinit()
 {
     IpHAManager::tinit();
+    Defrag::thread_init();
 }
 
 static void ip_tterm()
 {
+    Defrag::thread_term();
     IpHAManager::tterm();
 }
 
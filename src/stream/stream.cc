@@ -24,6 +24,7 @@
 #include "stream.h"
 
 #include <cassert>
+#include <climits>
 #include <mutex>
 
 #include "detection/detection_engine.h"
@@ -360,23 +361,62 @@ void Stream::purge_flows()
         flow_con->purge_flows();
 }
 
+// flows retired per packet; the rest of those due wait for the next
+// packet or idle
+static const unsigned max_timeouts_per_packet = 4;
+
+static unsigned get_release_budget(unsigned packets)
+{
+    uint64_t n = (uint64_t)flow_con->get_flow_cache_config().release_budget * packets;
+    return n < UINT_MAX ? (unsigned)n : UINT_MAX;
+}
+
 void Stream::handle_timeouts(bool idle)
 {
     timeval cur_time;
     packet_gettimeofday(&cur_time);
 
-    // FIXIT-M batch here or loop vs looping over idle?
     if ( flow_con )
-        flow_con->timeout_flows(cur_time.tv_sec);
+    {
+        unsigned max = idle ? UINT_MAX : max_timeouts_per_packet;
+        flow_con->timeout_flows(max, cur_time.tv_sec);
+    }
 
     int max_remove = idle ? -1 : 1;       // -1 = all eligible
     TcpStreamTracker::release_held_packets(cur_time, max_remove);
+
+    if ( flow_con )
+        flow_con->delete_flow_data(idle ? UINT_MAX : get_release_budget(1));
+}
+
+void Stream::delete_flow_data(unsigned packets)
+{
+    if ( flow_con )
+        flow_con->delete_flow_data(get_release_budget(packets));
+}
+
+void Stream::prefetch_flow(const DAQ_PktHdr_t* pkth, const uint8_t* pkt, uint32_t len)
+{
+    if ( flow_con )
+        flow_con->prefetch_flow(pkth, pkt, len);
 }
 
-void Stream::prune_flows()
+unsigned Stream::get_prefetch_window()
 {
-    if ( flow_con && !FlowCache::is_pruning_in_progress())
-        flow_con->prune_one(PruneReason::MEMCAP, false);
+    return flow_con ? flow_con->get_flow_cache_config().prefetch_window : 0;
+}
+
+// at the cap the thread needs space before the current allocation so the
+// victim is cut loose without flushing.  below it there is time to flush.
+bool Stream::prune_flow(bool over_cap)
+{
+    if ( !flow_con or FlowCache::is_pruning_in_progress() )
+        return false;
+
+    if ( over_cap )
+        return flow_con->prune_one(PruneReason::MEMCAP, false);
+
+    return flow_con->prune_one(PruneReason::PREEMPTIVE, true);
 }
 
 //-------------------------------------------------------------------------
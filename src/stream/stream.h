@@ -77,7 +77,21 @@ public:
     static void purge_flows();
 
     static void handle_timeouts(bool idle);
-    static void prune_flows();
+
+    // Prunes one flow, as chosen by the flow cache, to free memory.
+    // Returns false if none was pruned.
+    static bool prune_flow(bool over_cap);
+
+    // Deletes flow data held back from released flows, up to the per
+    // packet budget for each of the given packets.  Called when a DAQ
+    // batch comes up short since the unused slots can absorb the work.
+    static void delete_flow_data(unsigned packets);
+
+    // Hints that the packet will be processed soon so that its flow can be
+    // prefetched; only the configured window of messages ahead should be
+    // hinted so the prefetched lines are still cached when used.
+    static void prefetch_flow(const DAQ_PktHdr_t*, const uint8_t* pkt, uint32_t len);
+    static unsigned get_prefetch_window();
     static bool expected_flow(Flow*, Packet*);
 
     // Looks in the flow cache for flow session with specified key and returns
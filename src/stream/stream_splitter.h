@@ -79,6 +79,10 @@ public:
         unsigned& copied       // actual data copied (1 <= copied <= len)
         );
 
+    // return false if reassemble() does more than copy the data; otherwise
+    // stream may skip it and inspect the data in place
+    virtual bool plain_reassembly() { return true; }
+
     virtual bool is_paf() { return false; }
     virtual unsigned max(Flow* = nullptr);
     virtual unsigned adjust_to_fit(unsigned len) { return len; }
@@ -23,6 +23,7 @@
 #include "stream_tcp.h"
 
 #include "main/snort_config.h"
+#include "memory/memory_reclaim.h"
 
 #include "tcp_ha.h"
 #include "tcp_module.h"
@@ -115,11 +116,20 @@ static Inspector* tcp_ctor(Module* m)
 static void tcp_dtor(Inspector* p)
 { delete p; }
 
+// segments are freed with their flows, which the flow cache picks by share,
+// so they are reported but not reclaimed here
+static size_t segments_held()
+{ return tcpStats.mem_in_use; }
+
 static void stream_tcp_pinit()
 {
     TcpStateMachine::initialize();
     TcpReassemblerFactory::initialize();
     TcpNormalizerFactory::initialize();
+
+    memory::Reclaimer segs;
+    segs.held = segments_held;
+    memory::MemoryReclaim::add(memory::Consumer::TCP_SEGMENTS, segs);
 }
 
 static void stream_tcp_pterm()
@@ -114,6 +114,9 @@ const PegInfo tcp_pegs[] =
     { CountType::SUM, "partial_fallbacks", "count of fallbacks from assigned service stream splitter" },
     { CountType::MAX, "max_segs", "maximum number of segments queued in any flow" },
     { CountType::MAX, "max_bytes", "maximum number of bytes queued in any flow" },
+    { CountType::SUM, "zero_copy_pdus", "reassembled PDUs inspected in place" },
+    { CountType::SUM, "zero_copy_bytes", "reassembled bytes inspected in place" },
+    SLAB_PEGS("tcp segment"),
     { CountType::END, nullptr, nullptr }
 };
 
@@ -223,6 +226,9 @@ static const Parameter s_params[] =
     { "track_only", Parameter::PT_BOOL, nullptr, "false",
       "disable reassembly if true" },
 
+    { "zero_copy", Parameter::PT_BOOL, nullptr, "false",
+      "inspect PDUs within a single segment in place instead of copying them" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -358,6 +364,13 @@ bool StreamTcpModule::set(const char*, Value& v, SnortConfig*)
         else
             config->flags &= ~STREAM_CONFIG_NO_REASSEMBLY;
     }
+    else if ( v.is("zero_copy") )
+    {
+        if ( v.get_bool() )
+            config->flags |= STREAM_CONFIG_ZERO_COPY;
+        else
+            config->flags &= ~STREAM_CONFIG_ZERO_COPY;
+    }
     else
         return false;
 
@@ -23,6 +23,7 @@
 
 #include "flow/session.h"
 #include "framework/module.h"
+#include "memory/slab_allocator.h"
 #include "stream/tcp/tcp_stream_config.h"
 
 #define GID_STREAM_TCP  129
@@ -112,6 +113,9 @@ struct TcpStats
     PegCount partial_fallbacks;
     PegCount max_segs;
     PegCount max_bytes;
+    PegCount zero_copy_pdus;
+    PegCount zero_copy_bytes;
+    memory::SlabStats slab;
 };
 
 extern THREAD_LOCAL struct TcpStats tcpStats;
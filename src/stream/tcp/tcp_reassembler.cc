@@ -28,6 +28,7 @@
 #include "detection/detection_engine.h"
 #include "log/log.h"
 #include "main/analyzer.h"
+#include "main/snort_config.h"
 #include "memory/memory_cap.h"
 #include "packet_io/active.h"
 #include "profiler/profiler.h"
@@ -372,8 +373,27 @@ void TcpReassembler::show_rebuilt_packet(const TcpReassemblerState& trs, Packet*
     }
 }
 
+// a pdu within one segment can be inspected in place if the splitter would
+// only copy it.  the segment is not purged until after detection unless
+// detection is offloaded or batched, which is therefore excluded.
+bool TcpReassembler::can_zero_copy(
+    TcpReassemblerState& trs, uint32_t flush_len, const Packet* pdu)
+{
+    if ( !(trs.sos.session->tcp_config->flags & STREAM_CONFIG_ZERO_COPY) )
+        return false;
+
+    if ( flush_len > trs.sos.seglist.cur_rseg->c_len )
+        return false;
+
+    if ( pdu->context->conf->offload_enabled() )
+        return false;
+
+    return trs.tracker->get_splitter()->plain_reassembly();
+}
+
 int TcpReassembler::flush_data_segments(TcpReassemblerState& trs, uint32_t flush_len, Packet* pdu)
 {
+    bool zero_copy = can_zero_copy(trs, flush_len, pdu);
     uint32_t flags = PKT_PDU_HEAD;
     uint32_t to_seq = trs.sos.seglist.cur_rseg->c_seq + flush_len;
     uint32_t remaining_bytes = flush_len;
@@ -391,9 +411,21 @@ int TcpReassembler::flush_data_segments(TcpReassemblerState& trs, uint32_t flush
             assert( bytes_to_copy >= tsn->c_len );
 
         unsigned bytes_copied = 0;
-        const StreamBuffer sb = trs.tracker->get_splitter()->reassemble(
-            trs.sos.session->flow, flush_len, total_flushed, tsn->payload(),
-            bytes_to_copy, flags, bytes_copied);
+        StreamBuffer sb;
+
+        if ( zero_copy )
+        {
+            sb = { tsn->payload(), bytes_to_copy };
+            bytes_copied = bytes_to_copy;
+            tcpStats.zero_copy_pdus++;
+            tcpStats.zero_copy_bytes += bytes_copied;
+        }
+        else
+        {
+            sb = trs.tracker->get_splitter()->reassemble(
+                trs.sos.session->flow, flush_len, total_flushed, tsn->payload(),
+                bytes_to_copy, flags, bytes_copied);
+        }
 
         if ( sb.data )
         {
@@ -67,6 +67,7 @@ protected:
     void show_rebuilt_packet(const TcpReassemblerState&, snort::Packet*);
     void flush_queued_segments(
         TcpReassemblerState&, snort::Flow* flow, bool clear, snort::Packet*);
+    bool can_zero_copy(TcpReassemblerState&, uint32_t flush_len, const snort::Packet* pdu);
     int flush_data_segments(TcpReassemblerState&, uint32_t flush_len, snort::Packet* pdu);
     void prep_pdu(
         TcpReassemblerState&, snort::Flow*, snort::Packet*, uint32_t pkt_flags, snort::Packet*);
@@ -25,44 +25,35 @@
 
 #include "tcp_segment_node.h"
 
+#include <cassert>
+#include <vector>
+
 #include "main/thread.h"
-#include "memory/memory_cap.h"
+#include "memory/slab_allocator.h"
 #include "utils/util.h"
 
 #include "segment_overlap_editor.h"
 #include "tcp_module.h"
 
-#define USE_RESERVE
-#ifdef USE_RESERVE
-static THREAD_LOCAL TcpSegmentNode* reserved = nullptr;
-static THREAD_LOCAL unsigned reserve_sz = 0;
-
-static constexpr unsigned num_res = 4096;
-static constexpr unsigned res_min = 1024;
-static constexpr unsigned res_max = 1460;
-#endif
+// size classes cover small segments, a full MSS, and jumbo frames.  the
+// node header is included so each class still holds its nominal payload.
+static THREAD_LOCAL memory::SlabAllocator* slabs = nullptr;
 
 void TcpSegmentNode::setup()
 {
-#ifdef USE_RESERVE
-    reserved = nullptr;
-    reserve_sz = 0;
-#endif
+    const size_t hdr = offsetof(TcpSegmentNode, data);
+    std::vector<size_t> sizes { 64, 256, 512, 1024, 1460, 2048, 9000 };
+
+    for ( auto& n : sizes )
+        n += hdr;
+
+    slabs = new memory::SlabAllocator(sizes, tcpStats.slab, memory::Arena::STREAM_TCP);
 }
 
 void TcpSegmentNode::clear()
 {
-#ifdef USE_RESERVE
-    while ( reserved )
-    {
-        TcpSegmentNode* tsn = reserved;
-        reserved = reserved->next;
-        memory::MemoryCap::update_deallocations(sizeof(*tsn) + tsn->size);
-        tcpStats.mem_in_use -= tsn->size;
-        snort_free(tsn);
-    }
-    reserve_sz = 0;
-#endif
+    delete slabs;
+    slabs = nullptr;
 }
 
 //-------------------------------------------------------------------------
@@ -72,24 +63,12 @@ void TcpSegmentNode::clear()
 TcpSegmentNode* TcpSegmentNode::create(
     const struct timeval& tv, const uint8_t* payload, uint16_t len)
 {
-    TcpSegmentNode* tsn;
+    assert(slabs);
+    TcpSegmentNode* tsn = (TcpSegmentNode*)slabs->allocate(offsetof(TcpSegmentNode, data) + len);
+
+    tsn->size = len;
+    tcpStats.mem_in_use += len;
 
-#ifdef USE_RESERVE
-    if ( reserved and len > res_min and len <= res_max )
-    {
-        tsn = reserved;
-        reserved = tsn->next;
-        --reserve_sz;
-    }
-    else
-#endif
-    {
-        size_t size = sizeof(*tsn) + len;
-        memory::MemoryCap::update_allocations(size);
-        tsn = (TcpSegmentNode*)snort_alloc(size);
-        tsn->size = len;
-        tcpStats.mem_in_use += len;
-    }
     tsn->tv = tv;
     tsn->i_len = tsn->c_len = len;
     memcpy(tsn->data, payload, len);
@@ -114,20 +93,8 @@ TcpSegmentNode* TcpSegmentNode::init(TcpSegmentNode& tns)
 
 void TcpSegmentNode::term()
 {
-#ifdef USE_RESERVE
-    if ( size == res_max and reserve_sz < num_res )
-    {
-        next = reserved;
-        reserved = this;
-        reserve_sz++;
-    }
-    else
-#endif
-    {
-        memory::MemoryCap::update_deallocations(sizeof(*this) + size);
-        tcpStats.mem_in_use -= size;
-        snort_free(this);
-    }
+    tcpStats.mem_in_use -= size;
+    memory::SlabAllocator::deallocate(this);
     tcpStats.segs_released++;
 }
 
@@ -31,7 +31,8 @@ class TcpSegmentDescriptor;
 // we make a lot of TcpSegments so it is organized by member
 // size/alignment requirements to minimize unused space
 // ... however, use of padding below is critical, adjust if needed
-// and we use the struct hack to avoid 2 allocs per node
+// and we use the struct hack to avoid 2 allocs per node.  nodes come from
+// a per thread slab allocator sized for common segment lengths.
 //-----------------------------------------------------------------
 
 class TcpSegmentNode
@@ -51,6 +51,7 @@
 #include "detection/detection_engine.h"
 #include "detection/rules.h"
 #include "log/log.h"
+#include "memory/memory_arena.h"
 #include "memory/memory_cap.h"
 #include "profiler/profiler.h"
 #include "protocols/eth.h"
@@ -88,12 +89,14 @@ TcpSession::TcpSession(Flow* f) : TcpStreamSession(f)
     tcpStats.instantiated++;
 
     memory::MemoryCap::update_allocations(sizeof(*this));
+    memory::MemoryArena::charge(memory::Arena::STREAM_TCP, sizeof(*this));
 }
 
 TcpSession::~TcpSession()
 {
     clear_session(true, false, false);
     memory::MemoryCap::update_deallocations(sizeof(*this));
+    memory::MemoryArena::credit(memory::Arena::STREAM_TCP, sizeof(*this));
 }
 
 bool TcpSession::setup(Packet*)
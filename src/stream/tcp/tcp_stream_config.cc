@@ -64,5 +64,6 @@ void TcpStreamConfig::show() const
     ConfigLogger::log_value("small_segments", str.c_str());
 
     ConfigLogger::log_flag("track_only", (flags & STREAM_CONFIG_NO_REASSEMBLY));
+    ConfigLogger::log_flag("zero_copy", (flags & STREAM_CONFIG_ZERO_COPY));
 }
 
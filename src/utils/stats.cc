@@ -187,6 +187,9 @@ const PegInfo pc_names[] =
 {
     { CountType::NOW, "analyzed", "total packets processed" },
     { CountType::SUM, "hard_evals", "non-fast pattern rule evaluations" },
+    { CountType::SUM, "option_memo_hits", "rule option evaluations skipped for a previous result" },
+    { CountType::SUM, "option_program_checks", "option trees compared with their flattened programs" },
+    { CountType::SUM, "option_program_mismatches", "flattened programs that did not match their option trees" },
     { CountType::SUM, "raw_searches", "fast pattern searches in raw packet data" },
     { CountType::SUM, "cooked_searches", "fast pattern searches in cooked packet data" },
     { CountType::SUM, "pkt_searches", "fast pattern searches in packet data" },
@@ -218,9 +221,18 @@ const PegInfo pc_names[] =
     { CountType::SUM, "offload_fallback", "fast pattern offload search fallback attempts" },
     { CountType::SUM, "offload_failures", "fast pattern offload search failures" },
     { CountType::SUM, "offload_suspends", "fast pattern search suspends due to offload context chains" },
+    { CountType::SUM, "offload_steals", "shared offload requests run by a thread other than the one queued to" },
+    { CountType::MAX, "offload_max_depth", "maximum number of requests queued to the shared offload threads" },
+    { CountType::SUM, "offload_usecs", "total microseconds from shared offload until results were ready" },
+    { CountType::MAX, "offload_max_usecs", "maximum microseconds from shared offload until results were ready" },
+    { CountType::SUM, "batch_searches", "fast pattern searches of batched packets" },
+    { CountType::SUM, "batched_packets", "packets searched in a batch" },
+    { CountType::SUM, "batch_timeouts", "batches searched before filling due to batch_timeout" },
     { CountType::SUM, "pcre_match_limit", "total number of times pcre hit the match limit" },
     { CountType::SUM, "pcre_recursion_limit", "total number of times pcre hit the recursion limit" },
     { CountType::SUM, "pcre_error", "total number of times pcre returns error" },
+    { CountType::SUM, "pcre_prefilter_scans", "buffers scanned with a pcre prefilter database" },
+    { CountType::SUM, "pcre_prefilter_skips", "pcre options skipped because the prefilter ruled out a match" },
     { CountType::END, nullptr, nullptr }
 };
 
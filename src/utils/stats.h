@@ -38,6 +38,9 @@ struct PacketCount
 {
     PegCount analyzed_pkts;
     PegCount hard_evals;
+    PegCount option_memo_hits;
+    PegCount option_program_checks;
+    PegCount option_program_mismatches;
     PegCount raw_searches;
     PegCount cooked_searches;
     PegCount pkt_searches;
@@ -69,9 +72,18 @@ struct PacketCount
     PegCount offload_fallback;
     PegCount offload_failures;
     PegCount offload_suspends;
+    PegCount offload_steals;
+    PegCount offload_max_depth;
+    PegCount offload_usecs;
+    PegCount offload_max_usecs;
+    PegCount batch_searches;
+    PegCount batched_packets;
+    PegCount batch_timeouts;
     PegCount pcre_match_limit;
     PegCount pcre_recursion_limit;
     PegCount pcre_error;
+    PegCount pcre_prefilter_scans;
+    PegCount pcre_prefilter_skips;
 };
 
 struct ProcessCount
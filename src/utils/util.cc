@@ -30,7 +30,8 @@
 #include <netdb.h>
 #include <openssl/crypto.h>
 #include <pcap.h>
-#include <pcre.h>
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
 #include <pwd.h>
 #include <sys/file.h>
 #include <sys/resource.h>
@@ -93,6 +94,9 @@ void StoreSnortInfoStrings()
 
 int DisplayBanner()
 {
+    char pcre2v[32];
+    pcre2_config(PCRE2_CONFIG_VERSION, pcre2v);
+
     const char* ljv = LUAJIT_VERSION;
     while ( *ljv && !isdigit(*ljv) )
         ++ljv;
@@ -113,7 +117,7 @@ int DisplayBanner()
     LogMessage("           Using LuaJIT version %s\n", ljv);
     LogMessage("           Using %s\n", SSLeay_version(SSLEAY_VERSION));
     LogMessage("           Using %s\n", pcap_lib_version());
-    LogMessage("           Using PCRE version %s\n", pcre_version());
+    LogMessage("           Using PCRE2 version %s\n", pcre2v);
     LogMessage("           Using ZLIB version %s\n", zlib_version);
 #ifdef HAVE_FLATBUFFERS
     LogMessage("           Using %s\n", flatbuffers::flatbuffer_version_string);